@@ -1,4 +1,10 @@
 ﻿#include "alpdb.h"
+#include "fare_kernel.h"
+#include "station_ch.h"
+#include "rule114.h"
+#include "core_area.h"
+#include "kana_utf8.h"
+#include "name_table.h"
 
 /*!	@file alpdb.cpp core logic implement.
  *	Copyright(c) sutezo9@me.com 2012.
@@ -39,6 +45,8 @@ Copyright (C) 2014 Sutezo (sutezo666@gmail.com)
 
 using namespace std;
 #include <vector>
+#include <list>
+#include <unordered_map>
 
 
 
@@ -61,24 +69,17 @@ DbidOf::DbidOf()
     /**** global variables *****/
 }
 
-int32_t DbidOf::id_of_station(tstring name) {
-    if (retrieve_id_pool.find(name) != retrieve_id_pool.end()) {
-        return retrieve_id_pool[name];
-    }
-    int id = RouteUtil::GetStationId(name.c_str());
-    retrieve_id_pool[name] = id;
-
-    return id;
+//	駅名→駅ID(STATION_ID())
+//	駅名と路線名は別の表で引くので同名でも衝突しない
+//
+int32_t DbidOf::id_of_station(string_view name) {
+    return NameTable::GetInstance().stationId(name);
 }
 
-int32_t DbidOf::id_of_line(tstring name) {
-    if (retrieve_id_pool.find(name) != retrieve_id_pool.end()) {
-        return retrieve_id_pool[name];
-    }
-    int id = RouteUtil::GetLineId(name.c_str());
-    retrieve_id_pool[name] = id;
-
-    return id;
+//	線名→線ID(LINE_ID())
+//
+int32_t DbidOf::id_of_line(string_view name) {
+    return NameTable::GetInstance().lineId(name);
 }
 
 ////////////////////////////////////////////
@@ -403,6 +404,7 @@ void CalcRoute::sync(const RouteList& route)
 void CalcRoute::sync(const RouteList& route, int count)
 {
     route_list_cooked.clear();
+    rule114Info.clear();
     RouteList::assign(route, count);
     TRACE("CalcRoute::sync() %d\n", route_flag.is_osakakan_1pass());
 }
@@ -500,8 +502,8 @@ DBO RouteUtil::Enum_station_match(LPCTSTR station)
 #endif
 	} else {
 		bool bKana;
-		if (isKanaString(stationName.c_str())) {
-			conv_to_kana2hira(stationName);
+		if (KanaUtf8::IsKana(stationName)) {
+			KanaUtf8::ToHiragana(stationName);
 			bKana = true;
 		} else {
 			bKana = false;
@@ -527,18 +529,7 @@ DBO RouteUtil::Enum_station_match(LPCTSTR station)
 //
 tstring RouteUtil::GetPrefectByStationId(int32_t stationId)
 {
-	static const char tsql[] =
-//"select p.name from t_prefect p left join t_station t on t.prefect_id=p.rowid where t.rowid=?";
-"select name from t_prefect where rowid=(select prefect_id from t_station where rowid=?)";
-//ここではどーでもいいけど、sqliteは結合遅くてサブクエリの方が早かったのでこうしてみた
-	DBO dbo = DBS::getInstance()->compileSql(tsql);
-	dbo.setParam(1, stationId);
-
-	if (dbo.moveNext()) {
-		return dbo.getText(0);
-	} else {
-		return _T("");
-	}
+	return tstring(NameTable::GetInstance().stationPrefectName(stationId));
 }
 
 
@@ -585,18 +576,7 @@ DBO RouteUtil::Enum_station_located_in_prefect_or_company_and_line(int32_t prefe
 //
 tstring RouteUtil::GetKanaFromStationId(int32_t stationId)
 {
-	static const  char tsql[] =
-"select kana from t_station where rowid=?";
-
-	DBO dbo = DBS::getInstance()->compileSql(tsql);
-
-	dbo.setParam(1, stationId);
-
-	if (dbo.moveNext()) {
-		return tstring(dbo.getText(0));
-	} else {
-		return tstring();
-	}
+	return tstring(NameTable::GetInstance().stationKana(stationId));
 }
 
 
@@ -2854,9 +2834,12 @@ tstring FARE_INFO::showFare(const RouteFlag& refRouteFlag)
     }
 
     /* 発駅→着駅 */
-    sResult = CalcRoute::BeginOrEndStationName(this->getBeginTerminalId());
+    const NameTable& names = NameTable::GetInstance();
+
+	sResult.reserve(MAX_BUF);
+    sResult += names.terminalName(this->getBeginTerminalId());
 	sResult += _T(" -> ");
-    sResult += CalcRoute::BeginOrEndStationName(this->getEndTerminalId());
+    sResult += names.terminalName(this->getEndTerminalId());
 
 	sResult += _T("\r\n経由：");
 	sResult += this->getRoute_string();
@@ -3184,13 +3167,183 @@ tstring     FARE_INFO::getRule114apply_terminal_station() const
 	return RouteUtil::StationName(rule114Info.stationId()).c_str(); 
 }
 
+//	calcFare()の運賃計算結果キャッシュ
+//
+class FareResult {
+public:
+	uint64_t hash;
+	uint64_t flags;					/* RouteFlag::fareKeyBits() */
+	int32_t tax;					/* FARE_INFO::getTax() */
+	uint32_t output_mask;			/* FARE_INFO::getOutputMask() */
+	vector<RouteItem> route_list;	/* route_list_raw */
+
+	/* 計算結果(calcFare()後のCalcRouteの状態を含む) */
+	int32_t rc;
+	FARE_INFO fare_info;
+	RouteFlag route_flag;
+	vector<RouteItem> route_list_cooked;
+	Rule114Info rule114Info;
+
+	FareResult(const vector<RouteItem>& route_list_raw, const RouteFlag& rRoute_flag, int32_t tax_, uint32_t output_mask_) :
+		tax(tax_), output_mask(output_mask_), route_list(route_list_raw) {
+		vector<RouteItem>::const_iterator ite;
+		flags = rRoute_flag.fareKeyBits();
+		hash = 14695981039346656037ull;		/* FNV-1a */
+		hash = (hash ^ flags) * 1099511628211ull;
+		hash = (hash ^ (uint32_t)tax) * 1099511628211ull;
+		hash = (hash ^ output_mask) * 1099511628211ull;
+		for (ite = route_list.cbegin(); ite != route_list.cend(); ite++) {
+			hash = (hash ^ ite->lineId) * 1099511628211ull;
+			hash = (hash ^ ite->stationId) * 1099511628211ull;
+			hash = (hash ^ ite->flag) * 1099511628211ull;
+		}
+		rc = 0;
+	}
+	bool isSameKey(const FareResult& key) const {
+		vector<RouteItem>::const_iterator ite1;
+		vector<RouteItem>::const_iterator ite2;
+
+		if ((hash != key.hash) || (flags != key.flags) || (tax != key.tax) || (output_mask != key.output_mask) || (route_list.size() != key.route_list.size())) {
+			return false;
+		}
+		for (ite1 = route_list.cbegin(), ite2 = key.route_list.cbegin(); ite1 != route_list.cend(); ite1++, ite2++) {
+			if ((ite1->lineId != ite2->lineId) || (ite1->stationId != ite2->stationId) || (ite1->flag != ite2->flag)) {
+				return false;
+			}
+		}
+		return true;
+	}
+};
+
+static list<FareResult> fare_result_cache;	/* 先頭が最新 */
+static unordered_map<uint64_t, list<FareResult>::iterator> fare_result_index;	/* hash -> fare_result_cache */
+static int32_t fare_result_capacity = 256;
+static int32_t fare_result_hit = 0;
+static int32_t fare_result_miss = 0;
+
+//static
+//	キャッシュ件数の上限(0でキャッシュしない)
+//
+void FareResultCache::setCapacity(int32_t capacity)
+{
+	fare_result_capacity = (capacity < 0) ? 0 : capacity;
+	while (fare_result_capacity < (int32_t)fare_result_cache.size()) {
+		fare_result_index.erase(fare_result_cache.back().hash);
+		fare_result_cache.pop_back();
+	}
+}
+
+int32_t FareResultCache::capacity()
+{
+	return fare_result_capacity;
+}
+
+int32_t FareResultCache::size()
+{
+	return (int32_t)fare_result_cache.size();
+}
+
+//static
+//	キャッシュと統計をクリア(DBを開き直した時)
+//
+void FareResultCache::clear()
+{
+	fare_result_cache.clear();
+	fare_result_index.clear();
+	fare_result_hit = 0;
+	fare_result_miss = 0;
+}
+
+int32_t FareResultCache::hitCount()
+{
+	return fare_result_hit;
+}
+
+int32_t FareResultCache::missCount()
+{
+	return fare_result_miss;
+}
+
+//	キャッシュから計算結果を得る(見つかれば最新にする)
+//
+static const FareResult* FareResultLookup(const FareResult& key)
+{
+	unordered_map<uint64_t, list<FareResult>::iterator>::const_iterator ite;
+
+	if (fare_result_capacity <= 0) {
+		return NULL;
+	}
+	ite = fare_result_index.find(key.hash);
+	if ((ite != fare_result_index.cend()) && ite->second->isSameKey(key)) {
+		fare_result_cache.splice(fare_result_cache.begin(), fare_result_cache, ite->second);
+		fare_result_hit++;
+		return &fare_result_cache.front();
+	}
+	fare_result_miss++;
+	return NULL;
+}
+
+//	計算結果をキャッシュに登録(上限を超えたら最も古いものを捨てる. ハッシュが衝突したら置き換える)
+//
+static FareResult* FareResultStore(const FareResult& key)
+{
+	unordered_map<uint64_t, list<FareResult>::iterator>::iterator ite;
+
+	if (fare_result_capacity <= 0) {
+		return NULL;
+	}
+	ite = fare_result_index.find(key.hash);
+	if (ite != fare_result_index.end()) {
+		fare_result_cache.erase(ite->second);
+		fare_result_index.erase(ite);
+	}
+	fare_result_cache.push_front(key);
+	fare_result_index[key.hash] = fare_result_cache.begin();
+	while (fare_result_capacity < (int32_t)fare_result_cache.size()) {
+		fare_result_index.erase(fare_result_cache.back().hash);
+		fare_result_cache.pop_back();
+	}
+	return &fare_result_cache.front();
+}
+
 /*  public
  *  運賃計算
+ *  同じ経路・フラグの計算結果はキャッシュから返す(FareResultCache)
  *  @retval 0 : empty root
  *  @retval -2 : 吉塚、西小倉における不完全ルート：この経路の片道乗車券は購入できません.
  *  @retval 1 : normal(Success)
  */
 int32_t CalcRoute::calcFare(FARE_INFO* pFi)
+{
+	FareResult key(route_list_raw, route_flag, pFi->getTax(), pFi->getOutputMask());
+	const FareResult* cached = FareResultLookup(key);
+	FareResult* entry;
+	int32_t rc;
+
+	if (cached != NULL) {
+		*pFi = cached->fare_info;
+		route_flag = cached->route_flag;
+		route_list_cooked = cached->route_list_cooked;
+		rule114Info = cached->rule114Info;
+		return cached->rc;
+	}
+	rc = calcFareNoCache(pFi);
+
+	entry = FareResultStore(key);
+	if (entry != NULL) {
+		entry->rc = rc;
+		entry->fare_info = *pFi;
+		entry->route_flag = route_flag;
+		entry->route_list_cooked = route_list_cooked;
+		entry->rule114Info = rule114Info;
+	}
+	return rc;
+}
+
+//	private
+//	運賃計算(キャッシュなし)
+//
+int32_t CalcRoute::calcFareNoCache(FARE_INFO* pFi)
 {
 	if (route_list_raw.size() <= 1) {
 		pFi->setEmpty();
@@ -3220,7 +3373,7 @@ ASSERT((BIT_CHK(fare_info.result_flag, BRF_COMAPANY_END) && route_flag.compnend)
     /* 86, 87, 69, 70条 114条適用かチェック */
     if (!route_flag.no_rule && !route_flag.osakakan_detour) {
         // これをここに置かないと86.87＋近郊でNG
-        checkOfRuleSpecificCoreLine(true);	// route_list_raw -> route_list_cooked
+        checkOfRuleSpecificCoreLine(pFi->isOutputRequested(FARE_OUT_FARES), pFi->getTax());	// route_list_raw -> route_list_cooked
     		/* 規則適用 */
         pFi->setTerminal(this->beginStationId(),
                               this->endStationId());    // set is begin/end terminal Id.
@@ -3236,7 +3389,7 @@ ASSERT((BIT_CHK(fare_info.result_flag, BRF_COMAPANY_END) && route_flag.compnend)
             if (b_more_low_cost) {
                 TRACE("changed fare for lowcost\n");
                 ; // DO NOTHING
-            } else {
+            } else if (pFi->isOutputRequested(FARE_OUT_FARES)) {
                 // rule 114 applied
                 pFi->setRule114(rule114Info);
             }
@@ -3419,35 +3572,18 @@ int32_t CalcRoute::endStationId()
 //
 tstring CalcRoute::BeginOrEndStationName(int32_t ident)
 {
-    if (ident < STATION_ID_AS_CITYNO) {
-        return RouteUtil::StationNameEx(ident);
-    } else {
-        return RouteUtil::CoreAreaCenterName(ident);
-    }
+    return tstring(NameTable::GetInstance().terminalName(ident));
 }
 
 //static
-//	駅ID→駅名
+//	都区市内Id→中心駅名
 //
 tstring RouteUtil::CoreAreaCenterName(int32_t id)
 {
-	TCHAR name[MAX_COREAREA_CHR];
-
-	memset(name, 0, sizeof(name));
-
-	DBO ctx = DBS::getInstance()->compileSql(
-        "select name from t_coreareac where rowid=?");
-	if (ctx.isvalid()) {
-        if (STATION_ID_AS_CITYNO <= id) {
-            id -= STATION_ID_AS_CITYNO;
-        }
-		ctx.setParam(1, id);
-
-		if (ctx.moveNext()) {
-			_tcscpy_s(name, NumOf(name), ctx.getText(0).c_str());
-		}
+	if (STATION_ID_AS_CITYNO <= id) {
+		id -= STATION_ID_AS_CITYNO;
 	}
-	return name;
+	return tstring(NameTable::GetInstance().coreAreaCenterName(id));
 }
 
 
@@ -3653,35 +3789,45 @@ ASSERT((rc == 0) || (rc == 1) || (rc == 10) || (rc == 11) || (rc == 4));
 //
 tstring RouteUtil::Show_route(const vector<RouteItem>& routeList, const RouteFlag& rRoute_flag)
 {
-	tstring lineName;
-	tstring stationName;
-#define MAX_BUF 1024
-	//TCHAR buf[MAX_BUF];
 	tstring result_str;
-	int32_t station_id1;
-    RouteFlag routeFlag_ = rRoute_flag;
 
 	if (routeList.size() == 0) {	/* 経路なし(AutoRoute) */
 		return _T("");
 	}
+	result_str.reserve(routeList.size() * 32);
+	Append_route(result_str, routeList, rRoute_flag);
+	return result_str;
+}
+
+//static private
+//	@brief 経由文字列を追加する(Show_route(), Show_route_full())
+//	路線名・駅名は NameTable の string_view を直接追加する
+//
+//	@param [out] result_str   出力文字列(末尾に追加)
+//	@param [in]  routeList    route(空でないこと)
+//	@param [in]  route_flag    route flag(LF_OSAKAKAN_MASK:大阪環状線関連フラグのみ).
+//
+void RouteUtil::Append_route(tstring& result_str, const vector<RouteItem>& routeList, const RouteFlag& rRoute_flag)
+{
+	const NameTable& names = NameTable::GetInstance();
+	int32_t osakakan_line_id = LINE_ID(_T("大阪環状線"));
+	int32_t station_id1;
+    RouteFlag routeFlag_ = rRoute_flag;
 
 	vector<RouteItem>::const_iterator pos = routeList.cbegin();
 
-	result_str = _T("");
 	station_id1 = pos->stationId;
     routeFlag_.setOsakaKanFlag(RouteFlag::OSAKAKAN_NOPASS);
 
 	for (pos++; pos != routeList.cend() ; pos++) {
 
-		lineName = RouteUtil::LineName(pos->lineId);
-
 		if ((pos + 1) != routeList.cend()) {
 			/* 中間駅 */
 			if (!IS_FLG_HIDE_LINE(pos->flag)) {
 				if (ID_L_RULE70 != pos->lineId) {
 					result_str += _T("[");
-					result_str += lineName;
-					if (LINE_ID(_T("大阪環状線")) == pos->lineId) {
+					result_str += names.lineName(pos->lineId);
+					if (osakakan_line_id == pos->lineId) {
 						result_str += RouteOsakaKanDir(station_id1, pos->stationId, routeFlag_);
                         routeFlag_.setOsakaKanPass(true);
 					}
@@ -3692,25 +3838,21 @@ tstring RouteUtil::Show_route(const vector<RouteItem>& routeList, const RouteFla
 			}
 			station_id1 = pos->stationId;
 			if (!IS_FLG_HIDE_STATION(pos->flag)) {
-				stationName = RouteUtil::StationName(station_id1);
-				result_str += stationName;
+				result_str += names.stationName(station_id1);
 			}
 		} else {
 			/* 着駅 */
 			if (!IS_FLG_HIDE_LINE(pos->flag)) {
 				result_str += _T("[");
-				result_str += lineName;
-				if (LINE_ID(_T("大阪環状線")) == pos->lineId) {
+				result_str += names.lineName(pos->lineId);
+				if (osakakan_line_id == pos->lineId) {
 					result_str += RouteOsakaKanDir(station_id1, pos->stationId, routeFlag_);
 					routeFlag_.setOsakaKanPass(true);
 				}
 				result_str += _T("]");
 			}
-			//result_str += stationName;	// 着駅
 		}
-		//result_str += buf;
 	}
-	return result_str;
 }
 
 // static version
@@ -3722,13 +3864,17 @@ tstring RouteUtil::Show_route(const vector<RouteItem>& routeList, const RouteFla
 //
 tstring RouteUtil::Show_route_full(const vector<RouteItem>& routeList, const RouteFlag& rRoute_flag)
 {
+	const NameTable& names = NameTable::GetInstance();
+	tstring result_str;
+
 	if (routeList.size() == 0) {	/* 経路なし(AutoRoute) */
 		return _T("");
 	}
-	tstring startStationName = RouteUtil::StationName(routeList.front().stationId);
-	tstring route_str = RouteUtil::Show_route(routeList, rRoute_flag);
-	tstring arriveStationName = RouteUtil::StationName(routeList.back().stationId);
-	return startStationName + route_str + arriveStationName;
+	result_str.reserve(routeList.size() * 32 + 32);
+	result_str += names.stationName(routeList.front().stationId);
+	Append_route(result_str, routeList, rRoute_flag);
+	result_str += names.stationName(routeList.back().stationId);
+	return result_str;
 }
 
 
@@ -3740,9 +3886,8 @@ tstring RouteUtil::Show_route_full(const vector<RouteItem>& routeList, const Rou
 //	@param [in] route_flag    route flag.
 //	@retval 文字列
 //
-tstring  RouteUtil::RouteOsakaKanDir(int32_t station_id1, int32_t station_id2, const RouteFlag& rRoute_flag)
+LPCTSTR  RouteUtil::RouteOsakaKanDir(int32_t station_id1, int32_t station_id2, const RouteFlag& rRoute_flag)
 {
-	tstring result_str;
 	const TCHAR * const result[] = {
 		_T(""),
 		_T("(内回り)"),
@@ -3832,6 +3977,7 @@ TRACE(_T("RouteOsakaKanDir:[%d] %s %s %s: %d %d %d %d\n"),
  */
 tstring RouteList::route_script()
 {
+	const NameTable& names = NameTable::GetInstance();
 	const vector<RouteItem>* routeList;
 	tstring result_str;
 	bool oskk_flag;
@@ -3849,7 +3995,8 @@ tstring RouteList::route_script()
 	} else {
 		result_str = _T("");
 	}
-	result_str += RouteUtil::StationNameEx(pos->stationId);
+	result_str.reserve(result_str.size() + routeList->size() * 40);
+	result_str += names.stationNameEx(pos->stationId);
 
 	oskk_flag = false;
 	for (pos++; pos != routeList->cend() ; pos++) {
@@ -3860,9 +4007,9 @@ tstring RouteList::route_script()
 			}
 			oskk_flag = true;
 		}
-		result_str += RouteUtil::LineName(pos->lineId);
+		result_str += names.lineName(pos->lineId);
 		result_str += _T(",");
-		result_str += RouteUtil::StationNameEx(pos->stationId);
+		result_str += names.stationNameEx(pos->stationId);
 	}
 //	result_str += _T("\n\n");
 	return result_str;
@@ -4139,21 +4286,7 @@ int32_t Route::Id2jctId(int32_t stationId)
 //
 tstring Route::JctName(int32_t jctId)
 {
-	TCHAR name[MAX_STATION_CHR];
-
-	memset(name, 0, sizeof(name));
-
-	DBO ctx = DBS::getInstance()->compileSql(
-		"select name from t_jct j left join t_station t on j.station_id=t.rowid where id=?");
-	if (ctx.isvalid()) {
-
-		ctx.setParam(1, jctId);
-
-		if (ctx.moveNext()) {
-			_tcscpy_s(name, MAX_STATION_CHR, ctx.getText(0).c_str());
-		}
-	}
-	return name;
+	return tstring(NameTable::GetInstance().jctName(jctId));
 }
 
 //static
@@ -4161,21 +4294,7 @@ tstring Route::JctName(int32_t jctId)
 //
 tstring RouteUtil::StationName(int32_t id)
 {
-	TCHAR name[MAX_STATION_CHR];
-
-	memset(name, 0, sizeof(name));
-
-	DBO ctx = DBS::getInstance()->compileSql(
-		"select name from t_station where rowid=?");
-	if (ctx.isvalid()) {
-
-		ctx.setParam(1, id);
-
-		if (ctx.moveNext()) {
-			_tcscpy_s(name, NumOf(name), ctx.getText(0).c_str());
-		}
-	}
-	return name;
+	return tstring(NameTable::GetInstance().stationName(id));
 }
 
 //static
@@ -4183,22 +4302,7 @@ tstring RouteUtil::StationName(int32_t id)
 //
 tstring RouteUtil::StationNameEx(int32_t id)
 {
-	TCHAR name[MAX_STATION_CHR];
-
-	memset(name, 0, sizeof(name));
-
-	DBO ctx = DBS::getInstance()->compileSql(
-		"select name,samename from t_station where rowid=?");
-	if (ctx.isvalid()) {
-
-		ctx.setParam(1, id);
-
-		if (ctx.moveNext()) {
-			_tcscpy_s(name, NumOf(name), ctx.getText(0).c_str());
-			_tcscat_s(name, NumOf(name), ctx.getText(1).c_str());
-		}
-	}
-	return name;
+	return tstring(NameTable::GetInstance().stationNameEx(id));
 }
 
 //static
@@ -4206,21 +4310,7 @@ tstring RouteUtil::StationNameEx(int32_t id)
 //
 tstring RouteUtil::LineName(int32_t id)
 {
-	TCHAR name[MAX_STATION_CHR];
-
-	memset(name, 0, sizeof(name));
-
-	DBO ctx = DBS::getInstance()->compileSql(
-		"select name from t_line where rowid=?");
-	if (ctx.isvalid()) {
-
-		ctx.setParam(1, id);
-
-		if (ctx.moveNext()) {
-			_tcscpy_s(name, NumOf(name), ctx.getText(0).c_str());
-		}
-	}
-	return name;
+	return tstring(NameTable::GetInstance().lineName(id));
 }
 
 
@@ -4229,17 +4319,7 @@ tstring RouteUtil::LineName(int32_t id)
 //
 SPECIFICFLAG RouteUtil::AttrOfStationId(int32_t id)
 {
-	DBO ctx = DBS::getInstance()->compileSql(
-		"select sflg from t_station where rowid=?");
-	if (ctx.isvalid()) {
-
-		ctx.setParam(1, id);
-
-		if (ctx.moveNext()) {
-			return ctx.getInt(0);
-		}
-	}
-	return (1<<30);
+	return CoreAreaIndex::GetInstance().attrOfStation(id);
 }
 
 //static
@@ -4345,26 +4425,8 @@ int32_t Route::LineIdFromStationId2(int32_t station_id1, int32_t station_id2)
 //
 int32_t RouteUtil::GetStationId(LPCTSTR station)
 {
-	const char tsql[] = "select rowid from t_station where (sflg&(1<<18))=0 and name=?1 and samename=?2";
-
-	tstring sameName;
-	tstring stationName(station);
-
-	int32_t pos = (int32_t)stationName.find(_T('('));
-	if (0 <= pos) {
-		sameName = stationName.substr(pos);
-		stationName = stationName.substr(0, pos);
-	}
-
-	DBO dbo = DBS::getInstance()->compileSql(tsql);
-	if (dbo.isvalid()) {
-		dbo.setParam(1, stationName.c_str());
-		dbo.setParam(2, sameName.c_str());
-		if (dbo.moveNext()) {
-			return dbo.getInt(0);
-		}
-	}
-	return 0;
+	/* "駅名(同名駅区別)" をそのまま引く(DBの name=?1 and samename=?2 と同じ) */
+	return NameTable::GetInstance().stationId(station);
 }
 
 // 線名より線IDを返す
@@ -4373,16 +4435,7 @@ int32_t RouteUtil::GetStationId(LPCTSTR station)
 //
 int32_t RouteUtil::GetLineId(LPCTSTR lineName)
 {
-	const char tsql[] = "select rowid from t_line where name=?";
-
-	DBO dbo = DBS::getInstance()->compileSql(tsql);
-	if (dbo.isvalid()) {
-		dbo.setParam(1, lineName);
-		if (dbo.moveNext()) {
-			return dbo.getInt(0);
-		}
-	}
-	return 0;
+	return NameTable::GetInstance().lineId(lineName);
 }
 
 //static
@@ -4390,24 +4443,10 @@ int32_t RouteUtil::GetLineId(LPCTSTR lineName)
 //
 tstring RouteUtil::PrefectName(int32_t id)
 {
-	TCHAR name[MAX_PREFECT_CHR];
-
-	memset(name, 0, sizeof(name));
-
-	DBO ctx = DBS::getInstance()->compileSql(
-                                             "select name from t_prefect where rowid=?");
-	if (ctx.isvalid()) {
-
-        if (0x10000 <= id) {
-            id = (unsigned)id >> 16;
-        }
-		ctx.setParam(1, id);
-
-		if (ctx.moveNext()) {
-			_tcscpy_s(name, NumOf(name), ctx.getText(0).c_str());
-		}
+	if (0x10000 <= id) {
+		id = (unsigned)id >> 16;
 	}
-	return name;
+	return tstring(NameTable::GetInstance().prefectName(id));
 }
 
 //static
@@ -4415,20 +4454,7 @@ tstring RouteUtil::PrefectName(int32_t id)
 //
 tstring RouteUtil::CompanyName(int32_t id)
 {
-	TCHAR name[MAX_PREFECT_CHR];
-
-	memset(name, 0, sizeof(name));
-
-	DBO ctx = DBS::getInstance()->compileSql(
-                                             "select name from t_company where rowid=?");
-	if (ctx.isvalid()) {
-        ctx.setParam(1, id);
-
-		if (ctx.moveNext()) {
-			_tcscpy_s(name, NumOf(name), ctx.getText(0).c_str());
-		}
-	}
-	return name;
+	return tstring(NameTable::GetInstance().companyName(id));
 }
 
 //static
@@ -5337,36 +5363,7 @@ int32_t CalcRoute::RemoveDupRoute(vector<RouteItem> *routeList)
 //
 int32_t CalcRoute::InCityStation(int32_t cityno, int32_t lineId, int32_t stationId1, int32_t stationId2)
 {
-	static const char tsql[] =
-"select count(*)"
-"	from t_lines"
-"	where line_id=?1"
-"	and (lflg&(1<<31))=0"
-"	and exists (select * from t_station where rowid=station_id and (sflg&15)=?4)"
-"	and sales_km>="
-"			(select min(sales_km)"
-"			from t_lines"
-"			where line_id=?1"
-"			and (station_id=?2 or"
-"				 station_id=?3))"
-"	and sales_km<="
-"			(select max(sales_km)"
-"			from t_lines"
-"			where line_id=?1"
-"			and (station_id=?2 or "
-"				 station_id=?3))";
-	DBO dbo = DBS::getInstance()->compileSql(tsql);
-	if (dbo.isvalid()) {
-		dbo.setParam(1, lineId);
-		dbo.setParam(2, stationId1);
-		dbo.setParam(3, stationId2);
-		dbo.setParam(4, cityno & 0x0f);
-
-		if (dbo.moveNext()) {
-			return dbo.getInt(0);
-		}
-	}
-	return 0;
+	return CoreAreaIndex::GetInstance().countInCity(cityno, lineId, stationId1, stationId2);
 }
 
 
@@ -5683,25 +5680,7 @@ uint32_t CalcRoute::CheckOfRule87(const vector<RouteItem>& in_route_list)
 //
 vector<Station> CalcRoute::SpecificCoreAreaFirstTransferStationBy(int32_t lineId, int32_t cityId)
 {
-	const static char tsql[] =
-"select station_id, line_id2 from t_rule86 where"
-" line_id1=?1 and (city_id & 255)=?2 order by city_id";
-
-	int32_t station_id;
-	int32_t line_id;
-	vector<Station> firstTransferStation;
-
-	DBO dbo = DBS::getInstance()->compileSql(tsql);
-	if (dbo.isvalid()) {
-		dbo.setParam(1, lineId);
-		dbo.setParam(2, cityId);
-		while (dbo.moveNext()) {
-			station_id = dbo.getInt(0);
-			line_id = dbo.getInt(1);
-			firstTransferStation.push_back(Station(line_id, station_id));
-		}
-	}
-	return firstTransferStation;
+	return CoreAreaIndex::GetInstance().firstTransferStations(lineId, cityId);
 }
 
 
@@ -5715,21 +5694,7 @@ vector<Station> CalcRoute::SpecificCoreAreaFirstTransferStationBy(int32_t lineId
 //
 int32_t CalcRoute::Retrieve_SpecificCoreStation(int32_t cityId)
 {
-	int32_t stationId;
-
-	const static char tsql[] =
-"select rowid from t_station where"
-" (sflg & (1 << 4))!=0 and (sflg & 15)=?1";
-
-	DBO dbo = DBS::getInstance()->compileSql(tsql);
-	if (dbo.isvalid()) {
-		dbo.setParam(1, cityId);
-		if (dbo.moveNext()) {
-			stationId = dbo.getInt(0);
-			return stationId;
-		}
-	}
-	return 0;
+	return CoreAreaIndex::GetInstance().coreStation(cityId);
 }
 
 //	Route 営業キロを計算
@@ -5989,13 +5954,14 @@ void CalcRoute::checkIsJRTokaiOnly()
 //	後半でBLF_TER_xxx(route[0].lineId)を設定します
 //
 //	@param [in]  route_flag   BLF_MEIHANCITYFLAG = 発駅:着駅 無効(0)/有効(1)
+//	@param [in]  tax          114条判定の運賃計算に使う消費税率(%)
 //	@param [out] rule114	 [0] = 運賃, [1] = 営業キロ, [2] = 計算キロ
 //	@return false : rule 114 no applied. true: rule 114 applied(available for rule114[] )
 //	@remark ルール未適用時はroute_list_cooked = route_list_rawである
 //
 #define RULE114_SALES_KM_86	1700
 #define RULE114_SALES_KM_87	800
-void CalcRoute::checkOfRuleSpecificCoreLine(bool isCheckRule114 /* =false */)
+void CalcRoute::checkOfRuleSpecificCoreLine(bool isCheckRule114 /* =false */, int32_t tax /* =TAX */)
 {
 	PAIRIDENT cityId;
 	int32_t jsales_km;
@@ -6348,7 +6314,7 @@ void CalcRoute::checkOfRuleSpecificCoreLine(bool isCheckRule114 /* =false */)
 
 	if (isCheckRule114 && (sk <= jsales_km)) {
 			/* 114条適用かチェック */
-		CalcRoute::CRule114 rule114;
+		CalcRoute::CRule114 rule114(tax);
 		if (rule114.check(route_flag, chk, sk, route_list_tmp2, route_list_tmp4, cityId, enter, exit)) {
 			rule114Info.set(Rule114Info(rule114.fare, rule114.apply_terminal_station));
 		}
@@ -6682,8 +6648,9 @@ int32_t FARE_INFO::CheckOfRule89j(const vector<RouteItem>& route)
 	}
 }
 
-CalcRoute::CRule114::CRule114()
+CalcRoute::CRule114::CRule114(int32_t tax_ /* =TAX */)
 {
+	tax = tax_;
 	normal_fare = 0;
 }
 
@@ -7080,8 +7047,7 @@ bool CalcRoute::CRule114::checkOfRule114j(int32_t kind)
 	/* 中心駅から目的地方向に最初に200(100)kmに到達する駅を得る */
 	/* 富士から身延線で甲府方向に */
 	route_list_replace.clear();
-	collectCheckedJunction.clear();
-	deep_count = 0;
+	checkedJunction.assign(Rule114Index::GetInstance().maxStationId() + 1, false);
 	/* (86, 87条適用前されなかった)運賃その駅までの運賃より高ければ、その駅までの運賃とする */
 	get86or87firstPoint(km, aSales_km, line_id, station_id1);
 	if (fare.fare != 0) {
@@ -7102,7 +7068,7 @@ bool CalcRoute::CRule114::checkOfRule114j(int32_t kind)
 //
 void CalcRoute::CRule114::judgementOfFare(int32_t arrive_station_id, int32_t base_line_id, int32_t base_station_id)
 {
-	FARE_INFO fi;
+	FARE_INFO fi(tax);
 	int32_t fare_applied;
 	
 	RouteFlag rRoute_flag_ref;
@@ -7196,34 +7162,10 @@ void CalcRoute::CRule114::judgementOfFare(int32_t arrive_station_id, int32_t bas
 	}
 }
 
-//	駅の所属する路線一覧を返す（新幹線除く）
-//
-vector<int32_t> CalcRoute::CRule114::ArrayOfLinesOfStationId(int32_t junction_station_id)
-{
-	vector<int32_t> results;
-
-	DBO lines = RouteUtil::Enum_line_of_stationId(junction_station_id);
-
-	if (lines.isvalid()) {
-		while (lines.moveNext()) {
-			int lflg = lines.getInt(2);
-			if (((1<<31) & lflg) == 0) {
-				int line_id = lines.getInt(1);
-				if (!IS_SHINKANSEN_LINE(line_id) && !IS_COMPANY_LINE(line_id)
-				   && !IS_BRT_LINE(line_id)) {
-					results.push_back(line_id);
-				}
-			}
-		}
-	} else {
-		TRACE("Could execute query Enum_line_of_stationId()\n");
-		ASSERT(FALSE);
-	}
-	return results;	
-}
-
 //	指定路線・駅からの101/201km到達地点の駅を得る
 //	checkOfRule114j() =>
+//	分岐駅ごとに分かれる路線の上り・下りを深さ優先でたどる. 探索順(=同額時に採る到達駅)は
+//	分岐駅ごとに再帰呼出ししていた時と同じ.
 //
 //	@param [in] cond_km  下り: 100=1000, 200=2000(上り: -1000 / -2000)
 //	@param [in] base_sales_km     都区市内駅からみて最後の路線の起点駅までの営業キロ
@@ -7235,11 +7177,56 @@ vector<int32_t> CalcRoute::CRule114::ArrayOfLinesOfStationId(int32_t junction_st
 //
 void CalcRoute::CRule114::get86or87firstPoint(int32_t cond_km, uint32_t base_sales_km, uint32_t base_line_id, uint32_t base_station_id)
 {
-	vector<IntPair> junctions;
+	vector<SearchFrame> stack;
+
+	enterSearchFrame(stack, cond_km, base_sales_km, base_line_id, base_station_id);
+
+	while (!stack.empty()) {
+		SearchFrame& frame = stack.back();
+
+		if (frame.step == 1) {
+			/* cond_km方向を探索し終えた. 同じ路線を逆方向へ */
+			int32_t jct_line_id = frame.lines->at(frame.line_index);
+			const IntPair& jct = frame.junctions[frame.junction_index];
+
+			frame.step = 2;
+			enterSearchFrame(stack, -frame.cond_km, jct.one + frame.base_sales_km, jct_line_id, jct.two);
+			continue;
+		}
+		if (frame.step == 2) {
+			route_list_replace.pop_back();
+			frame.step = 0;
+			frame.line_index++;
+		}
+		if (nextSearchLine(frame)) {
+			int32_t jct_line_id = frame.lines->at(frame.line_index);
+			const IntPair& jct = frame.junctions[frame.junction_index];
+
+			TRACE(_T("found junction:%s(%s)\n"), LNAME(jct_line_id), SNAME(jct.two));
+			route_list_replace.push_back(RouteItem(frame.base_line_id, frame.base_station_id)); // 1st station will not used.
+			frame.step = 1;
+			enterSearchFrame(stack, frame.cond_km, jct.one + frame.base_sales_km, jct_line_id, jct.two);
+		} else {
+			stack.pop_back();
+		}
+	}
+}
+
+//	探索スタックに1段積む(到達駅があれば運賃を比較し、100/200kmまでの分岐駅を列挙する)
+//	get86or87firstPoint() =>
+//
+//	@param [in/out] stack        探索スタック
+//	@param [in] cond_km          下り: 100=1000, 200=2000(上り: -1000 / -2000)
+//	@param [in] base_sales_km    中心駅から起点駅までの営業キロ
+//	@param [in] base_line_id     路線
+//	@param [in] base_station_id  起点駅
+//
+void CalcRoute::CRule114::enterSearchFrame(vector<SearchFrame>& stack, int32_t cond_km, int32_t base_sales_km, int32_t base_line_id, int32_t base_station_id)
+{
+	SearchFrame frame(cond_km, base_sales_km, base_line_id, base_station_id);
+
+	TRACE(_T("[get86or87firstPoint]: dept%d: cond_km=%d, base km=%d, %s %s @@@\n"), (int)stack.size() + 1, cond_km, base_sales_km, LNAME(base_line_id), SNAME(base_station_id));
 
-	deep_count++;
-	TRACE(_T("[get86or87firstPoint]: dept%d: cond_km=%d, base km=%d, %s %s @@@\n"), deep_count, cond_km, base_sales_km, LNAME(base_line_id), SNAME(base_station_id));
-	
 	int32_t arrive8687_station_id = retreive_SpecificCoreAvailablePoint(cond_km, base_sales_km, base_line_id, base_station_id);
   	if (0 != arrive8687_station_id) {  // with junction もあり得るのでelseにしていない
 		// 運賃計算して比較する
@@ -7249,7 +7236,7 @@ void CalcRoute::CRule114::get86or87firstPoint(int32_t cond_km, uint32_t base_sal
   	}
 	// 100/200km までの分岐駅一覧
 #if !defined C114NOFASTJUNCCHEK
-	if (deep_count == 1) {
+	if (stack.empty()) {
 		// 井原市 芸備線 広島 山陽線 幡生
 		// enumJunctionRange start:山陽線-櫛ケ浜 cond_km=2000, base_salles_km=851(広島〜櫛ケ浜)
 		// 幡生から先200
@@ -7266,42 +7253,59 @@ void CalcRoute::CRule114::get86or87firstPoint(int32_t cond_km, uint32_t base_sal
 			TRACE(_T("  terminal was junction. sales_km_special:%d from:%s\n"), sales_km_special, SNAME(arrive_station_id));
 
 			IntPair v(sales_km_special, arrive_station_id);
-			junctions.push_back(v);
-			base_sales_km = 0;
+			frame.junctions.push_back(v);
+			frame.base_sales_km = 0;
 		} else {
 			TRACE(_T("  terminal was non-junction. sales_km_special:%d from:%s\n"), sales_km_special, SNAME(arrive_station_id));
-			junctions = enumJunctionRange(cond_km, sales_km_special, base_line_id, arrive_station_id);
-			base_sales_km = sales_km_special;
+			frame.junctions = enumJunctionRange(cond_km, sales_km_special, base_line_id, arrive_station_id);
+			frame.base_sales_km = sales_km_special;
 		}
 	  //       幡生から(2000-1982=18)kmまでの分岐駅
 	} else {
 #endif
-		junctions = enumJunctionRange(cond_km, base_sales_km, base_line_id, base_station_id);
+		frame.junctions = enumJunctionRange(cond_km, base_sales_km, base_line_id, base_station_id);
 #if !defined C114NOFASTJUNCCHEK
 	}
 #endif
-	for (vector<IntPair>::const_iterator jct_ite = junctions.cbegin(); jct_ite != junctions.cend(); jct_ite++) {
-		int32_t offset_sales_km = jct_ite->one + base_sales_km;
-		int32_t last_station_id = jct_ite->two;
-		TRACE(_T("Enum_line_of_stationId start %s from %s-%s:\n"), SNAME(last_station_id), LNAME(base_line_id), SNAME(base_station_id));
-		if (collectCheckedJunction.find(last_station_id) == collectCheckedJunction.end()) {
-			collectCheckedJunction[last_station_id] = last_station_id;
-			// 分岐駅から分かれる路線一覧
-			// DBO lines = RouteUtil::Enum_line_of_stationId(last_station_id);
-			vector<int32_t> lines = ArrayOfLinesOfStationId(last_station_id);
-			for (vector<int32_t>::const_iterator ite = lines.cbegin(); ite != lines.cend(); ite++ ) {
-				int32_t jct_line_id = *ite;
-				TRACE(_T("found junction:%s(%s)\n"), LNAME(jct_line_id), SNAME(last_station_id));
-				if (base_line_id != jct_line_id) {
-					route_list_replace.push_back(RouteItem(base_line_id, base_station_id)); // 1st station will not used.
-					get86or87firstPoint(cond_km, offset_sales_km, jct_line_id, last_station_id);
-					get86or87firstPoint(-cond_km, offset_sales_km, jct_line_id, last_station_id);
-					route_list_replace.pop_back();
+	stack.push_back(std::move(frame));
+}
+
+//	次にたどる(分岐駅, 路線)に進める
+//	get86or87firstPoint() =>
+//	分岐駅は探索全体で1度だけ(初回到達時に探索済みにする)、路線はframeの路線を除く
+//
+//	@param [in/out] frame  探索スタックの段
+//	@retval true  frame.junction_index, frame.line_index が次にたどる分岐駅・路線
+//	@retval false 分岐駅がもうない
+//
+bool CalcRoute::CRule114::nextSearchLine(SearchFrame& frame)
+{
+	for (;;) {
+		if (frame.lines != nullptr) {
+			for (; frame.line_index < frame.lines->size(); frame.line_index++) {
+				if (frame.base_line_id != frame.lines->at(frame.line_index)) {
+					return true;
 				}
 			}
+			frame.lines = nullptr;
+			frame.junction_index++;
+		}
+		for (; frame.junction_index < frame.junctions.size(); frame.junction_index++) {
+			int32_t last_station_id = frame.junctions[frame.junction_index].two;
+			TRACE(_T("Enum_line_of_stationId start %s from %s-%s:\n"), SNAME(last_station_id), LNAME(frame.base_line_id), SNAME(frame.base_station_id));
+			if ((0 <= last_station_id) && ((size_t)last_station_id < checkedJunction.size()) &&
+				!checkedJunction[last_station_id]) {
+				checkedJunction[last_station_id] = true;
+				break;
+			}
+		}
+		if (frame.junctions.size() <= frame.junction_index) {
+			return false;
 		}
+		// 分岐駅から分かれる路線一覧
+		frame.lines = &Rule114Index::GetInstance().linesOfStation(frame.junctions[frame.junction_index].two);
+		frame.line_index = 0;
 	}
-	deep_count--;
 }
 
 //	指定路線・駅から、指定方面へ100/200kmまでの分岐駅を得る
@@ -7309,49 +7313,13 @@ void CalcRoute::CRule114::get86or87firstPoint(int32_t cond_km, uint32_t base_sal
 //	@param [in] base_sales_km 86,87条中心駅からの指定駅までの営業キロ
 //	@param [in] base_line_id 指定路線
 //	@param [in] base_station_id 指定駅
-//	@retval DBO(0:int(指定駅からの営業キロ), 1:int(分岐駅))
+//	@retval [](one:指定駅からの営業キロ, two:分岐駅)
 //
 vector<IntPair> CalcRoute::CRule114::enumJunctionRange(int32_t cond_km, int32_t base_sales_km, int32_t base_line_id, int32_t base_station_id)
 {
-	// 上り方向
-	static const char tsql_desc[] =
-"select l1.sales_km-l2.sales_km, l2.station_id from t_lines l1 left join t_lines l2 on l1.line_id=l2.line_id"
-" left join t_station t on t.rowid=l2.station_id "
-"where l1.line_id=?1 and l1.station_id=?2 and l1.sales_km>l2.sales_km and (l1.sales_km-%u)<=l2.sales_km"
-" and (l2.lflg&(1<<17))=0 and (l2.lflg&(1<<31))=0 and (l2.lflg&(1<<15))!=0 and (sflg&(1<<12))!=0"
-" order by l2.sales_km desc";
-
-	// 下り方向
-	static const char tsql_asc[] =
-"select l2.sales_km-l1.sales_km, l2.station_id from t_lines l1 left join t_lines l2 on l1.line_id=l2.line_id"
-" left join t_station t on t.rowid=l2.station_id "
-"where l1.line_id=?1 and l1.station_id=?2 and l1.sales_km<l2.sales_km and (l1.sales_km+%u)>=l2.sales_km"
-" and (l2.lflg&(1<<17))=0 and (l2.lflg&(1<<31))=0 and (l2.lflg&(1<<15))!=0 and (sflg&(1<<12))!=0"
-" order by l2.sales_km";
-
-	char sql_buf[512];
-	vector<IntPair> result;
-
-	if (cond_km < 0) {
-		/* 上り */
-		sqlite3_snprintf(sizeof(sql_buf), sql_buf, tsql_desc, -cond_km - base_sales_km);
-	} else {		/* 下り */
-		sqlite3_snprintf(sizeof(sql_buf), sql_buf, tsql_asc, cond_km - base_sales_km);
-	}
 	TRACE(_T("enumJunctionRange start:%s-%s cond_km=%d, base_salles_km=%d\n"), LNAME(base_line_id), SNAME(base_station_id), cond_km, base_sales_km);
 
-	DBO dbo = DBS::getInstance()->compileSql(sql_buf);
-	dbo.setParam(1, base_line_id);
-	dbo.setParam(2, base_station_id);
-
-	while (dbo.moveNext()) {
-		IntPair value;
-		value.one = dbo.getInt(0);
-		value.two = dbo.getInt(1);
-		TRACE(_T("enumJunctionRange found %d %s\n"), value.one, SNAME(value.two));
-		result.push_back(value);
-	}
-	return result;
+	return Rule114Index::GetInstance().junctionRange(cond_km, base_sales_km, base_line_id, base_station_id);
 }
 
 //	指定路線・駅からの100/200km到達地点の駅を得る
@@ -7364,39 +7332,9 @@ vector<IntPair> CalcRoute::CRule114::enumJunctionRange(int32_t cond_km, int32_t
 //
 int32_t CalcRoute::CRule114::retreive_SpecificCoreAvailablePoint(int32_t cond_km, int32_t km_offset, int32_t line_id, int32_t station_id)
 {
-	// 上り方向で200km到達地点
-	static const char tsql_desc[] =
-	"select station_id from t_lines where line_id=?1 and (lflg&(1<<17))=0 and (lflg&(1<<31))=0 and sales_km<"
-	"(select sales_km-%u from t_lines where line_id=?1 and station_id=?2) order by sales_km desc limit 1";
-
-	// 下り方向で200km到達地点
-	static const char tsql_asc[] =
-	"select station_id from t_lines where line_id=?1 and (lflg&(1<<17))=0 and (lflg&(1<<31))=0 and sales_km>"
-	"(select sales_km+%u from t_lines where line_id=?1 and station_id=?2) order by sales_km limit(1)";
-
-	char sql_buf[512];
-
-	if (cond_km < 0) {
-		cond_km = -cond_km;	/* 上り */
-		sqlite3_snprintf(sizeof(sql_buf), sql_buf, tsql_desc, cond_km - km_offset);
-	} else {		/* 下り */
-		sqlite3_snprintf(sizeof(sql_buf), sql_buf, tsql_asc, cond_km - km_offset);
-	}
-	//int32_t akm;
-	int32_t aStationId;
-	DBO dbo(DBS::getInstance()->compileSql(sql_buf));
-
-	dbo.setParam(1, line_id);
-	dbo.setParam(2, station_id);
-
-	if (dbo.moveNext()) {
-		aStationId = dbo.getInt(0);
-		return aStationId;
-	}
-	return 0;
+	return Rule114Index::GetInstance().reachPoint(cond_km, km_offset, line_id, station_id);
 }
 
-
 //static
 //	路線は新幹線の在来線か?
 //
@@ -7837,6 +7775,16 @@ public:
 			d[i].line_id = 0;
 		}
 	}
+	Dijkstra(const Dijkstra& other) {
+		d = new NODE_JCT [MAX_JCT];
+		memcpy(d, other.d, sizeof(NODE_JCT) * MAX_JCT);
+	}
+	Dijkstra& operator=(const Dijkstra& other) {
+		if (this != &other) {
+			memcpy(d, other.d, sizeof(NODE_JCT) * MAX_JCT);
+		}
+		return *this;
+	}
 	~Dijkstra() {
 		delete [] d;
 	}
@@ -7851,6 +7799,116 @@ public:
 	IDENT lineId(int index) { return d[index].line_id; }
 };
 
+//	changeNeerest()の最短経路木キャッシュ
+//
+class NeerestTree {
+public:
+	int32_t startStationId;
+	uint8_t useBulletTrain;
+	IDENT excNode1;
+	IDENT excNode2;
+	uint32_t hash;
+	BYTE jct_mask[JCTMASKSIZE];
+	Dijkstra tree;
+
+	NeerestTree(int32_t start_station_id, uint8_t use_bullet_train, IDENT exc_node1, IDENT exc_node2, const BYTE* mask) {
+		int32_t i;
+		startStationId = start_station_id;
+		useBulletTrain = use_bullet_train;
+		excNode1 = exc_node1;
+		excNode2 = exc_node2;
+		memcpy(jct_mask, mask, JCTMASKSIZE);
+		hash = 2166136261u;		/* FNV-1a */
+		for (i = 0; i < JCTMASKSIZE; i++) {
+			hash = (hash ^ jct_mask[i]) * 16777619u;
+		}
+	}
+	bool isSameKey(const NeerestTree& key) const {
+		return (hash == key.hash) && (startStationId == key.startStationId) &&
+			   (useBulletTrain == key.useBulletTrain) &&
+			   (excNode1 == key.excNode1) && (excNode2 == key.excNode2) &&
+			   (0 == memcmp(jct_mask, key.jct_mask, JCTMASKSIZE));
+	}
+};
+
+static list<NeerestTree> neerest_tree_cache;	/* 先頭が最新 */
+static int32_t neerest_tree_capacity = 16;
+static int32_t neerest_tree_hit = 0;
+static int32_t neerest_tree_miss = 0;
+
+//static
+//	キャッシュ件数の上限(0でキャッシュしない). 1件は約6KB
+//
+void NeerestTreeCache::setCapacity(int32_t capacity)
+{
+	neerest_tree_capacity = (capacity < 0) ? 0 : capacity;
+	while (neerest_tree_capacity < (int32_t)neerest_tree_cache.size()) {
+		neerest_tree_cache.pop_back();
+	}
+}
+
+int32_t NeerestTreeCache::capacity()
+{
+	return neerest_tree_capacity;
+}
+
+int32_t NeerestTreeCache::size()
+{
+	return (int32_t)neerest_tree_cache.size();
+}
+
+//static
+//	キャッシュと統計をクリア(DBを開き直した時)
+//
+void NeerestTreeCache::clear()
+{
+	neerest_tree_cache.clear();
+	neerest_tree_hit = 0;
+	neerest_tree_miss = 0;
+}
+
+int32_t NeerestTreeCache::hitCount()
+{
+	return neerest_tree_hit;
+}
+
+int32_t NeerestTreeCache::missCount()
+{
+	return neerest_tree_miss;
+}
+
+//	キャッシュから最短経路木を得る(見つかれば最新にする)
+//
+static bool NeerestTreeLookup(const NeerestTree& key, Dijkstra* dijkstra)
+{
+	list<NeerestTree>::iterator ite;
+
+	for (ite = neerest_tree_cache.begin(); ite != neerest_tree_cache.end(); ite++) {
+		if (ite->isSameKey(key)) {
+			neerest_tree_cache.splice(neerest_tree_cache.begin(), neerest_tree_cache, ite);
+			*dijkstra = neerest_tree_cache.front().tree;
+			neerest_tree_hit++;
+			return true;
+		}
+	}
+	neerest_tree_miss++;
+	return false;
+}
+
+//	最短経路木をキャッシュに登録(上限を超えたら最も古いものを捨てる)
+//
+static void NeerestTreeStore(const NeerestTree& key, const Dijkstra& dijkstra)
+{
+	if (neerest_tree_capacity <= 0) {
+		return;
+	}
+	neerest_tree_cache.push_front(key);
+	neerest_tree_cache.front().tree = dijkstra;
+	while (neerest_tree_capacity < (int32_t)neerest_tree_cache.size()) {
+		neerest_tree_cache.pop_back();
+	}
+}
+
 int32_t Route::changeNeerest(uint8_t useBulletTrain, int end_station_id)
 {
 	ASSERT(0 < departureStationId());
@@ -8016,7 +8074,16 @@ TRACE(_T("******** loopRouteY **%s, %s******\n"), SNAME(Jct2id(excNode1)), SNAME
 	}
 
 	/* dijkstra */
-	for (;;) {
+	// 着駅(の両隣の分岐駅)が通過済みでなければ着駅によらず同じ最短経路木となるので、
+	// 全分岐駅の最短経路木をキャッシュし、2回目以降はキャッシュの木をたどる
+	bool full_tree = (0 < neerest_tree_capacity) &&
+		((nLastNode == 0) ? !IsJctMask(jct_mask, lastNode) :
+			(!IsJctMask(jct_mask, lastNode1) && ((nLastNode == 1) || !IsJctMask(jct_mask, lastNode2))));
+	NeerestTree tree_key(stationId, useBulletTrain | (except_local ? 0x80 : 0),
+						 loopRoute ? excNode1 : 0, loopRoute ? excNode2 : 0, jct_mask);
+
+	bool cached = full_tree && NeerestTreeLookup(tree_key, &dijkstra);
+	while (!cached) {
 		doneNode = -1;
 		for (i = 0; i < MAX_JCT; i++) {
 			// ノードiが確定しているとき
@@ -8032,12 +8099,17 @@ TRACE(_T("******** loopRouteY **%s, %s******\n"), SNAME(Jct2id(excNode1)), SNAME
 			}
 		}
 		if (doneNode == -1) {
+			if (full_tree) {
+				NeerestTreeStore(tree_key, dijkstra);
+			}
 			break;	/* すべてのノードが確定したら終了 */
 		}
 		dijkstra.setDoneFlag(doneNode, true);	// Enter start node
 
 		TRACE(_T("[%s]"), SNAME(Jct2id(doneNode + 1)));
-		if (nLastNode == 0) {
+		if (full_tree) {
+			/* 全ノード確定まで続ける */
+		} else if (nLastNode == 0) {
 			if ((doneNode + 1) == lastNode) {
 				break;	/* 着ノードが完了しても終了可 */
 			}
@@ -8283,9 +8355,6 @@ TRACE(_T("fin last:%s\n"), LNAME(lid));
 //////////////////////////////////////////////////////////////////////////////////
 //////////////////////////////////////////////////////////////////////////////////
 //////////////////////////////////////////////////////////////////////////////////
-// static
-int32_t FARE_INFO::tax = 0;
-
 /**	往復運賃を返す(会社線含む総額)(JR分は601km以上で1割引)
  *
  *	@param discount [out]  true=割引あり
@@ -9070,9 +9139,9 @@ int FARE_INFO::aggregate_fare_company(bool first_company,   /* 1回目の会社
     if (0 < station_id_0) {
         /* 2回以上連続で会社線の場合(タンゴ鉄道とか) */
             /* a+++b+++c : */
-        if (!FARE_INFO::Fare_company(station_id_0, station_id, &comfare)) {
+        if (!FARE_INFO::Fare_company(station_id_0, station_id, &comfare, tax)) {
             /* 乗継割引なし */
-            if (!FARE_INFO::Fare_company(station_id1, station_id, &comfare)) {
+            if (!FARE_INFO::Fare_company(station_id1, station_id, &comfare, tax)) {
                 ASSERT(FALSE);
             }
             station_id_0 = station_id1;
@@ -9083,12 +9152,12 @@ int FARE_INFO::aggregate_fare_company(bool first_company,   /* 1回目の会社
             if (comfare.is_connect_non_discount_fare() &&
                 (!rRoute_flag.compnend || !rRoute_flag.compnbegin)) {
                 /* 乗継割引なし */
-                if (!FARE_INFO::Fare_company(station_id1, station_id, &comfare)) {
+                if (!FARE_INFO::Fare_company(station_id1, station_id, &comfare, tax)) {
                     ASSERT(FALSE);
                 }
             } else {
                 /* normal or 併算割引適用 */
-                if (!FARE_INFO::Fare_company(station_id_0, station_id1, &comfare_1)) {
+                if (!FARE_INFO::Fare_company(station_id_0, station_id1, &comfare_1, tax)) {
                     ASSERT(FALSE);
                 }
                 if (0 < comfare_1.fareAcademic) {
@@ -9117,7 +9186,7 @@ int FARE_INFO::aggregate_fare_company(bool first_company,   /* 1回目の会社
             result_flag.company_incorrect = true;
             ASSERT(FALSE);
         }
-        if (!FARE_INFO::Fare_company(station_id1, station_id, &comfare)) {
+        if (!FARE_INFO::Fare_company(station_id1, station_id, &comfare, tax)) {
             ASSERT(FALSE);
         }
         if (0 < comfare.fareAcademic) {
@@ -9135,9 +9204,214 @@ int FARE_INFO::aggregate_fare_company(bool first_company,   /* 1回目の会社
     return station_id_0;
 }
 
+//	集計途中の値を保存
+//
+void FARE_INFO::saveAggregate(AggregateState* pState, int32_t station_id_0, bool osakakan_pass, int32_t fare_add) const
+{
+	pState->sales_km = sales_km;
+	pState->base_sales_km = base_sales_km;
+	pState->base_calc_km = base_calc_km;
+	pState->kyusyu_sales_km = kyusyu_sales_km;
+	pState->kyusyu_calc_km = kyusyu_calc_km;
+	pState->hokkaido_sales_km = hokkaido_sales_km;
+	pState->hokkaido_calc_km = hokkaido_calc_km;
+	pState->shikoku_sales_km = shikoku_sales_km;
+	pState->shikoku_calc_km = shikoku_calc_km;
+	pState->company_fare = company_fare;
+	pState->company_fare_ac_discount = company_fare_ac_discount;
+	pState->company_fare_child = company_fare_child;
+	pState->brt_sales_km = brt_sales_km;
+	pState->brt_calc_km = brt_calc_km;
+	pState->flag = flag;
+	pState->companymask = companymask;
+	pState->local_only = local_only;
+	pState->local_only_as_hokkaido = local_only_as_hokkaido;
+	pState->result_flag = result_flag;
+	pState->station_id_0 = station_id_0;
+	pState->osakakan_pass = osakakan_pass;
+	pState->fare_add = fare_add;
+}
+
+//	保存した集計途中の値に戻す(ループ変数は呼び元で戻す)
+//
+void FARE_INFO::loadAggregate(const AggregateState& state)
+{
+	sales_km = state.sales_km;
+	base_sales_km = state.base_sales_km;
+	base_calc_km = state.base_calc_km;
+	kyusyu_sales_km = state.kyusyu_sales_km;
+	kyusyu_calc_km = state.kyusyu_calc_km;
+	hokkaido_sales_km = state.hokkaido_sales_km;
+	hokkaido_calc_km = state.hokkaido_calc_km;
+	shikoku_sales_km = state.shikoku_sales_km;
+	shikoku_calc_km = state.shikoku_calc_km;
+	company_fare = state.company_fare;
+	company_fare_ac_discount = state.company_fare_ac_discount;
+	company_fare_child = state.company_fare_child;
+	brt_sales_km = state.brt_sales_km;
+	brt_calc_km = state.brt_calc_km;
+	flag = state.flag;
+	companymask = state.companymask;
+	local_only = state.local_only;
+	local_only_as_hokkaido = state.local_only_as_hokkaido;
+	result_flag = state.result_flag;
+}
+
+//	FareAggregateCache
+//
+//	aggregate_fare_info()の区間ごとの集計は、その区間までの経路と
+//	消費税率、経路フラグの大阪環状線の方向(osakakan_1dir, 2dir)、会社線発着(compnbegin, compnend)だけで決まる.
+//	経路の区間ごとに集計後の値を保持し、経路の先頭から一致する区間までは再利用する.
+//	経路の追加(add())では最後の区間だけ、末尾削除(removeTail())では集計なしとなる.
+//	86,87,69,70条で経路が書き換わった場合は書き換わった区間から集計し直す(発着の書き換えなら全区間).
+//
+class FareAggregateEntry {
+public:
+	uint64_t key;
+	vector<RouteItem> route_list;
+	vector<FARE_INFO::AggregateState> states;	/* [i] route_list[0]〜[i]まで集計した値 */
+};
+
+static list<FareAggregateEntry> fare_aggregate_cache;		/* 先頭が最新 */
+static int32_t fare_aggregate_capacity = 4;
+static int32_t fare_aggregate_hit = 0;
+static int32_t fare_aggregate_miss = 0;
+
+//static
+//	保持する経路数の上限(0で保持しない)
+//
+void FareAggregateCache::setCapacity(int32_t capacity)
+{
+	fare_aggregate_capacity = (capacity < 0) ? 0 : capacity;
+	while (fare_aggregate_capacity < (int32_t)fare_aggregate_cache.size()) {
+		fare_aggregate_cache.pop_back();
+	}
+}
+
+int32_t FareAggregateCache::capacity()
+{
+	return fare_aggregate_capacity;
+}
+
+int32_t FareAggregateCache::size()
+{
+	return (int32_t)fare_aggregate_cache.size();
+}
+
+//static
+//	保持している経路と統計をクリア(DBを開き直した時)
+//
+void FareAggregateCache::clear()
+{
+	fare_aggregate_cache.clear();
+	fare_aggregate_hit = 0;
+	fare_aggregate_miss = 0;
+}
+
+int32_t FareAggregateCache::hitCount()
+{
+	return fare_aggregate_hit;
+}
+
+int32_t FareAggregateCache::missCount()
+{
+	return fare_aggregate_miss;
+}
+
+//static private
+//	集計に影響する経路フラグと消費税率
+//
+uint64_t FareAggregateCache::KeyOf(const RouteFlag& rRoute_flag, int32_t tax)
+{
+	return ((uint64_t)(uint32_t)tax << 32) |
+			(rRoute_flag.osakakan_1dir ? 0x01 : 0) | (rRoute_flag.osakakan_2dir ? 0x02 : 0) |
+			(rRoute_flag.compnbegin ? 0x04 : 0) | (rRoute_flag.compnend ? 0x08 : 0);
+}
+
+//static private
+//	経路の先頭から一致する区間が最も長い保持経路の集計値を得る(見つかれば最新にする)
+//
+//	@param [in]  key       KeyOf()
+//	@param [in]  routeList 経路
+//	@param [out] pStates   [0]〜[戻り値 - 1]に集計値を設定
+//	@return 再利用できる集計値の数(0:なし)
+//
+size_t FareAggregateCache::Resume(uint64_t key, const vector<RouteItem>& routeList, vector<FARE_INFO::AggregateState>* pStates)
+{
+	list<FareAggregateEntry>::iterator ite;
+	list<FareAggregateEntry>::iterator best = fare_aggregate_cache.end();
+	size_t best_count = 0;
+
+	for (ite = fare_aggregate_cache.begin(); ite != fare_aggregate_cache.end(); ite++) {
+		size_t count;
+
+		if (ite->key != key) {
+			continue;
+		}
+		for (count = 0; (count < ite->route_list.size()) && (count < routeList.size()); count++) {
+			if ((ite->route_list[count].lineId != routeList[count].lineId) ||
+				(ite->route_list[count].stationId != routeList[count].stationId)) {
+				break;
+			}
+		}
+		if (best_count < count) {
+			best_count = count;
+			best = ite;
+		}
+	}
+	if (best_count == 0) {
+		return 0;
+	}
+	fare_aggregate_cache.splice(fare_aggregate_cache.begin(), fare_aggregate_cache, best);
+	pStates->assign(best->states.cbegin(), best->states.cbegin() + best_count);
+	return best_count;
+}
+
+//static private
+//	集計値を保持する
+//
+//	Resume()で得た経路(先頭)を延長した経路なら置き換え、その一部(末尾削除)なら保持済みなので何もしない.
+//	それ以外は新たに保持する(上限を超えたら最も古いものを捨てる)
+//
+//	@param [in] key       KeyOf()
+//	@param [in] routeList 経路
+//	@param [in] states    [i] routeList[0]〜[i]まで集計した値
+//	@param [in] reused    Resume()の戻り値
+//
+void FareAggregateCache::Store(uint64_t key, const vector<RouteItem>& routeList, const vector<FARE_INFO::AggregateState>& states, size_t reused)
+{
+	if (fare_aggregate_capacity <= 0) {
+		return;
+	}
+	fare_aggregate_hit += (int32_t)reused;
+	fare_aggregate_miss += (int32_t)(routeList.size() - reused);
+
+	if (0 < reused) {
+		/* fare_aggregate_cache.front()はResume()で見つかった経路 */
+		if (reused == routeList.size()) {
+			return;
+		}
+		if (reused != fare_aggregate_cache.front().route_list.size()) {
+			reused = 0;
+		}
+	}
+	if (reused == 0) {
+		fare_aggregate_cache.push_front(FareAggregateEntry());
+		while (fare_aggregate_capacity < (int32_t)fare_aggregate_cache.size()) {
+			fare_aggregate_cache.pop_back();
+		}
+	}
+	FareAggregateEntry& entry = fare_aggregate_cache.front();
+	entry.key = key;
+	entry.route_list = routeList;
+	entry.states = states;
+}
+
 //	1経路の営業キロ、計算キロを集計
 //	calc_fare() =>
 //
+//	経路の先頭から前回と同じ区間はFareAggregateCacheの集計値を使う
+//
 //	@retval 0 < Success(特別加算区間割増運賃額.通常は0)
 //	@retval -1 Fatal error
 //  @note route_flag update bit was BLF_JRTOKAISTOCK_ENABLE only.
@@ -9149,6 +9423,9 @@ int32_t FARE_INFO::aggregate_fare_info(RouteFlag* pRoute_flag, const vector<Rout
 	IDENT station_id_0;		/* last station_id1(for Company line) */
 	vector<RouteItem>::const_iterator ite;
 	RouteFlag   osakakan_aggregate;	// 大阪環状線通過フラグ bit0: 通過フラグ
+	uint64_t aggregate_key;
+	vector<AggregateState> states;	/* [i] routeList[0]〜[i]まで集計した値 */
+	size_t reused;
 
     CheckIsBulletInUrbanOnSpecificTerm(routeList, pRoute_flag); // routeListはcooked経路であること
 	                                //
@@ -9165,7 +9442,19 @@ int32_t FARE_INFO::aggregate_fare_info(RouteFlag* pRoute_flag, const vector<Rout
 
 	station_id_0 = station_id1 = 0;
 
-	for (ite = routeList.cbegin(); ite != routeList.cend(); ite++) {
+	aggregate_key = FareAggregateCache::KeyOf(*pRoute_flag, tax);
+	reused = FareAggregateCache::Resume(aggregate_key, routeList, &states);
+	if (0 < reused) {
+		const AggregateState& last = states.back();
+		loadAggregate(last);
+		station_id_0 = last.station_id_0;
+		osakakan_aggregate.setOsakaKanPass(last.osakakan_pass);
+		fare_add = last.fare_add;
+		station_id1 = routeList[reused - 1].stationId;
+	}
+	states.resize(routeList.size());
+
+	for (ite = routeList.cbegin() + reused; ite != routeList.cend(); ite++) {
 
 //ASSERT((ite->flag) == 0);
 		if (station_id1 != 0) {
@@ -9257,11 +9546,13 @@ int32_t FARE_INFO::aggregate_fare_info(RouteFlag* pRoute_flag, const vector<Rout
 				/* flag(sflg)は、b11,10,5, 7-9 のみ使用で他はFARE_INFOでは使用しない */
 
 								// 特別加算区間
-				fare_add += FARE_INFO::CheckSpecificFarePass(ite->lineId, station_id1, ite->stationId);
+				fare_add += FARE_INFO::CheckSpecificFarePass(ite->lineId, station_id1, ite->stationId, tax);
 			}
 		}
 		station_id1 = ite->stationId;
+		saveAggregate(&states[ite - routeList.cbegin()], station_id_0, osakakan_aggregate.getOsakaKanPass(), fare_add);
 	}
+	FareAggregateCache::Store(aggregate_key, routeList, states, reused);
     if (pRoute_flag->bJrTokaiOnly) {
 		// JR東海のみ
 
@@ -9503,14 +9794,14 @@ bool FARE_INFO::calc_fare(RouteFlag* pRoute_flag, const vector<RouteItem>& route
 										/* 大聖寺-和倉温泉は106kmある */
 										/* 大聖寺-米原-岐阜-富山-津端-和倉温泉 を弾く為 */
 	        	TRACE("specific fare section replace for IR-ishikawa change continue discount\n");
-				special_fare = FARE_INFO::SpecificFareLine(routeList.front().stationId, routeList.back().stationId, 2);
+				special_fare = FARE_INFO::SpecificFareLine(routeList.front().stationId, routeList.back().stationId, 2, tax);
 				if (0 < special_fare) {
 		            this->jr_fare = special_fare - this->company_fare;	/* IRいしかわ 乗継割引 */
 				}
 		} else if ( //!pRoute_flag->isUseBullet() &&           /* b#18111401: 新幹線乗車なく、 */
 		            (((MASK_URBAN & this->flag) != 0) || (this->sales_km < 500))
 					&& !pRoute_flag->isIncludeCompanyLine()) { // 東京メトロは適用外
-			special_fare = FARE_INFO::SpecificFareLine(routeList.front().stationId, routeList.back().stationId, 1);
+			special_fare = FARE_INFO::SpecificFareLine(routeList.front().stationId, routeList.back().stationId, 1, tax);
 			if (0 < special_fare) {
 	        	TRACE("specific fare section replace for Metro or Shikoku-Big-bridge\n");
                 if (!pRoute_flag->no_rule && !pRoute_flag->osakakan_detour) {
@@ -9697,7 +9988,9 @@ void FARE_INFO::calc_brt_fare(const vector<RouteItem>& routeList)
 void FARE_INFO::setRoute(const vector<RouteItem>& routeList,
                          const RouteFlag& rRoute_flag)
 {
-    route_for_disp = RouteUtil::Show_route(routeList, rRoute_flag);
+    if (isOutputRequested(FARE_OUT_ROUTE_STRING)) {
+        route_for_disp = RouteUtil::Show_route(routeList, rRoute_flag);
+    }
 }
 
 // TOICA Neerest route
@@ -9705,7 +9998,9 @@ void FARE_INFO::setRoute(const vector<RouteItem>& routeList,
 void FARE_INFO::setTOICACalcRoute(const vector<RouteItem>& routeList,
                         const RouteFlag& rRoute_flag)
 {
-    calc_route_for_disp = RouteUtil::Show_route(routeList, rRoute_flag);
+    if (isOutputRequested(FARE_OUT_ROUTE_STRING)) {
+        calc_route_for_disp = RouteUtil::Show_route(routeList, rRoute_flag);
+    }
 }
 
 
@@ -9787,7 +10082,14 @@ std::vector<RouteItem> FARE_INFO::IsHachikoLineHaijima(const std::vector<RouteIt
 //
 bool FARE_INFO::reCalcFareForOptiomizeRouteForToiCa(const RouteList& route_original)
 {
-    FARE_INFO fare_info_shorts;         // 最短経路
+    FARE_INFO fare_info_shorts(tax);        // 最短経路
+
+    // どの経路でも今の運賃より安くならないなら最短経路を出さない(JR東海のみ:幹線・地方交通線)
+    if (FARE_INFO::IsNotLowerFare(route_original.departureStationId(), route_original.arriveStationId(),
+                                  1, (1 << FK_BASIC) | (1 << FK_SUB), this->getFareForJR(), tax)) {
+        clrTOICACalcRoute();
+        return false;
+    }
 
     // JR東海(TOICA)
     Route shortRoute(reRouteForToica(route_original));
@@ -9821,12 +10123,17 @@ bool FARE_INFO::reCalcFareForOptiomizeRouteForToiCa(const RouteList& route_origi
  */
 bool FARE_INFO::reCalcFareForOptiomizeRoute(RouteList& route_original)
 {
-    FARE_INFO fare_info_shorts;         // 最短経路
-    FARE_INFO fare_info_nolocal_short;  // 地方交通線を避けた経路
-    FARE_INFO fare_info_specific_short; // 都区市内発着最短
+    FARE_INFO fare_info_shorts(tax);        // 最短経路
+    FARE_INFO fare_info_nolocal_short(tax); // 地方交通線を避けた経路
+    FARE_INFO fare_info_specific_short(tax);// 都区市内発着最短
     bool b_change_route = false;
     int8_t decision = 0;   // this or via_tachikawa or short
 
+    // 代替経路も要求された項目のみ計算する(採用時は *this へ代入するので出力マスクもそのまま引き継ぐ)
+    fare_info_shorts.setOutputMask(output_mask);
+    fare_info_nolocal_short.setOutputMask(output_mask);
+    fare_info_specific_short.setOutputMask(output_mask);
+
     // 大都市近郊区間内ではない、or 新幹線乗車している or 同一駅(単駅ベースで)発着 なら対象外
     if ( !isUrbanArea() || route_original.getRouteFlag().isUseBullet()
 	     || route_original.getRouteFlag().isIncludeCompanyLine()
@@ -9945,8 +10252,14 @@ bool FARE_INFO::reCalcFareForOptiomizeRoute(RouteList& route_original)
 //                          書き換えたroute_flagはJR東海株主使用可否Optionだけなので無視してよし
 //                          学割、小児、株主運賃は既存どおりなので、fare_infoのic運賃のみfare_info_shortsのic運賃へ書き換える
 //                            と拝島問題
+        // 東京近郊区間で地方交通線を避けた経路が最短経路の運賃より安くなり得ないなら探索しない
         if (fare_info_shorts.didHaveLocalLine()
             && (decision == 0) /* 86or87 適用絡みはやらん (decision == 15 or 20) */
+            && !((URB_TOKYO == URBAN_ID(this->flag))
+                 && FARE_INFO::IsNotLowerFare(route_original.departureStationId(),
+                                              route_original.arriveStationId(), 100,
+                                              (1 << FK_BASIC) | (1 << FK_SUB) | (1 << FK_TOKYO) | (1 << FK_YAMATE),
+                                              fare_info_shorts.getFareForJR(), tax))
             && fare_info_nolocal_short.reCalcFareForOptiomizeRoute(&route_nolocal_short,
                                                                route_original.departureStationId(),
                                                                route_original.arriveStationId(),
@@ -10016,13 +10329,234 @@ TRACE("reCalc(urban): decision=%d, this=%s->%s(%d)(%dyen),\n
     return b_change_route;
 }
 
+//	reCalcFareForOptiomizeRoute()の代替経路の運賃計算結果キャッシュ
+//
+class OptimizeRouteResult {
+public:
+	uint64_t hash;
+	uint64_t flags;					/* RouteFlag::fareKeyBits() (計算前) */
+	int32_t start_station_id;
+	int32_t end_station_id;
+	bool except_local;
+	int32_t tax;
+
+	/* 計算結果 */
+	bool rc;
+	FARE_INFO fare_info;
+	RouteFlag route_flag;			/* 計算後 */
+	vector<RouteItem> route_list;
+
+	OptimizeRouteResult(int32_t start_station_id_, int32_t end_station_id_, const RouteFlag& rRoute_flag,
+						bool except_local_, int32_t tax_) :
+		start_station_id(start_station_id_), end_station_id(end_station_id_),
+		except_local(except_local_), tax(tax_) {
+		flags = rRoute_flag.fareKeyBits();
+		hash = 14695981039346656037ull;		/* FNV-1a */
+		hash = (hash ^ flags) * 1099511628211ull;
+		hash = (hash ^ (uint32_t)start_station_id) * 1099511628211ull;
+		hash = (hash ^ (uint32_t)end_station_id) * 1099511628211ull;
+		hash = (hash ^ (except_local ? 1 : 0)) * 1099511628211ull;
+		hash = (hash ^ (uint32_t)tax) * 1099511628211ull;
+		rc = false;
+	}
+	bool isSameKey(const OptimizeRouteResult& key) const {
+		return (hash == key.hash) && (flags == key.flags) &&
+			   (start_station_id == key.start_station_id) && (end_station_id == key.end_station_id) &&
+			   (except_local == key.except_local) && (tax == key.tax);
+	}
+};
+
+static list<OptimizeRouteResult> optimize_route_cache;	/* 先頭が最新 */
+static unordered_map<uint64_t, list<OptimizeRouteResult>::iterator> optimize_route_index;	/* hash -> optimize_route_cache */
+static int32_t optimize_route_capacity = 64;
+static int32_t optimize_route_hit = 0;
+static int32_t optimize_route_miss = 0;
+static int32_t optimize_route_pruned = 0;
+
+//static
+//	キャッシュ件数の上限(0でキャッシュしない)
+//
+void OptimizeRouteCache::setCapacity(int32_t capacity)
+{
+	optimize_route_capacity = (capacity < 0) ? 0 : capacity;
+	while (optimize_route_capacity < (int32_t)optimize_route_cache.size()) {
+		optimize_route_index.erase(optimize_route_cache.back().hash);
+		optimize_route_cache.pop_back();
+	}
+}
+
+int32_t OptimizeRouteCache::capacity()
+{
+	return optimize_route_capacity;
+}
+
+int32_t OptimizeRouteCache::size()
+{
+	return (int32_t)optimize_route_cache.size();
+}
+
+//static
+//	キャッシュと統計をクリア(DBを開き直した時)
+//
+void OptimizeRouteCache::clear()
+{
+	optimize_route_cache.clear();
+	optimize_route_index.clear();
+	optimize_route_hit = 0;
+	optimize_route_miss = 0;
+	optimize_route_pruned = 0;
+}
+
+int32_t OptimizeRouteCache::hitCount()
+{
+	return optimize_route_hit;
+}
+
+int32_t OptimizeRouteCache::missCount()
+{
+	return optimize_route_miss;
+}
+
+int32_t OptimizeRouteCache::prunedCount()
+{
+	return optimize_route_pruned;
+}
+
+//	キャッシュから計算結果を得る(見つかれば最新にする)
+//
+static const OptimizeRouteResult* OptimizeRouteLookup(const OptimizeRouteResult& key)
+{
+	unordered_map<uint64_t, list<OptimizeRouteResult>::iterator>::const_iterator ite;
+
+	if (optimize_route_capacity <= 0) {
+		return NULL;
+	}
+	ite = optimize_route_index.find(key.hash);
+	if ((ite != optimize_route_index.cend()) && ite->second->isSameKey(key)) {
+		optimize_route_cache.splice(optimize_route_cache.begin(), optimize_route_cache, ite->second);
+		optimize_route_hit++;
+		return &optimize_route_cache.front();
+	}
+	optimize_route_miss++;
+	return NULL;
+}
+
+//	計算結果をキャッシュに登録(上限を超えたら最も古いものを捨てる. ハッシュが衝突したら置き換える)
+//
+static OptimizeRouteResult* OptimizeRouteStore(const OptimizeRouteResult& key)
+{
+	unordered_map<uint64_t, list<OptimizeRouteResult>::iterator>::iterator ite;
+
+	if (optimize_route_capacity <= 0) {
+		return NULL;
+	}
+	ite = optimize_route_index.find(key.hash);
+	if (ite != optimize_route_index.end()) {
+		optimize_route_cache.erase(ite->second);
+		optimize_route_index.erase(ite);
+	}
+	optimize_route_cache.push_front(key);
+	optimize_route_index[key.hash] = optimize_route_cache.begin();
+	while (optimize_route_capacity < (int32_t)optimize_route_cache.size()) {
+		optimize_route_index.erase(optimize_route_cache.back().hash);
+		optimize_route_cache.pop_back();
+	}
+	return &optimize_route_cache.front();
+}
+
+//static private
+//	発着駅間のどの経路でも運賃がfare未満にならないか(代替経路の探索・運賃計算を省けるか)
+//	縮約階層インデックスの最短営業キロ(経路の営業キロの下限)での運賃表の最安値と
+//	特定区間運賃の小さい方を運賃の下限とする. 加算運賃・BRT・会社線は下限に含めない
+//
+//	@param [in] station_id1    発駅
+//	@param [in] station_id2    着駅
+//	@param [in] useBulletTrain 経路に使う路線(changeNeerest()と同じ)
+//	@param [in] kinds          経路に適用され得る運賃表(bit[FAREKERNEL])
+//	@param [in] fare           比べる運賃[円]
+//	@param [in] tax            消費税率(%)
+//	@retval true  下限がfare以上(代替経路は安くならない)
+//	@retval false 安くなり得る(または下限不明)
+//
+bool FARE_INFO::IsNotLowerFare(int32_t station_id1, int32_t station_id2, uint8_t useBulletTrain,
+                               uint32_t kinds, int32_t fare, int32_t tax)
+{
+	int32_t km;
+	int32_t kind;
+	int32_t fare_tmp;
+	int32_t lower = INT32_MAX;
+
+	km = StationCH::getInstance(true, useBulletTrain).distance(station_id1, station_id2);
+	if (km <= 0) {
+		return false;
+	}
+	for (kind = 0; kind < FK_NUM; kind++) {
+		if ((kinds & (1u << kind)) != 0) {
+			fare_tmp = FareKernel::Fare((FAREKERNEL)kind, km, tax);
+			if (fare_tmp < lower) {
+				lower = fare_tmp;
+			}
+		}
+	}
+	lower = round_down(lower);
+	fare_tmp = FARE_INFO::SpecificFareLine(station_id1, station_id2, 1, tax);
+	if ((0 < fare_tmp) && (fare_tmp < lower)) {
+		lower = fare_tmp;
+	}
+	if (lower < fare) {
+		return false;
+	}
+	TRACE("pruned alternative route(lower bound %dyen >= %dyen)\n", lower, fare);
+	optimize_route_pruned++;
+	return true;
+}
+
 //  最短経路を算出して運賃計算する
+//	同じ発着駅・フラグ・税率の結果はキャッシュから返す(OptimizeRouteCache)
 //
 bool FARE_INFO::reCalcFareForOptiomizeRoute(std::vector<RouteItem> *pShortRoute_list,
                                             int32_t start_station_id,
                                             int32_t end_station_id,
                                             RouteFlag* pShort_route_flag,
                                             bool except_local /* =false */ )
+{
+	OptimizeRouteResult key(start_station_id, end_station_id, *pShort_route_flag, except_local, tax);
+	const OptimizeRouteResult* cached = OptimizeRouteLookup(key);
+	OptimizeRouteResult* entry;
+	uint32_t mask;
+	bool rc;
+
+	if (cached != NULL) {
+		if (cached->rc) {
+			mask = output_mask;
+			*this = cached->fare_info;
+			output_mask = mask;
+			*pShort_route_flag = cached->route_flag;
+			pShortRoute_list->assign(cached->route_list.cbegin(), cached->route_list.cend());
+		}
+		return cached->rc;
+	}
+	rc = reCalcFareForOptiomizeRouteNoCache(pShortRoute_list, start_station_id, end_station_id,
+	                                        pShort_route_flag, except_local);
+	entry = OptimizeRouteStore(key);
+	if (entry != NULL) {
+		entry->rc = rc;
+		if (rc) {
+			entry->fare_info = *this;
+			entry->route_flag = *pShort_route_flag;
+			entry->route_list = *pShortRoute_list;
+		}
+	}
+	return rc;
+}
+
+//  最短経路を算出して運賃計算する(キャッシュなし)
+//
+bool FARE_INFO::reCalcFareForOptiomizeRouteNoCache(std::vector<RouteItem> *pShortRoute_list,
+                                                   int32_t start_station_id,
+                                                   int32_t end_station_id,
+                                                   RouteFlag* pShort_route_flag,
+                                                   bool except_local)
 {
     Route shortRoute;
     int32_t rc = shortRoute.add(start_station_id);
@@ -10157,7 +10691,7 @@ void FARE_INFO::retr_fare(bool useBullet)
 
     // brt
     if (0 < brt_sales_km) {
-        fare_tmp = FARE_INFO::Fare_sub_f(this->brt_sales_km);
+        fare_tmp = FareKernel::Fare(FK_SUB, this->brt_sales_km, tax);
         this->brt_fare = round(fare_tmp);
     }
 
@@ -10170,13 +10704,13 @@ void FARE_INFO::retr_fare(bool useBullet)
 			ASSERT(this->base_sales_km == _total_jr_sales_km);
 			ASSERT(this->base_sales_km == this->sales_km);
             ASSERT(this->base_calc_km == _total_jr_calc_km);
-			if (IS_YAMATE(this->flag) && FARE_INFO::tax != 10) {
+			if (IS_YAMATE(this->flag) && tax != 10) {
                                         // 2025.4.1 大阪環状線特例廃止 
 				TRACE("fare(osaka-kan)\n");
-				_total_jr_fare = FARE_INFO::Fare_osakakan(_total_jr_sales_km);
+				_total_jr_fare = FareKernel::Fare(FK_OSAKAKAN, _total_jr_sales_km, tax);
 			} else {
 				TRACE("fare(osaka)\n");
-				_total_jr_fare = FARE_INFO::Fare_osaka(_total_jr_sales_km);
+				_total_jr_fare = FareKernel::Fare(FK_OSAKA, _total_jr_sales_km, tax);
 			}
 		} else if ((_total_jr_sales_km == _total_jr_calc_km) &&   /* 地方交通線(八高線)含まず:b#18122801 */
                    (IS_TKMSP(this->flag) && (IS_YAMATE(this->flag) || (((1 << (JR_CENTRAL - 1)) & companymask) == 0)))) {
@@ -10189,12 +10723,12 @@ void FARE_INFO::retr_fare(bool useBullet)
 
 			if (IS_YAMATE(this->flag)) {
 				TRACE("fare(yamate)\n");
-				fare_tmp = FARE_INFO::Fare_yamate_f(_total_jr_sales_km);
+				fare_tmp = FareKernel::Fare(FK_YAMATE, _total_jr_sales_km, tax);
 			} else {
 				TRACE("fare(tokyo)\n");
-				fare_tmp = FARE_INFO::Fare_tokyo_f(_total_jr_sales_km);
+				fare_tmp = FareKernel::Fare(FK_TOKYO, _total_jr_sales_km, tax);
 			}
-			if (FARE_INFO::tax == 5) {
+			if (tax == 5) {
 				_total_jr_fare = round(fare_tmp);
 			} else {
 				/* 新幹線乗車はIC運賃適用外(東北新幹線も) */
@@ -10209,9 +10743,9 @@ void FARE_INFO::retr_fare(bool useBullet)
 			// (i)<s>
 			TRACE("fare(sub)\n");
 
-			fare_tmp = FARE_INFO::Fare_sub_f(_total_jr_sales_km);
+			fare_tmp = FareKernel::Fare(FK_SUB, _total_jr_sales_km, tax);
 
-			if ((FARE_INFO::tax != 5) &&
+			if ((tax != 5) &&
 			    IsIC_area(URBAN_ID(this->flag)) &&   /* 近郊区間(最短距離で算出可能) */
 				!useBullet) {             /* 新幹線乗車はIC運賃適用外 */
 				//ASSERT(companymask == (1 << (JR_EAST - 1)));  /* JR East only  */
@@ -10224,9 +10758,9 @@ void FARE_INFO::retr_fare(bool useBullet)
 			// (a) + this->calc_kmで算出
 			TRACE("fare(basic)\n");
 
-			fare_tmp = FARE_INFO::Fare_basic_f(_total_jr_calc_km);
+			fare_tmp = FareKernel::Fare(FK_BASIC, _total_jr_calc_km, tax);
 
-			if ((FARE_INFO::tax != 5) && /* IC運賃導入 */
+			if ((tax != 5) && /* IC運賃導入 */
 			    IsIC_area(URBAN_ID(this->flag)) &&   /* 近郊区間(最短距離で算出可能) */
 				!useBullet) {            /* 新幹線乗車はIC運賃適用外 */
 				//ASSERT(companymask == (1 << (JR_EAST - 1)));  /* JR East only  */
@@ -10246,13 +10780,13 @@ void FARE_INFO::retr_fare(bool useBullet)
 				// (r) sales_km add
 				TRACE("fare(hla)\n");		// TRACE("fare(r,r)\n");
 				_total_jr_fare += FARE_INFO::Fare_table("hla", "ha",
-				                                    this->hokkaido_sales_km);
+				                                    this->hokkaido_sales_km, tax);
                 //過去DBもつかうんで。。。ASSERT(FALSE); // 北海道新幹線ができてから不要
 			} else { /* 幹線のみ／幹線+地方交通線で10km越え */
 				// (o) calc_km add
 				TRACE("fare(add, ha)\n");	// TRACE("fare(opq, o)\n");
 				_total_jr_fare += FARE_INFO::Fare_table("add", "ha",
-				                                    this->hokkaido_calc_km);
+				                                    this->hokkaido_calc_km, tax);
 			}
 		}				// JR九あり？
 		if (0 < (this->kyusyu_sales_km + this->kyusyu_calc_km)) {
@@ -10262,7 +10796,7 @@ void FARE_INFO::retr_fare(bool useBullet)
 			// JR九州側(q)<s><c> 加算
 			TRACE("fare(add, ka)\n");	// TRACE("fare(opq, q)\n");
 			_total_jr_fare += FARE_INFO::Fare_table("add", "ka",
-			                                    this->kyusyu_calc_km);
+			                                    this->kyusyu_calc_km, tax);
 		}				// JR四あり?
 		if (0 < (this->shikoku_sales_km + this->shikoku_calc_km)) {
 			/* JR西 + JR四 */
@@ -10271,7 +10805,7 @@ void FARE_INFO::retr_fare(bool useBullet)
 			// JR四国側(p)<s><c> 加算
 			TRACE("fare(add, sa)\n");	// TRACE("fare(opq, p)\n");
 			_total_jr_fare += FARE_INFO::Fare_table("add", "sa",
-			                                    this->shikoku_calc_km);
+			                                    this->shikoku_calc_km, tax);
 		}				// JR北
 	} else if (0 < (this->hokkaido_sales_km + this->hokkaido_calc_km)) {
 		/* JR北海道のみ */
@@ -10284,12 +10818,12 @@ void FARE_INFO::retr_fare(bool useBullet)
 			/* JR北海道 地方交通線のみ */
 			// (j)<s>
 			TRACE("fare(hokkaido_sub)\n");
-			_total_jr_fare = FARE_INFO::Fare_hokkaido_sub(_total_jr_sales_km);
+			_total_jr_fare = FareKernel::Fare(FK_HOKKAIDO_SUB, _total_jr_sales_km, tax);
 		} else {
 			/* JR北海道 幹線のみ、幹線+地方交通線 */
 			// (f)<c>
 			TRACE("fare(hokkaido-basic)\n");
-			_total_jr_fare = FARE_INFO::Fare_hokkaido_basic(_total_jr_calc_km);
+			_total_jr_fare = FareKernel::Fare(FK_HOKKAIDO_BASIC, _total_jr_calc_km, tax);
 		}				// JR九
 	} else if (0 < (this->kyusyu_sales_km + this->kyusyu_calc_km)) {
 		/* JR九州のみ */
@@ -10301,15 +10835,15 @@ void FARE_INFO::retr_fare(bool useBullet)
 			/* JR九州 地方交通線 */
 			TRACE("fare(ls)'k'\n");
 			/* (l) */
-			_total_jr_fare = FARE_INFO::Fare_table(_total_jr_calc_km, _total_jr_sales_km, 'k');
+			_total_jr_fare = FARE_INFO::Fare_table(_total_jr_calc_km, _total_jr_sales_km, 'k', tax);
 
 		}
 		if (_total_jr_fare == 0) {
 			/* JR九州 幹線のみ、幹線＋地方交通線、地方交通線のみ の(l), (n)非適用 */
 			// (h)<s><c>
 			TRACE("fare(kyusyu)\n");			// TRACE("fare(m, h)[9]\n");
-			_total_jr_fare = FARE_INFO::Fare_kyusyu(_total_jr_sales_km,
-			                                    _total_jr_calc_km);
+			_total_jr_fare = FareKernel::Fare(FK_KYUSYU, _total_jr_sales_km,
+			                                  _total_jr_calc_km, tax);
 		}
 
 	} else if (0 < (this->shikoku_sales_km + this->shikoku_calc_km)) {
@@ -10322,15 +10856,15 @@ void FARE_INFO::retr_fare(bool useBullet)
 			/* JR四国 地方交通線 */
 			TRACE("fare(ls)'s'\n");
 			/* (k) */
-			_total_jr_fare = FARE_INFO::Fare_table(_total_jr_calc_km, _total_jr_sales_km, 's');
+			_total_jr_fare = FARE_INFO::Fare_table(_total_jr_calc_km, _total_jr_sales_km, 's', tax);
 
 		}
 		if (_total_jr_fare == 0) {
 			/* JR四国 幹線のみ、幹線＋地方交通線、地方交通線のみ の(l), (n)非適用 */
 			// (g)<s><c>
 			TRACE("fare(shikoku)[4]\n");		// TRACE("fare(m, g)[4]\n");
-			_total_jr_fare = FARE_INFO::Fare_shikoku(_total_jr_sales_km,
-			                                     _total_jr_calc_km);
+			_total_jr_fare = FareKernel::Fare(FK_SHIKOKU, _total_jr_sales_km,
+			                                  _total_jr_calc_km, tax);
 		}
 
 	} else {
@@ -10363,9 +10897,10 @@ int32_t FARE_INFO::days_ticket(int32_t sales_km)
 //	@param [in]     station_id1   駅1
 //	@param [in]     station_id2   駅2
 //	@param [in/out] compantFare   [0]区間運賃 / [1]小児運賃 / [2]学割運賃(非適用は0) / [3]併算割引運賃有無(1=無)
+//	@param [in]     tax           消費税率(%)
 //	@return true : success / false : failuer
 //
-bool FARE_INFO::Fare_company(int32_t station_id1, int32_t station_id2, CompanyFare* campanyFare)
+bool FARE_INFO::Fare_company(int32_t station_id1, int32_t station_id2, CompanyFare* campanyFare, int32_t tax)
 {
 	char sql[256];
 	int32_t fare_work;
@@ -10375,7 +10910,7 @@ bool FARE_INFO::Fare_company(int32_t station_id1, int32_t station_id2, CompanyFa
 " ((station_id1=?1 and station_id2=?2) or"
 "  (station_id1=?2 and station_id2=?1))";
 
-	sqlite3_snprintf(sizeof(sql), sql, tsql, FARE_INFO::tax);
+	sqlite3_snprintf(sizeof(sql), sql, tsql, tax);
 	DBO dbo(DBS::getInstance()->compileSql(sql, false));
 	dbo.setParam(1, station_id1);
 	dbo.setParam(2, station_id2);
@@ -10403,9 +10938,10 @@ bool FARE_INFO::Fare_company(int32_t station_id1, int32_t station_id2, CompanyFa
 //	@param [in] tbl  table name postfix"
 //	@param [in] field name of column for retrieve fare in table.
 //	@param [in] km
+//	@param [in] tax 消費税率(%)
 //	@return fare [yen]
 //
-int32_t	FARE_INFO::Fare_table(const char* tbl, const char* field, int32_t km)
+int32_t	FARE_INFO::Fare_table(const char* tbl, const char* field, int32_t km, int32_t tax)
 {
 	char sql[128];
 	static const char tsql[] =
@@ -10413,7 +10949,7 @@ int32_t	FARE_INFO::Fare_table(const char* tbl, const char* field, int32_t km)
 
     TRACE("Fare_table(%s, %s, %d)\n", tbl, field, km);
 
-	sqlite3_snprintf(sizeof(sql), sql, tsql, field, FARE_INFO::tax, tbl, field, FARE_INFO::tax);
+	sqlite3_snprintf(sizeof(sql), sql, tsql, field, tax, tbl, field, tax);
 	DBO dbo(DBS::getInstance()->compileSql(sql));
 	dbo.setParam(1, KM(km));
 	if (dbo.moveNext()) {
@@ -10428,11 +10964,12 @@ int32_t	FARE_INFO::Fare_table(const char* tbl, const char* field, int32_t km)
 //
 //	@param [in] c   'h'=hokkaido, 'e'= east or central or west
 //	@param [in] km
+//	@param [in] tax 消費税率(%)
 //	@retval 0 db error
 //	@retval Number of negative ; -fare
 //	@retval Positive of negative ; c_km
 //
-int32_t	FARE_INFO::Fare_table(const char* tbl, char c, int32_t km)
+int32_t	FARE_INFO::Fare_table(const char* tbl, char c, int32_t km, int32_t tax)
 {
 	char* sql;
 	int32_t ckm;
@@ -10442,7 +10979,7 @@ int32_t	FARE_INFO::Fare_table(const char* tbl, char c, int32_t km)
 
     sql = sqlite3_mprintf(
 	"select ckm, %c%x from t_fare%s where km<=? order by km desc limit(1)",
-	                      c, FARE_INFO::tax, tbl);
+	                      c, tax, tbl);
 
 	DBO dbo(DBS::getInstance()->compileSql(sql));
 	sqlite3_free(sql);
@@ -10467,9 +11004,10 @@ int32_t	FARE_INFO::Fare_table(const char* tbl, char c, int32_t km)
 //	@param [in] dkm   擬制キロ
 //	@param [in] skm	  営業キロ
 //	@param [in] c     's': 四国 / 'k': 九州
+//	@param [in] tax   消費税率(%)
 //	@return value
 //
-int32_t FARE_INFO::Fare_table(int32_t dkm, int32_t skm, char c)
+int32_t FARE_INFO::Fare_table(int32_t dkm, int32_t skm, char c, int32_t tax)
 {
 	int32_t fare;
 
@@ -10478,7 +11016,7 @@ int32_t FARE_INFO::Fare_table(int32_t dkm, int32_t skm, char c)
     char* sql = sqlite3_mprintf(
 #if 1
 	"select %c%x from t_farels where dkm=?2 and (skm=-1 or skm=?1)",
-	c, FARE_INFO::tax);
+	c, tax);
 #else
 "select k,l from t_farels where "
 "(-1=(select skm from t_farels where skm=(select max(skm) from t_farels where skm<=?1))"
@@ -10508,10 +11046,11 @@ int32_t FARE_INFO::Fare_table(int32_t dkm, int32_t skm, char c)
 //	@param [in] line_id     路線
 //	@param [in] station_id1 駅1
 //	@param [in] station_id2 駅2
+//	@param [in] tax         消費税率(%)
 //
 //	@return 駅1～駅2に運賃と区別区間が含まれている場合その加算額を返す
 //
-int32_t FARE_INFO::CheckSpecificFarePass(int32_t line_id, int32_t station_id1, int32_t station_id2)
+int32_t FARE_INFO::CheckSpecificFarePass(int32_t line_id, int32_t station_id1, int32_t station_id2, int32_t tax)
 {
 	char* sql = sqlite3_mprintf(
 "select station_id1, station_id2, fare%up from t_farespp f where kind=0 and exists ("
@@ -10549,7 +11088,7 @@ int32_t FARE_INFO::CheckSpecificFarePass(int32_t line_id, int32_t station_id1, i
 "			and (station_id=?2 or"
 "				 station_id=?3)))"
 " order by fare%up desc"
-" limit(1)", FARE_INFO::tax, FARE_INFO::tax);
+" limit(1)", tax, tax);
 
 	DBO dbo(DBS::getInstance()->compileSql(sql));
 	dbo.setParam(1, line_id);
@@ -10571,10 +11110,11 @@ int32_t FARE_INFO::CheckSpecificFarePass(int32_t line_id, int32_t station_id1, i
 //
 //	@param [in] station_id1 駅1(departureStationId)
 //	@param [in] station_id2 駅2(arriveStationId)
+//	@param [in] tax         消費税率(%)
 //
 //	@return 特別区間運賃
 //
-int32_t FARE_INFO::SpecificFareLine(int32_t station_id1, int32_t station_id2, int32_t kind)
+int32_t FARE_INFO::SpecificFareLine(int32_t station_id1, int32_t station_id2, int32_t kind, int32_t tax)
 {
 	char sql[256];
 
@@ -10583,7 +11123,7 @@ int32_t FARE_INFO::SpecificFareLine(int32_t station_id1, int32_t station_id2, in
 	" ((station_id1=?1 and station_id2=?2) or"
 	"  (station_id1=?2 and station_id2=?1))";
 
-	sqlite3_snprintf(sizeof(sql), sql, tsql, FARE_INFO::tax);
+	sqlite3_snprintf(sizeof(sql), sql, tsql, tax);
 
 	DBO dbo(DBS::getInstance()->compileSql(sql));
 	dbo.setParam(1, station_id1);
@@ -10602,40 +11142,41 @@ int32_t FARE_INFO::SpecificFareLine(int32_t station_id1, int32_t station_id2, in
 //	calc_fare() => retr_fare() =>
 //
 //	@param [in] km    計算キロ
+//	@param [in] tax   消費税率(%)
 //	@return 運賃額
 //
-int32_t FARE_INFO::Fare_basic_f(int32_t km)
+int32_t FARE_INFO::Fare_basic_f(int32_t km, int32_t tax)
 {
 	int32_t fare;
 	int32_t c_km;
 
-	fare = FARE_INFO::Fare_table("bspekm", "b", km);
+	fare = FARE_INFO::Fare_table("bspekm", "b", km, tax);
 	if (0 != fare) {
 		return fare;
 	}
     /* After 2025, less than 101 km doesn't pass  the following block. */
 	if (km < 31) {							// 1 to 3km
-        if (FARE_INFO::tax == 10) {
+        if (tax == 10) {
             return 147;
-		} else if (FARE_INFO::tax == 5) {
+		} else if (tax == 5) {
 			return 140;
 		} else {
 			return 144;
 		}
 	}
 	if (km < 61) {							// 4 to 6km
-        if (FARE_INFO::tax == 10) {
+        if (tax == 10) {
             return 189;
-		} else if (FARE_INFO::tax == 5) {
+		} else if (tax == 5) {
 			return 180;
 		} else {
 			return 185;
 		}
 	}
 	if (km < 101) {							// 7 to 10km
-        if (FARE_INFO::tax == 10) {
+        if (tax == 10) {
             return 199;
-        } else if (FARE_INFO::tax == 5) {
+        } else if (tax == 5) {
 			return 190;
 		} else {
 			return 195;
@@ -10666,37 +11207,38 @@ int32_t FARE_INFO::Fare_basic_f(int32_t km)
 	} else {								// 100㎞越えは四捨五入
 		fare = (fare + 50000) / 100000 * 100;
 	}
-	return taxadd_ic(fare, FARE_INFO::tax);	// tax = +5%, 四捨五入
+	return taxadd_ic(fare, tax);	// tax = +5%, 四捨五入
 }
 
 //	sub: 地方交通線
 //	calc_fare() => retr_fare() =>
 //
 //	@param [in] km    営業キロ
+//	@param [in] tax   消費税率(%)
 //	@return 運賃額
 //
-int32_t FARE_INFO::Fare_sub_f(int32_t km)
+int32_t FARE_INFO::Fare_sub_f(int32_t km, int32_t tax)
 {
 	int32_t fare;
 	int32_t c_km;
 
-    if (FARE_INFO::tax != 10) {
+    if (tax != 10) {
         if (km < 31) {							// 1 to 3km
-            if (FARE_INFO::tax == 5) {
+            if (tax == 5) {
                 return 140;
             } else {
                 return 144;
             }
         }
         if (km < 61) {							// 4 to 6km
-            if (FARE_INFO::tax == 5) {
+            if (tax == 5) {
                 return 180;
             } else {  // 8%
                 return 185;
             }
         }
         if (km < 101) {							// 7 to 10km
-            if (FARE_INFO::tax == 5) {
+            if (tax == 5) {
                 return 200;
             } else {
                 return 206;
@@ -10708,7 +11250,7 @@ int32_t FARE_INFO::Fare_sub_f(int32_t km)
 		return -1;
 	}
 
-	c_km = Fare_table("lspekm", 'e', km);
+	c_km = Fare_table("lspekm", 'e', km, tax);
 	if (c_km == 0) {
 		ASSERT(FALSE);
 		return -1;
@@ -10736,47 +11278,48 @@ int32_t FARE_INFO::Fare_sub_f(int32_t km)
 	} else {				// 100㎞越えは四捨五入
 		fare = (fare + 50000) / 100000 * 100;
 	}
-	return taxadd_ic(fare, FARE_INFO::tax);
+	return taxadd_ic(fare, tax);
 }
 
 //	b: 電車特定区間(東京)
 //	calc_fare() => retr_fare() =>
 //
 //	@param [in] km    営業キロ
+//	@param [in] tax   消費税率(%)
 //	@return 運賃額
 //
-int32_t FARE_INFO::Fare_tokyo_f(int32_t km)
+int32_t FARE_INFO::Fare_tokyo_f(int32_t km, int32_t tax)
 {
 	int32_t fare;
 	int32_t c_km;
 
-	fare = FARE_INFO::Fare_table("bspekm", "t", km);
+	fare = FARE_INFO::Fare_table("bspekm", "t", km, tax);
 	if (0 != fare) {
 		return fare;
 	}
     /* After 2025, less than 101 km doesn't pass  the following block. */
 	if (km < 31) {							// 1 to 3km
-        if (FARE_INFO::tax == 10) {
+        if (tax == 10) {
             return 136;
-        } else if (FARE_INFO::tax == 5) {
+        } else if (tax == 5) {
 			return 130;
 		} else {
 			return 133;
 		}
 	}
 	if (km < 61) {							// 4 to 6km
-        if (FARE_INFO::tax == 10) {
+        if (tax == 10) {
             return 157;
-        } else if (FARE_INFO::tax == 5) {
+        } else if (tax == 5) {
 			return 150;
 		} else {
 			return 154;
 		}
 	}
 	if (km < 101) {							// 7 to 10km
-        if (FARE_INFO::tax == 10) {
+        if (tax == 10) {
             return 168;
-        } else if (FARE_INFO::tax == 5) {
+        } else if (tax == 5) {
 			return 160;
 		} else {
 			return 165;
@@ -10807,47 +11350,48 @@ int32_t FARE_INFO::Fare_tokyo_f(int32_t km)
 	} else {				// 100㎞越えは四捨五入
 		fare = (fare + 50000) / 100000 * 100;
 	}
-	return taxadd_ic(fare, FARE_INFO::tax);
+	return taxadd_ic(fare, tax);
 }
 
 //	C: 電車特定区間(大阪)
 //	calc_fare() => retr_fare() =>
 //
 //	@param [in] km    営業キロ
+//	@param [in] tax   消費税率(%)
 //	@return 運賃額
 //
-int32_t FARE_INFO::Fare_osaka(int32_t km)
+int32_t FARE_INFO::Fare_osaka(int32_t km, int32_t tax)
 {
 	int32_t fare;
 	int32_t c_km;
 
-	fare = FARE_INFO::Fare_table("bspekm", "o", km);
+	fare = FARE_INFO::Fare_table("bspekm", "o", km, tax);
 	if (0 != fare) {
 		return fare;
 	}
     /* After 2025, less than 101 km doesn't pass  the following block. */
     if (km < 31) {							// 1 to 3km
-        if (FARE_INFO::tax == 10) {
+        if (tax == 10) {
             return 140;
-        } else if (FARE_INFO::tax == 5) {
+        } else if (tax == 5) {
 			return 120;
 		} else {
 			return 120;
 		}
 	}
 	if (km < 61) {							// 4 to 6km
-        if (FARE_INFO::tax == 10) {
+        if (tax == 10) {
             return 170;
-        } else if (FARE_INFO::tax == 5) {
+        } else if (tax == 5) {
 			return 160;
 		} else {
 			return 160;
 		}
 	}
 	if (km < 101) {							// 7 to 10km
-        if (FARE_INFO::tax == 10) {
+        if (tax == 10) {
             return 190;
-        } else if (FARE_INFO::tax == 5) {
+        } else if (tax == 5) {
 			return 170;
 		} else {
 			return 180;
@@ -10879,47 +11423,48 @@ int32_t FARE_INFO::Fare_osaka(int32_t km)
 	} else {								// 100㎞越えは四捨五入
 		fare = (fare + 50000) / 100000 * 100;
 	}
-	return taxadd(fare, FARE_INFO::tax);	// tax = +5%, 四捨五入
+	return taxadd(fare, tax);	// tax = +5%, 四捨五入
 }
 
 //	d: 電車特定区間(山手線)
 //	calc_fare() => retr_fare() =>
 //
 //	@param [in] km    営業キロ
+//	@param [in] tax   消費税率(%)
 //	@return 運賃額
 //
-int32_t FARE_INFO::Fare_yamate_f(int32_t km)
+int32_t FARE_INFO::Fare_yamate_f(int32_t km, int32_t tax)
 {
 	int32_t fare;
 	int32_t c_km;
 
-	fare = FARE_INFO::Fare_table("bspekm", "y", km);
+	fare = FARE_INFO::Fare_table("bspekm", "y", km, tax);
 	if (0 != fare) {
 		return fare;
 	}
     /* After 2025, less than 101 km doesn't pass  the following block. */
 	if (km < 31) {							// 1 to 3km
-        if (FARE_INFO::tax == 10) {
+        if (tax == 10) {
             return 146;
-        } else if (FARE_INFO::tax == 5) {
+        } else if (tax == 5) {
 			return 130;
 		} else {
 			return 133;
 		}
 	}
 	if (km < 61) {							// 4 to 6km
-        if (FARE_INFO::tax == 10) {
+        if (tax == 10) {
             return 167;
-        } else if (FARE_INFO::tax == 5) {
+        } else if (tax == 5) {
 			return 150;
 		} else {
 			return 154;
 		}
 	}
 	if (km < 101) {							// 7 to 10km
-        if (FARE_INFO::tax == 10) {
+        if (tax == 10) {
             return 178;
-        } else if (FARE_INFO::tax == 5) {
+        } else if (tax == 5) {
 			return 160;
 		} else {
 			return 165;
@@ -10946,7 +11491,7 @@ int32_t FARE_INFO::Fare_yamate_f(int32_t km)
 	} else {								// 100㎞越えは四捨五入
 		fare = (fare + 50000) / 100000 * 100;
 	}
-	return taxadd_ic(fare, FARE_INFO::tax);	// tax = +5%, 四捨五入
+	return taxadd_ic(fare, tax);	// tax = +5%, 四捨五入
 }
 
 //	e: 電車特定区間(大阪環状線)
@@ -10954,35 +11499,36 @@ int32_t FARE_INFO::Fare_yamate_f(int32_t km)
 //  2025.4.1 廃止
 //
 //	@param [in] km    営業キロ
+//	@param [in] tax   消費税率(%)
 //	@return 運賃額
 //
-int32_t FARE_INFO::Fare_osakakan(int32_t km)
+int32_t FARE_INFO::Fare_osakakan(int32_t km, int32_t tax)
 {
 	int32_t fare;
 	int32_t c_km;
 
 	if (km < 31) {							// 1 to 3km
-        if (FARE_INFO::tax == 10) {
+        if (tax == 10) {
             return 130;
-        } else if (FARE_INFO::tax == 5) {
+        } else if (tax == 5) {
 			return 120;
 		} else {
 			return 120;
 		}
 	}
 	if (km < 61) {							// 4 to 6km
-        if (FARE_INFO::tax == 10) {
+        if (tax == 10) {
             return 160;
-        } else if (FARE_INFO::tax == 5) {
+        } else if (tax == 5) {
 			return 160;
 		} else {
 			return 160;
 		}
 	}
 	if (km < 101) {							// 7 to 10km
-        if (FARE_INFO::tax == 10) {
+        if (tax == 10) {
             return 180;
-        } else if (FARE_INFO::tax == 5) {
+        } else if (tax == 5) {
 			return 170;
 		} else {
 			return 180;
@@ -11009,21 +11555,22 @@ int32_t FARE_INFO::Fare_osakakan(int32_t km)
 	} else {								// 100㎞越えは四捨五入
 		fare = (fare + 50000) / 100000 * 100;
 	}
-	return taxadd(fare, FARE_INFO::tax);	// tax = +5%, 四捨五入
+	return taxadd(fare, tax);	// tax = +5%, 四捨五入
 }
 
 //	f: JR北海道幹線
 //	calc_fare() => retr_fare() =>
 //
 //	@param [in] km    計算キロ
+//	@param [in] tax   消費税率(%)
 //	@return 運賃額
 //
-int32_t FARE_INFO::Fare_hokkaido_basic(int32_t km)
+int32_t FARE_INFO::Fare_hokkaido_basic(int32_t km, int32_t tax)
 {
 	int32_t fare;
 	int32_t c_km;
 
-	fare = FARE_INFO::Fare_table("bspekm", "h", km);
+	fare = FARE_INFO::Fare_table("bspekm", "h", km, tax);
 	if (0 != fare) {
 		return fare;
 	}
@@ -11042,16 +11589,17 @@ int32_t FARE_INFO::Fare_hokkaido_basic(int32_t km)
     // 100㎞越えは四捨五入
     fare = (fare + 50000) / 100000 * 100;
 
-    return taxadd(fare, FARE_INFO::tax);	// tax = +5%, 四捨五入
+    return taxadd(fare, tax);	// tax = +5%, 四捨五入
 }
 
 //	JR北海道地方交通線
 //	calc_fare() => retr_fare() =>
 //
 //	@param [in] km    営業キロ
+//	@param [in] tax   消費税率(%)
 //	@return 運賃額
 //
-int32_t FARE_INFO::Fare_hokkaido_sub(int32_t km)
+int32_t FARE_INFO::Fare_hokkaido_sub(int32_t km, int32_t tax)
 {
 	int32_t fare;
 	int32_t c_km;
@@ -11061,7 +11609,7 @@ int32_t FARE_INFO::Fare_hokkaido_sub(int32_t km)
 		return -1;
 	}
 
-	c_km = Fare_table("lspekm", 'h', km); /* under 800km */
+	c_km = Fare_table("lspekm", 'h', km, tax); /* under 800km */
 	if (c_km == 0) {
 		ASSERT(FALSE);
 		return -1;
@@ -11089,7 +11637,7 @@ int32_t FARE_INFO::Fare_hokkaido_sub(int32_t km)
 	} else {				// 100㎞越えは四捨五入
 		fare = (fare + 50000) / 100000 * 100;
 	}
-	return taxadd(fare, FARE_INFO::tax);
+	return taxadd(fare, tax);
 }
 
 //	g: JR四国 幹線
@@ -11097,16 +11645,17 @@ int32_t FARE_INFO::Fare_hokkaido_sub(int32_t km)
 //
 //	@param [in] skm    営業キロ
 //	@param [in] ckm    計算キロ
+//	@param [in] tax    消費税率(%)
 //	@return 運賃額
 //
-int32_t FARE_INFO::Fare_shikoku(int32_t skm, int32_t ckm)
+int32_t FARE_INFO::Fare_shikoku(int32_t skm, int32_t ckm, int32_t tax)
 {
 	int32_t fare;
 	int32_t c_km;
 
 	/* JTB時刻表 C-3表 */
 	if (ckm != skm) {
-        if (FARE_INFO::tax == 10) {
+        if (tax == 10) {
                 /* JR四国 幹線+地方交通線 */
                 /* (m) */
 #if 0 /* (2023.4 廃止) */
@@ -11116,7 +11665,7 @@ int32_t FARE_INFO::Fare_shikoku(int32_t skm, int32_t ckm)
                 return 240;	/* \ */
             }
 #endif
-        } else if (FARE_INFO::tax == 5) {
+        } else if (tax == 5) {
 			/* JR四国 幹線+地方交通線 */
 			/* (m) */
 			if ((KM(ckm) == 4) && (KM(skm) == 3)) {
@@ -11136,7 +11685,7 @@ int32_t FARE_INFO::Fare_shikoku(int32_t skm, int32_t ckm)
 		}
 	}
 
-	fare = FARE_INFO::Fare_table("bspekm", "s", ckm);
+	fare = FARE_INFO::Fare_table("bspekm", "s", ckm, tax);
 	if (0 != fare) {
 		return fare;
 	}
@@ -11155,7 +11704,7 @@ int32_t FARE_INFO::Fare_shikoku(int32_t skm, int32_t ckm)
 		ASSERT(FALSE);
 		c_km = 0;
 	}
-    if (FARE_INFO::tax != 10) {
+    if (tax != 10) {
             /* JR四国 幹線+地方交通線 */
             /* (m) */
         if (6000 <= c_km) {
@@ -11187,7 +11736,7 @@ int32_t FARE_INFO::Fare_shikoku(int32_t skm, int32_t ckm)
 	} else {								// 100㎞越えは四捨五入
 		fare = (fare + 50000) / 100000 * 100;
 	}
-	return taxadd(fare, FARE_INFO::tax);	// tax = +5%, 四捨五入
+	return taxadd(fare, tax);	// tax = +5%, 四捨五入
 }
 
 //	h: JR九州 幹線
@@ -11195,16 +11744,17 @@ int32_t FARE_INFO::Fare_shikoku(int32_t skm, int32_t ckm)
 //
 //	@param [in] skm    営業キロ
 //	@param [in] ckm    計算キロ
+//	@param [in] tax    消費税率(%)
 //	@return 運賃額
 //
-int32_t FARE_INFO::Fare_kyusyu(int32_t skm, int32_t ckm)
+int32_t FARE_INFO::Fare_kyusyu(int32_t skm, int32_t ckm, int32_t tax)
 {
 	int32_t fare;
 	int32_t c_km;
 
 	/* JTB時刻表 C-3表 */
 	if (ckm != skm) {
-        if (FARE_INFO::tax == 10) {
+        if (tax == 10) {
             /* JR九州 幹線+地方交通線 */
             /* (n) */
             if ((KM(ckm) == 4) && (KM(skm) == 3)) {
@@ -11212,7 +11762,7 @@ int32_t FARE_INFO::Fare_kyusyu(int32_t skm, int32_t ckm)
             } else if ((KM(ckm) == 11) && (KM(skm) == 10)) {
                 return 320;	/* \ */
             }
-        } else if (FARE_INFO::tax == 5) {
+        } else if (tax == 5) {
 			/* JR九州 幹線+地方交通線 */
 			/* (n) */
 			if ((KM(ckm) == 4) && (KM(skm) == 3)) {
@@ -11231,7 +11781,7 @@ int32_t FARE_INFO::Fare_kyusyu(int32_t skm, int32_t ckm)
 		}
 	}
 
-	fare = FARE_INFO::Fare_table("bspekm", "k", ckm);
+	fare = FARE_INFO::Fare_table("bspekm", "k", ckm, tax);
 	if (0 != fare) {
 		return fare;
 	}
@@ -11252,7 +11802,7 @@ int32_t FARE_INFO::Fare_kyusyu(int32_t skm, int32_t ckm)
 		c_km = 0;
 	}
 
-    if (FARE_INFO::tax != 10) {
+    if (tax != 10) {
         if (6000 <= c_km) {
             fare = 1775 * 3000 + 1285 * (6000 - 3000) + 705 * (c_km - 6000);
         } else if (3000 < c_km) {
@@ -11284,5 +11834,5 @@ int32_t FARE_INFO::Fare_kyusyu(int32_t skm, int32_t ckm)
 	} else {									// 100㎞越えは四捨五入
 		fare = (fare + 50000) / 100000 * 100;
 	}
-	return taxadd(fare, FARE_INFO::tax);	// tax = +5%, 四捨五入
+	return taxadd(fare, tax);	// tax = +5%, 四捨五入
 }
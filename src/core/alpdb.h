@@ -16,6 +16,7 @@ typedef struct {
 
 using namespace std;
 #include <vector>
+#include <string_view>
 
 /*!	@file alpdb core logic implement.
  *	Copyright(c) sutezo9@me.com 2012.
@@ -458,6 +459,30 @@ public:
 		return !end || compnda;
 	}
 
+    // 運賃計算結果キャッシュのキー
+    //  UI側からセットするフラグ(no_rule, meihan_city_flag, urban_neerest, rule115, osakakan_detour,
+    //  notsamekokurahakatashinzai 等)に加え、add()/calcFare()がセットするフラグも含める
+    //  (同じ経路を同じ手順で組み立てれば同じ値になる)
+    uint64_t fareKeyBits() const {
+        const bool b[] = {
+            no_rule, meihan_city_flag, meihan_city_enable, jrtokaistock_applied, jrtokaistock_enable,
+            osakakan_detour, notsamekokurahakatashinzai, osakakan_1dir, osakakan_2dir,
+            compncheck, compnpass, compnda, compnbegin, compnend, compnterm,
+            tokai_shinkansen, bullet_line, bJrTokaiOnly, end, rule88, rule69, rule70,
+            special_fare_enable, rule70bullet, rule16_5, ter_begin_oosaka, ter_fin_oosaka,
+            jctsp_route_change, trackmarkctl,
+        };
+        uint64_t bits = ((uint64_t)rule86or87 << 0) | ((uint64_t)(uint8_t)rule115 << 8) |
+                        ((uint64_t)(uint8_t)urban_neerest << 16) | ((uint64_t)osakaKanPass << 24);
+        uint32_t i;
+        for (i = 0; i < NumOf(b); i++) {
+            if (b[i]) {
+                bits |= (uint64_t)1 << (32 + i);
+            }
+        }
+        return bits;
+    }
+
     void terCityReset() {
         rule86or87 &= 0x40;
         ter_begin_oosaka	= false;      //21 大阪・新大阪
@@ -640,9 +665,25 @@ public:
 
 class Route;
 
+/* 運賃計算の出力要求(FARE_INFO::setOutputMask())
+ * 大人運賃・キロ程は常に計算する. 要求しなかった項目は計算しないか0を返す
+ * 114条の判定は小児・学割などの運賃が適用後の運賃から決まるので、FARE_OUT_FARESの
+ * いずれかを要求すれば行う(FARE_OUT_RULE114は判定結果を出力するかどうかのみ)
+ */
+#define FARE_OUT_CHILD			0x01	/* 小児運賃 */
+#define FARE_OUT_ACADEMIC		0x02	/* 学割運賃 */
+#define FARE_OUT_IC				0x04	/* IC運賃 */
+#define FARE_OUT_STOCK			0x08	/* 株主優待割引運賃 */
+#define FARE_OUT_RULE114		0x10	/* 114条適用判定の結果 */
+#define FARE_OUT_ROUNDTRIP		0x20	/* 往復運賃 */
+#define FARE_OUT_ROUTE_STRING	0x40	/* 経路文字列(showFare()は全項目の要求が必要) */
+#define FARE_OUT_ALL			0x7f
+#define FARE_OUT_FARES			(FARE_OUT_ALL & ~FARE_OUT_ROUTE_STRING)	/* 114条の判定が要る項目 */
+
 class FARE_INFO {
 public:
-	FARE_INFO() { reset(); FARE_INFO::tax = TAX; }
+	FARE_INFO() { reset(); tax = TAX; output_mask = FARE_OUT_ALL; }
+	explicit FARE_INFO(int32_t tax_) { reset(); tax = tax_; output_mask = FARE_OUT_ALL; }
 private:
 	int32_t sales_km;			//*** 有効日数計算用(会社線含む)
 
@@ -682,7 +723,8 @@ private:
 	int32_t jr_fare;					//***
 	int32_t fare_ic;					//*** 0以外で有効
 	int32_t avail_days;					//***
-	static int32_t tax;					/* 消費税 */
+	int32_t tax;						/* 消費税(%) reset()では変更しない */
+	uint32_t output_mask;				/* FARE_OUT_xxx reset()では変更しない */
 	int32_t companymask;
 
     /* 114 */
@@ -716,6 +758,36 @@ private:
         }
     } result_flag;
 
+    /* aggregate_fare_info()の1区間ごとの集計途中の値(FareAggregateCache) */
+    class AggregateState {
+    public:
+        int32_t sales_km;
+        int32_t base_sales_km;
+        int32_t base_calc_km;
+        int32_t kyusyu_sales_km;
+        int32_t kyusyu_calc_km;
+        int32_t hokkaido_sales_km;
+        int32_t hokkaido_calc_km;
+        int32_t shikoku_sales_km;
+        int32_t shikoku_calc_km;
+        int32_t company_fare;
+        int32_t company_fare_ac_discount;
+        int32_t company_fare_child;
+        int32_t brt_sales_km;
+        int32_t brt_calc_km;
+        int32_t flag;
+        int32_t companymask;
+        bool local_only;
+        bool local_only_as_hokkaido;
+        ResultFlag result_flag;
+        /* aggregate_fare_info()のループ変数 */
+        int32_t station_id_0;
+        bool osakakan_pass;
+        int32_t fare_add;
+    };
+    void saveAggregate(AggregateState* pState, int32_t station_id_0, bool osakakan_pass, int32_t fare_add) const;
+    void loadAggregate(const AggregateState& state);
+
 	void retr_fare(bool useBullet);
     void calc_brt_fare(const vector<RouteItem>& routeList);
 	int32_t aggregate_fare_info(RouteFlag *pRoute_flag, const vector<RouteItem>& routeList);
@@ -731,8 +803,20 @@ private:
                                      int32_t end_station_id,
                                      RouteFlag* pShort_route_flag,
                                      bool except_local = false);
+    bool reCalcFareForOptiomizeRouteNoCache(vector<RouteItem>* pShortRouteList,
+                                            int32_t start_station_id,
+                                            int32_t end_station_id,
+                                            RouteFlag* pShort_route_flag,
+                                            bool except_local);
+    static bool IsNotLowerFare(int32_t station_id1, int32_t station_id2, uint8_t useBulletTrain,
+                               uint32_t kinds, int32_t fare, int32_t tax);
 
 public:
+    void setTax(int32_t tax_) { tax = tax_; }
+    int32_t getTax() const { return tax; }
+    void setOutputMask(uint32_t mask) { output_mask = mask & FARE_OUT_ALL; }
+    uint32_t getOutputMask() const { return output_mask; }
+    bool isOutputRequested(uint32_t out) const { return (output_mask & out) != 0; }
     void setTerminal(int32_t begin_station_id, int32_t end_station_id) {
         beginTerminalId = begin_station_id;
         endTerminalId = end_station_id;
@@ -921,23 +1005,23 @@ public:
 
 private:
            int32_t      jrFare() const;
-	static int32_t	 	Fare_basic_f(int32_t km);
-	static int32_t	 	Fare_sub_f(int32_t km);
-	static int32_t	 	Fare_tokyo_f(int32_t km);
-	static int32_t	 	Fare_osaka(int32_t km);
-	static int32_t	 	Fare_yamate_f(int32_t km);
-	static int32_t	 	Fare_osakakan(int32_t km);
-	static int32_t	 	Fare_hokkaido_basic(int32_t km);
-	static int32_t	 	Fare_hokkaido_sub(int32_t km);
-	static int32_t	 	Fare_shikoku(int32_t skm, int32_t ckm);
-	static int32_t	 	Fare_kyusyu(int32_t skm, int32_t ckm);
+	static int32_t	 	Fare_basic_f(int32_t km, int32_t tax);
+	static int32_t	 	Fare_sub_f(int32_t km, int32_t tax);
+	static int32_t	 	Fare_tokyo_f(int32_t km, int32_t tax);
+	static int32_t	 	Fare_osaka(int32_t km, int32_t tax);
+	static int32_t	 	Fare_yamate_f(int32_t km, int32_t tax);
+	static int32_t	 	Fare_osakakan(int32_t km, int32_t tax);
+	static int32_t	 	Fare_hokkaido_basic(int32_t km, int32_t tax);
+	static int32_t	 	Fare_hokkaido_sub(int32_t km, int32_t tax);
+	static int32_t	 	Fare_shikoku(int32_t skm, int32_t ckm, int32_t tax);
+	static int32_t	 	Fare_kyusyu(int32_t skm, int32_t ckm, int32_t tax);
 	static int32_t		days_ticket(int32_t sales_km);
-	static bool      	Fare_company(int32_t station_id1, int32_t station_id2, FARE_INFO::CompanyFare* companyFare);
-	static int32_t		Fare_table(const char* tbl, const char* field, int32_t km);
-	static int32_t		Fare_table(int32_t dkm, int32_t skm, char c);
-	static int32_t		Fare_table(const char* tbl, char c, int32_t km);
-	static int32_t		CheckSpecificFarePass(int32_t line_id, int32_t station_id1, int32_t station_id2);
-	static int32_t		SpecificFareLine(int32_t station_id1, int32_t station_id2, int32_t kind);
+	static bool      	Fare_company(int32_t station_id1, int32_t station_id2, FARE_INFO::CompanyFare* companyFare, int32_t tax);
+	static int32_t		Fare_table(const char* tbl, const char* field, int32_t km, int32_t tax);
+	static int32_t		Fare_table(int32_t dkm, int32_t skm, char c, int32_t tax);
+	static int32_t		Fare_table(const char* tbl, char c, int32_t km, int32_t tax);
+	static int32_t		CheckSpecificFarePass(int32_t line_id, int32_t station_id1, int32_t station_id2, int32_t tax);
+	static int32_t		SpecificFareLine(int32_t station_id1, int32_t station_id2, int32_t kind, int32_t tax);
 	       vector<int32_t> getDistanceEx(int32_t line_id, int32_t station_id1, int32_t station_id2);
 	static vector<int32_t> GetDistanceEx(const RouteFlag& osakakan_aggregate, int32_t line_id, int32_t station_id1, int32_t station_id2);
 	static bool 		IsBulletInUrban(int32_t line_id, int32_t station_id1, int32_t station_id2, bool isRule88);
@@ -948,6 +1032,9 @@ private:
 	static int32_t	CheckOfRule89j(const vector<RouteItem> &route);
     static std::vector<RouteItem> IsHachikoLineHaijima(const std::vector<RouteItem>& route_list);
     static std::vector<std::vector<int>> getBRTrecord(int32_t line_id);
+    friend class FareKernel;
+    friend class FareAggregateCache;
+    friend class FareAggregateEntry;
 }; // FARE_INFO
 
 #define BCRULE70	            6		/* DB:lflag */
@@ -1018,14 +1105,13 @@ public:
 class DbidOf
 {
     DbidOf();
-    map<tstring, int> retrieve_id_pool;
 public:
     static DbidOf& getInstance() {
         static DbidOf obj;
         return obj;
     }
-    int32_t id_of_station(tstring name);
-    int32_t id_of_line(tstring name);
+    int32_t id_of_station(string_view name);
+    int32_t id_of_line(string_view name);
 };
 
 typedef struct
@@ -1083,7 +1169,8 @@ public:
     static tstring  Show_route(const vector<RouteItem>& routeList, const RouteFlag& rRoute_flag);
     static tstring  Show_route_full(const vector<RouteItem>& routeList, const RouteFlag& rRoute_flag);
 private:
-    static tstring  RouteOsakaKanDir(int32_t station_id1, int32_t station_id2, const RouteFlag& rRoute_flag);
+    static void     Append_route(tstring& result_str, const vector<RouteItem>& routeList, const RouteFlag& rRoute_flag);
+    static LPCTSTR  RouteOsakaKanDir(int32_t station_id1, int32_t station_id2, const RouteFlag& rRoute_flag);
 protected:
 public:
     static int32_t  DirOsakaKanLine(int32_t station_id_a, int32_t station_id_b);
@@ -1300,6 +1387,66 @@ public:
 public:
 };
 
+// changeNeerest()の最短経路木キャッシュ(LRU)
+//	キー: 探索開始駅, jct_mask, useBulletTrain(新幹線/会社線/地方交通線除外), 環状経路の除外分岐駅
+//
+class NeerestTreeCache
+{
+public:
+	static void		setCapacity(int32_t capacity);
+	static int32_t	capacity();
+	static int32_t	size();
+	static void		clear();
+	static int32_t	hitCount();
+	static int32_t	missCount();
+};
+
+// CalcRoute::calcFare()の運賃計算結果キャッシュ(LRU)
+//	キー: route_list_raw(路線, 駅, フラグ), RouteFlag::fareKeyBits()
+//
+class FareResultCache
+{
+public:
+	static void		setCapacity(int32_t capacity);
+	static int32_t	capacity();
+	static int32_t	size();
+	static void		clear();
+	static int32_t	hitCount();
+	static int32_t	missCount();
+};
+
+//	FARE_INFO::reCalcFareForOptiomizeRoute()の代替経路(最短・地方交通線を避けた最短・中心駅間最短)の運賃計算結果キャッシュ(LRU)
+//	キー: 発駅, 着駅, 地方交通線除外, 消費税率, RouteFlag::fareKeyBits()
+//
+class OptimizeRouteCache
+{
+public:
+	static void		setCapacity(int32_t capacity);
+	static int32_t	capacity();
+	static int32_t	size();
+	static void		clear();
+	static int32_t	hitCount();
+	static int32_t	missCount();
+	static int32_t	prunedCount();	/* 運賃の下限で探索・計算を省いた代替経路数 */
+};
+
+//	aggregate_fare_info()の区間ごとの集計値の保持(経路の追加・末尾削除で変わらない先頭部分を再利用)
+class FareAggregateCache
+{
+public:
+	static void		setCapacity(int32_t capacity);
+	static int32_t	capacity();
+	static int32_t	size();
+	static void		clear();
+	static int32_t	hitCount();		/* 再利用した区間数 */
+	static int32_t	missCount();	/* 集計した区間数 */
+private:
+	static uint64_t	KeyOf(const RouteFlag& rRoute_flag, int32_t tax);
+	static size_t	Resume(uint64_t key, const vector<RouteItem>& routeList, vector<FARE_INFO::AggregateState>* pStates);
+	static void		Store(uint64_t key, const vector<RouteItem>& routeList, const vector<FARE_INFO::AggregateState>& states, size_t reused);
+	friend class FARE_INFO;
+};
+
 
 class CalcRoute : public RouteList
 {
@@ -1319,7 +1466,7 @@ public:
     const vector<RouteItem>& routeList() const { return route_list_cooked; }
     int32_t         beginStationId();
     int32_t         endStationId();
-    void            checkOfRuleSpecificCoreLine(bool isCheckRule114 = false);
+    void            checkOfRuleSpecificCoreLine(bool isCheckRule114 = false, int32_t tax = TAX);
     int32_t            calcFare(FARE_INFO* pFi);
     int32_t            calcFare(FARE_INFO* pFi, int32_t count);
 public:
@@ -1327,6 +1474,7 @@ public:
     static tstring  BeginOrEndStationName(int32_t ident);
     int32_t  coreAreaIDByCityId(int32_t startEndFlg) const;
 private:
+    int32_t  calcFareNoCache(FARE_INFO* pFi);
     void   checkIsJRTokaiOnly(void);
 	static int32_t	CheckOfRule88j(vector<RouteItem> *route);
 public:
@@ -1357,20 +1505,37 @@ private:
         vector<RouteItem> route_list;
         vector<RouteItem> route_list_special;
         vector<RouteItem> route_list_replace;
-        map<uint32_t, uint32_t> collectCheckedJunction;
+        vector<bool> checkedJunction;   /* [stationId] 探索済みの分岐駅 */
         RouteFlag route_flag;
         bool is_start_city;  /* true : start is city otherwise arrive is city */
         bool is100km;        /* true : rule87 otherwise rule86 */
-        int32_t deep_count;
         int32_t locost_fare;
-        static vector<int32_t> ArrayOfLinesOfStationId(int32_t station_id);
+        // get86or87firstPoint()の探索スタック1段(再帰呼出し1回分)
+        class SearchFrame {
+        public:
+            int32_t cond_km;
+            int32_t base_sales_km;
+            int32_t base_line_id;
+            int32_t base_station_id;
+            vector<IntPair> junctions;      /* 100/200kmまでの分岐駅 */
+            size_t junction_index;          /* 処理中の分岐駅 */
+            const vector<int32_t>* lines;   /* 処理中の分岐駅の路線一覧(nullptr:未着手) */
+            size_t line_index;              /* 処理中の路線 */
+            int32_t step;                   /* 0:次の路線へ, 1:cond_km方向を探索中, 2:-cond_km方向を探索中 */
+            SearchFrame(int32_t cond_km_, int32_t base_sales_km_, int32_t base_line_id_, int32_t base_station_id_) :
+                cond_km(cond_km_), base_sales_km(base_sales_km_), base_line_id(base_line_id_), base_station_id(base_station_id_),
+                junction_index(0), lines(nullptr), line_index(0), step(0) {}
+        };
+        void enterSearchFrame(vector<SearchFrame>& stack, int32_t cond_km, int32_t base_sales_km, int32_t base_line_id, int32_t base_station_id);
+        bool nextSearchLine(SearchFrame& frame);
         int32_t sales_km_special;
+        int32_t tax;         /* 消費税(%) */
     public:
         Fare fare;
         int32_t  apply_terminal_station;
         int32_t  normal_fare;
     public:
-        CRule114();
+        CRule114(int32_t tax_ = TAX);
         bool check(const RouteFlag& rRouteFlag, uint32_t chk, uint32_t sk, 
                             const vector<RouteItem>& rRoute_list_no_applied_86or87, 
                             const vector<RouteItem>& rRoute_list_applied_86or87, 
@@ -0,0 +1,172 @@
+#include "core_area.h"
+
+#include <memory>
+
+////////////////////////////////////////////
+//	CoreAreaIndex
+//
+
+static unique_ptr<CoreAreaIndex> core_area_index;
+
+CoreAreaIndex::CoreAreaIndex()
+{
+	loaded = false;
+	for (int32_t i = 0; i < 16; i++) {
+		core_station[i] = 0;
+	}
+}
+
+//static
+//	インデックスを得る(初回のみ構築)
+//
+CoreAreaIndex& CoreAreaIndex::GetInstance()
+{
+	if (!core_area_index) {
+		core_area_index.reset(new CoreAreaIndex());
+	}
+	core_area_index->load();
+	return *core_area_index;
+}
+
+//static
+//	インデックスを破棄(DBを開き直した時)
+//
+void CoreAreaIndex::Clear()
+{
+	core_area_index.reset();
+}
+
+//private
+//	t_station, t_lines, t_rule86 を読み込む(初回のみ)
+//
+void CoreAreaIndex::load()
+{
+	int32_t max_station_id;
+
+	if (loaded) {
+		return;
+	}
+	DBO dbo_s = DBS::getInstance()->compileSql("select max(rowid) from t_station", false);
+	if (!dbo_s.isvalid() || !dbo_s.moveNext() || (dbo_s.getInt(0) <= 0)) {
+		return;		/* DB未オープン */
+	}
+	max_station_id = dbo_s.getInt(0);
+	station_attr.assign(max_station_id + 1, (1 << 30));
+
+	DBO dbo_a = DBS::getInstance()->compileSql("select rowid, sflg from t_station order by rowid", false);
+	while (dbo_a.moveNext()) {
+		int32_t station_id = dbo_a.getInt(0);
+		SPECIFICFLAG sflg = (SPECIFICFLAG)dbo_a.getInt(1);
+
+		if ((0 <= station_id) && (station_id <= max_station_id)) {
+			station_attr[station_id] = sflg;
+			if (((sflg & (1 << 4)) != 0) && (core_station[sflg & 15] == 0)) {
+				core_station[sflg & 15] = station_id;	/* 中心駅 */
+			}
+		}
+	}
+
+	DBO dbo_l = DBS::getInstance()->compileSql(
+"select l.line_id, l.station_id, l.sales_km, l.lflg, ifnull(t.sflg&15, 255) from t_lines l"
+" left join t_station t on t.rowid=l.station_id order by l.line_id, l.sales_km", false);
+	while (dbo_l.moveNext()) {
+		int32_t line_id = dbo_l.getInt(0);
+		SPECIFICFLAG lflg = (SPECIFICFLAG)dbo_l.getInt(3);
+
+		line_pos[line_id].push_back(LinePos(dbo_l.getInt(2), (IDENT)dbo_l.getInt(1),
+											(uint8_t)dbo_l.getInt(4), (lflg & (1u << 31)) == 0));
+	}
+
+	DBO dbo_r = DBS::getInstance()->compileSql(
+"select line_id1, city_id, station_id, line_id2 from t_rule86 order by city_id", false);
+	while (dbo_r.moveNext()) {
+		int32_t line_id = dbo_r.getInt(0);
+		int32_t city_id = dbo_r.getInt(1) & 255;
+
+		first_transfer[MAKEPAIR(line_id, city_id)].push_back(Station((IDENT)dbo_r.getInt(3), (IDENT)dbo_r.getInt(2)));
+	}
+	loaded = true;
+}
+
+//	駅の属性(t_station.sflg)
+//
+//	@param [in] station_id 駅
+//	@return sflg(駅がなければ bit30=1)
+//
+SPECIFICFLAG CoreAreaIndex::attrOfStation(int32_t station_id) const
+{
+	if ((station_id < 0) || ((int32_t)station_attr.size() <= station_id)) {
+		return (1 << 30);
+	}
+	return station_attr[station_id];
+}
+
+//	都区市内の中心駅
+//
+//	@param [in] city_no 都区市内No
+//	@return 中心駅(0:なし)
+//
+int32_t CoreAreaIndex::coreStation(int32_t city_no) const
+{
+	if ((city_no < 0) || (16 <= city_no)) {
+		return 0;
+	}
+	return core_station[city_no];
+}
+
+//	路線の駅間(両端含む)にある都区市内駅の数
+//
+//	@param [in] city_no     都区市内No(下位4bitのみ有効)
+//	@param [in] line_id     路線
+//	@param [in] station_id1 開始駅
+//	@param [in] station_id2 終了駅
+//	@return 駅数
+//
+int32_t CoreAreaIndex::countInCity(int32_t city_no, int32_t line_id, int32_t station_id1, int32_t station_id2) const
+{
+	map<int32_t, vector<LinePos>>::const_iterator itl = line_pos.find(line_id);
+	vector<LinePos>::const_iterator ite;
+	bool found = false;
+	int32_t min_km = 0;
+	int32_t max_km = 0;
+	int32_t count = 0;
+
+	if (itl == line_pos.end()) {
+		return 0;
+	}
+	for (ite = itl->second.cbegin(); ite != itl->second.cend(); ite++) {
+		if ((ite->stationId == station_id1) || (ite->stationId == station_id2)) {
+			if (!found) {
+				min_km = ite->salesKm;
+				found = true;
+			}
+			max_km = ite->salesKm;
+		}
+	}
+	if (!found) {
+		return 0;
+	}
+	for (ite = itl->second.cbegin(); (ite != itl->second.cend()) && (ite->salesKm <= max_km); ite++) {
+		if ((min_km <= ite->salesKm) && ite->enable && (ite->cityNo == (city_no & 0x0f))) {
+			count++;
+		}
+	}
+	return count;
+}
+
+//	進入/脱出路線から86条中心駅から最初の乗換駅までの路線と乗換駅(t_rule86)
+//
+//	@param [in] line_id 進入／脱出路線
+//	@param [in] city_id 都区市内Id
+//	@return [](lineId, stationId) city_id順
+//
+const vector<Station>& CoreAreaIndex::firstTransferStations(int32_t line_id, int32_t city_id) const
+{
+	static const vector<Station> empty;
+	map<PAIRIDENT, vector<Station>>::const_iterator ite = first_transfer.find(MAKEPAIR(line_id, city_id));
+
+	if (ite == first_transfer.end()) {
+		return empty;
+	}
+	return ite->second;
+}
@@ -0,0 +1,42 @@
+#ifndef _CORE_AREA_H__
+#define _CORE_AREA_H__
+
+#include "alpdb.h"
+
+/*!	@file core_area 特定都区市内(86, 87, 88条)判定用の駅属性・路線内都区市内位置インデックス.
+ *	駅属性(t_station.sflg, 都区市内No含む)、都区市内中心駅、路線ごとの駅の都区市内No(営業キロ昇順)、
+ *	中心駅から最初の乗換駅(t_rule86)をメモリに持つ.
+ *	初回参照時に構築し、DBを開き直したらClear()で破棄する.
+ */
+
+class CoreAreaIndex
+{
+	// 路線内駅(t_lines 1レコード)
+	class LinePos {
+	public:
+		int32_t salesKm;
+		IDENT stationId;
+		uint8_t cityNo;			// 都区市内No(sflg&15, 駅なしは255)
+		bool enable;			// lflg bit31=0
+		LinePos(int32_t salesKm_, IDENT stationId_, uint8_t cityNo_, bool enable_) :
+			salesKm(salesKm_), stationId(stationId_), cityNo(cityNo_), enable(enable_) {}
+	};
+	bool loaded;
+	vector<SPECIFICFLAG> station_attr;					// [stationId] sflg
+	int32_t core_station[16];							// [都区市内No] 中心駅
+	map<int32_t, vector<LinePos>> line_pos;				// [lineId] 営業キロ昇順
+	map<PAIRIDENT, vector<Station>> first_transfer;		// [MAKEPAIR(lineId, 都区市内Id)] 中心駅から最初の乗換駅
+
+	CoreAreaIndex();
+	void load();
+public:
+	static CoreAreaIndex& GetInstance();
+	static void Clear();
+
+	SPECIFICFLAG attrOfStation(int32_t station_id) const;
+	int32_t coreStation(int32_t city_no) const;
+	int32_t countInCity(int32_t city_no, int32_t line_id, int32_t station_id1, int32_t station_id2) const;
+	const vector<Station>& firstTransferStations(int32_t line_id, int32_t city_id) const;
+};
+
+#endif	/* _CORE_AREA_H__ */
@@ -0,0 +1,184 @@
+#include "fare_batch.h"
+
+////////////////////////////////////////////
+//	FareBatch
+//
+
+//static
+//	経路文字列(route_script()形式)の一括運賃計算
+//
+//	@param [in]  scripts 改行区切りの経路文字列("東京,東海道線,品川\n新宿,中央東線,...")
+//	@param [out] results 1経路あたりFAREBATCH_RECORD_SIZE個の結果(空行は飛ばす)
+//	@return 経路数
+//
+int32_t FareBatch::FareOfScripts(LPCTSTR scripts, vector<int32_t>* results)
+{
+	return FareBatch::FareOfScripts(scripts, vector<int32_t>(1, TAX), results);
+}
+
+//static
+//	経路文字列の一括運賃計算(消費税率ごと)
+//
+//	@param [in]  scripts 改行区切りの経路文字列
+//	@param [in]  taxes   消費税率(%)の並び
+//	@param [out] results 1経路あたり taxes.size() * FAREBATCH_RECORD_SIZE 個の結果(taxesの順)
+//	@return 経路数
+//
+int32_t FareBatch::FareOfScripts(LPCTSTR scripts, const vector<int32_t>& taxes, vector<int32_t>* results)
+{
+	Route route;
+	tstring script;
+	LPCTSTR p;
+	int32_t count = 0;
+
+	results->clear();
+	for (p = scripts; ; p++) {
+		if ((*p == _T('\n')) || (*p == _T('\r')) || (*p == _T('\0'))) {
+			if (!script.empty()) {
+				int32_t rc = route.setup_route(script.c_str());
+				FareBatch::Record(route, rc, taxes, results);
+				script.clear();
+				count++;
+			}
+			if (*p == _T('\0')) {
+				break;
+			}
+		} else {
+			script += *p;
+		}
+	}
+	return count;
+}
+
+//static
+//	(路線ID, 駅ID)の並びの一括運賃計算
+//
+//	路線IDが0の組で新しい経路を始める(発駅).
+//	例: { 0,東京, 東海道線,品川, 0,新宿, 中央東線,三鷹 } は 東京-品川, 新宿-三鷹 の2経路
+//	終端(add()が0, 4, 5を返した)より後に区間がある経路は状態FAREBATCH_RC_AFTER_END
+//
+//	@param [in]  packed  (路線ID, 駅ID)の並び
+//	@param [out] results 1経路あたりFAREBATCH_RECORD_SIZE個の結果
+//	@return 経路数
+//
+int32_t FareBatch::FareOfPacked(const vector<int32_t>& packed, vector<int32_t>* results)
+{
+	return FareBatch::FareOfPacked(packed, vector<int32_t>(1, TAX), results);
+}
+
+//static
+//	(路線ID, 駅ID)の並びの一括運賃計算(消費税率ごと)
+//
+//	@param [in]  packed  (路線ID, 駅ID)の並び
+//	@param [in]  taxes   消費税率(%)の並び
+//	@param [out] results 1経路あたり taxes.size() * FAREBATCH_RECORD_SIZE 個の結果(taxesの順)
+//	@return 経路数
+//
+int32_t FareBatch::FareOfPacked(const vector<int32_t>& packed, const vector<int32_t>& taxes, vector<int32_t>* results)
+{
+	Route route;
+	int32_t rc = 0;
+	int32_t count = 0;
+	size_t i;
+
+	results->clear();
+	for (i = 0; (i + 1) < packed.size(); i += 2) {
+		int32_t lineId = packed[i];
+		int32_t stationId = packed[i + 1];
+
+		if (lineId == 0) {
+			if (0 < count) {
+				FareBatch::Record(route, rc, taxes, results);
+			}
+			route.removeAll();
+			rc = (0 < stationId) ? route.add(stationId) : -200;		/* illegal station */
+			count++;
+		} else if (count == 0) {
+			/* 発駅なし: 1経路として失敗を返す */
+			rc = -200;
+			route.removeAll();
+			count++;
+		} else if (rc == ADDRC_OK) {
+			rc = route.add(lineId, stationId);
+		} else if (0 <= rc) {
+			/* 終端(ADDRC_LAST/CEND/END)以降に区間がある: 追加せずエラーとする */
+			rc = FAREBATCH_RC_AFTER_END;
+		} else {
+			/* エラー以降は読み飛ばす */
+		}
+	}
+	if (0 < count) {
+		FareBatch::Record(route, rc, taxes, results);
+	}
+	return count;
+}
+
+//static private
+//	1経路分の結果を追加(消費税率ごと)
+//
+//	経路(route_list_raw)は税率間で共有し、税率ごとにその複製で運賃計算する
+//	(calcFare()は規則適用でCalcRouteの経路とフラグを書き換えるため)
+//
+//	@param [in]  route   経路
+//	@param [in]  rc      経路組み立ての戻り値(負:エラー)
+//	@param [in]  taxes   消費税率(%)の並び
+//	@param [out] results 結果
+//
+void FareBatch::Record(const Route& route, int32_t rc, const vector<int32_t>& taxes, vector<int32_t>* results)
+{
+	vector<int32_t>::const_iterator ite;
+	size_t base = results->size();
+
+	results->resize(base + FAREBATCH_RECORD_SIZE * taxes.size(), 0);
+	if (rc < 0) {
+		for (; base < results->size(); base += FAREBATCH_RECORD_SIZE) {
+			(*results)[base + FAREBATCH_STATUS] = rc;
+		}
+		return;
+	}
+
+	CalcRoute route_shared(route);
+	vector<RouteItem>::const_iterator itr;
+	bool company = false;
+
+	for (itr = route.routeList().cbegin(); itr != route.routeList().cend(); itr++) {
+		if (IS_COMPANY_LINE(itr->lineId)) {
+			company = true;
+			break;
+		}
+	}
+	for (ite = taxes.cbegin(); ite != taxes.cend(); ite++, base += FAREBATCH_RECORD_SIZE) {
+		CalcRoute calc(route_shared);
+		FARE_INFO fi(*ite);
+
+		if (company && !FareBatch::IsCompanyFareTax(*ite)) {
+			(*results)[base + FAREBATCH_STATUS] = 3;		/* fatal */
+			continue;
+		}
+		calc.calcFare(&fi);
+		if (fi.resultCode() != 0) {
+			(*results)[base + FAREBATCH_STATUS] = -fi.resultCode();
+			continue;
+		}
+		(*results)[base + FAREBATCH_STATUS] = 0;
+		(*results)[base + FAREBATCH_FARE] = fi.getFareForDisplay();
+		(*results)[base + FAREBATCH_CHILD_FARE] = fi.getChildFareForDisplay();
+		(*results)[base + FAREBATCH_IC_FARE] = fi.getFareForIC();
+		(*results)[base + FAREBATCH_SALES_KM] = fi.getTotalSalesKm();
+		(*results)[base + FAREBATCH_AVAIL_DAYS] = fi.getTicketAvailDays();
+	}
+}
+
+//static private
+//	会社線の運賃(t_clinfar)がある消費税率か
+//
+//	@param [in] tax 消費税率(%)
+//	@retval true 会社線の運賃あり
+//
+bool FareBatch::IsCompanyFareTax(int32_t tax)
+{
+	DBO dbo(DBS::getInstance()->compileSql("select 1 from t_clinfar where tax=?1 limit(1)"));
+
+	dbo.setParam(1, tax);
+	return dbo.moveNext();
+}
@@ -0,0 +1,36 @@
+#ifndef _FARE_BATCH_H__
+#define _FARE_BATCH_H__
+
+#include "alpdb.h"
+
+/*!	@file fare_batch 複数経路の運賃一括計算.
+ *	経路(Route)とDBのプリペアドステートメントキャッシュを全経路で使い回し、
+ *	結果を1経路あたりFAREBATCH_RECORD_SIZE個のint32_tの並びで返す.
+ *	消費税率を複数指定すると、経路の組み立ては1回で税率ごとの結果を続けて返す.
+ */
+
+// 1経路分の結果の並び
+#define FAREBATCH_STATUS		0	// 0:正常, 負:経路エラー(setup_route()/add()の戻り値), 正:運賃計算エラー(FARE_INFO::resultCode()の符号反転)
+								// (会社線の運賃がない消費税率は3)
+#define FAREBATCH_FARE			1	// 運賃(getFareForDisplay())
+#define FAREBATCH_CHILD_FARE	2	// 小児運賃
+#define FAREBATCH_IC_FARE		3	// IC運賃(IC運賃なしは0)
+#define FAREBATCH_SALES_KM		4	// 営業キロ
+#define FAREBATCH_AVAIL_DAYS	5	// 有効日数
+#define FAREBATCH_RECORD_SIZE	6
+
+#define FAREBATCH_RC_AFTER_END	(-400)	// FareOfPacked(): 終端(ADDRC_LAST/CEND/END)より後に区間がある
+
+class FareBatch
+{
+public:
+	static int32_t FareOfScripts(LPCTSTR scripts, vector<int32_t>* results);
+	static int32_t FareOfScripts(LPCTSTR scripts, const vector<int32_t>& taxes, vector<int32_t>* results);
+	static int32_t FareOfPacked(const vector<int32_t>& packed, vector<int32_t>* results);
+	static int32_t FareOfPacked(const vector<int32_t>& packed, const vector<int32_t>& taxes, vector<int32_t>* results);
+private:
+	static void Record(const Route& route, int32_t rc, const vector<int32_t>& taxes, vector<int32_t>* results);
+	static bool IsCompanyFareTax(int32_t tax);
+};
+
+#endif	/* _FARE_BATCH_H__ */
@@ -0,0 +1,288 @@
+#include "fare_kernel.h"
+
+#include <memory>
+
+#if defined(__wasm_simd128__)
+#include <wasm_simd128.h>
+#elif defined(__AVX2__) || defined(__SSE4_1__)
+#include <immintrin.h>
+#endif
+
+/* KM(km) = (km + 9) / 10 を乗算とシフトで(km + 9 < 81920 で正確) */
+#define FAREKERNEL_DIV10_MUL	52429
+#define FAREKERNEL_DIV10_SHIFT	19
+
+////////////////////////////////////////////
+//	FareKernel
+//
+
+static map<int32_t, unique_ptr<FareKernel>> fare_kernels;	/* 消費税率 -> 表 */
+
+//static private
+//	消費税率の表を得る
+//
+FareKernel& FareKernel::GetInstance(int32_t tax)
+{
+	map<int32_t, unique_ptr<FareKernel>>::iterator ite = fare_kernels.find(tax);
+
+	if (ite == fare_kernels.end()) {
+		ite = fare_kernels.insert(make_pair(tax, unique_ptr<FareKernel>(new FareKernel(tax)))).first;
+	}
+	return *ite->second;
+}
+
+//private
+//	運賃表(初回のみ参照実装で作る)
+//
+//	運賃はキロ程の1km未満を切り上げたkm単位で決まる(運賃表はkm単位、
+//	賃率計算の区切りは1kmの倍数)ので、1km単位の配列とする
+//
+const vector<int32_t>& FareKernel::tableOf(FAREKERNEL kind)
+{
+	vector<int32_t>& t = table[kind];
+
+	if (t.empty()) {
+		int32_t max_km = FareKernel::MaxKm(kind);
+		int32_t km;
+
+		t.assign(max_km + 1, 0);
+		for (km = 1; km <= max_km; km++) {
+			t[km] = FareKernel::Reference(kind, km * 10, tax);
+		}
+	}
+	return t;
+}
+
+//static
+//	運賃
+//
+//	@param [in] kind 運賃の種類
+//	@param [in] km   キロ程(0.1km単位. FK_BASIC, FK_HOKKAIDO_BASIC, FK_SHIKOKU, FK_KYUSYUは計算キロ, 他は営業キロ)
+//	@param [in] tax  消費税率(%)
+//	@return 運賃額(FARE_INFO::Fare_xxx()と同じ)
+//
+int32_t FareKernel::Fare(FAREKERNEL kind, int32_t km, int32_t tax)
+{
+	if ((km <= 0) || (FareKernel::MaxKm(kind) < KM(km))) {
+		return FareKernel::Reference(kind, km, tax);
+	}
+	return FareKernel::GetInstance(tax).tableOf(kind)[KM(km)];
+}
+
+//static
+//	運賃(JR四国・JR九州 幹線+地方交通線)
+//
+//	@param [in] kind FK_SHIKOKU または FK_KYUSYU
+//	@param [in] skm  営業キロ
+//	@param [in] ckm  計算キロ
+//	@param [in] tax  消費税率(%)
+//	@return 運賃額(FARE_INFO::Fare_shikoku(), Fare_kyusyu()と同じ)
+//
+int32_t FareKernel::Fare(FAREKERNEL kind, int32_t skm, int32_t ckm, int32_t tax)
+{
+	ASSERT((kind == FK_SHIKOKU) || (kind == FK_KYUSYU));
+
+	if ((ckm != skm) &&
+		(((KM(ckm) == 4) && (KM(skm) == 3)) || ((KM(ckm) == 11) && (KM(skm) == 10)))) {
+		/* JTB時刻表 C-3表の特定の組み合わせ */
+		if (kind == FK_SHIKOKU) {
+			return FARE_INFO::Fare_shikoku(skm, ckm, tax);
+		}
+		return FARE_INFO::Fare_kyusyu(skm, ckm, tax);
+	}
+	return FareKernel::Fare(kind, ckm, tax);
+}
+
+//static
+//	運賃(複数のキロ程)
+//
+//	表の範囲内のキロ程はSIMDで添字(km単位)を求めて表を引く.
+//	表の範囲外(0以下, MaxKm()越え)を含む組はFare()で1件ずつ求める.
+//
+//	@param [in]  kind  運賃の種類
+//	@param [in]  km    キロ程(0.1km単位)の配列
+//	@param [out] fares 運賃の配列(count個)
+//	@param [in]  count 件数
+//	@param [in]  tax   消費税率(%)
+//
+void FareKernel::FareArray(FAREKERNEL kind, const int32_t* km, int32_t* fares, int32_t count, int32_t tax)
+{
+	int32_t i = 0;
+
+#if defined(__wasm_simd128__)
+	const int32_t* t = FareKernel::GetInstance(tax).tableOf(kind).data();
+	const int32_t max_km = FareKernel::MaxKm(kind) * 10;
+	int32_t j;
+	const v128_t v_min = wasm_i32x4_splat(1);
+	const v128_t v_max = wasm_i32x4_splat(max_km);
+	const v128_t v_9 = wasm_i32x4_splat(9);
+	const v128_t v_mul = wasm_i32x4_splat(FAREKERNEL_DIV10_MUL);
+
+	for (; (i + 4) <= count; i += 4) {
+		v128_t v = wasm_v128_load(km + i);
+		int32_t idx[4];
+
+		if (wasm_v128_any_true(wasm_v128_or(wasm_i32x4_lt(v, v_min), wasm_i32x4_gt(v, v_max)))) {
+			for (j = i; j < (i + 4); j++) {
+				fares[j] = FareKernel::Fare(kind, km[j], tax);
+			}
+			continue;
+		}
+		v = wasm_u32x4_shr(wasm_i32x4_mul(wasm_i32x4_add(v, v_9), v_mul), FAREKERNEL_DIV10_SHIFT);
+		wasm_v128_store(idx, v);
+		for (j = 0; j < 4; j++) {
+			fares[i + j] = t[idx[j]];
+		}
+	}
+#elif defined(__AVX2__)
+	const int32_t* t = FareKernel::GetInstance(tax).tableOf(kind).data();
+	const int32_t max_km = FareKernel::MaxKm(kind) * 10;
+	int32_t j;
+	const __m256i v_min = _mm256_set1_epi32(1);
+	const __m256i v_max = _mm256_set1_epi32(max_km);
+	const __m256i v_9 = _mm256_set1_epi32(9);
+	const __m256i v_mul = _mm256_set1_epi32(FAREKERNEL_DIV10_MUL);
+
+	for (; (i + 8) <= count; i += 8) {
+		__m256i v = _mm256_loadu_si256((const __m256i*)(km + i));
+
+		if (!_mm256_testz_si256(_mm256_or_si256(_mm256_cmpgt_epi32(v_min, v), _mm256_cmpgt_epi32(v, v_max)),
+								_mm256_set1_epi32(-1))) {
+			for (j = i; j < (i + 8); j++) {
+				fares[j] = FareKernel::Fare(kind, km[j], tax);
+			}
+			continue;
+		}
+		v = _mm256_srli_epi32(_mm256_mullo_epi32(_mm256_add_epi32(v, v_9), v_mul), FAREKERNEL_DIV10_SHIFT);
+		_mm256_storeu_si256((__m256i*)(fares + i), _mm256_i32gather_epi32(t, v, 4));
+	}
+#elif defined(__SSE4_1__)
+	const int32_t* t = FareKernel::GetInstance(tax).tableOf(kind).data();
+	const int32_t max_km = FareKernel::MaxKm(kind) * 10;
+	int32_t j;
+	const __m128i v_min = _mm_set1_epi32(1);
+	const __m128i v_max = _mm_set1_epi32(max_km);
+	const __m128i v_9 = _mm_set1_epi32(9);
+	const __m128i v_mul = _mm_set1_epi32(FAREKERNEL_DIV10_MUL);
+
+	for (; (i + 4) <= count; i += 4) {
+		__m128i v = _mm_loadu_si128((const __m128i*)(km + i));
+		int32_t idx[4];
+
+		if (!_mm_testz_si128(_mm_or_si128(_mm_cmplt_epi32(v, v_min), _mm_cmpgt_epi32(v, v_max)),
+							 _mm_set1_epi32(-1))) {
+			for (j = i; j < (i + 4); j++) {
+				fares[j] = FareKernel::Fare(kind, km[j], tax);
+			}
+			continue;
+		}
+		v = _mm_srli_epi32(_mm_mullo_epi32(_mm_add_epi32(v, v_9), v_mul), FAREKERNEL_DIV10_SHIFT);
+		_mm_storeu_si128((__m128i*)idx, v);
+		for (j = 0; j < 4; j++) {
+			fares[i + j] = t[idx[j]];
+		}
+	}
+#endif
+	for (; i < count; i++) {
+		fares[i] = FareKernel::Fare(kind, km[i], tax);
+	}
+}
+
+//static
+//	参照実装(FARE_INFO::Fare_xxx())
+//
+//	@param [in] kind 運賃の種類
+//	@param [in] km   キロ程(0.1km単位)
+//	@param [in] tax  消費税率(%)
+//	@return 運賃額
+//
+int32_t FareKernel::Reference(FAREKERNEL kind, int32_t km, int32_t tax)
+{
+	switch (kind) {
+	case FK_BASIC:
+		return FARE_INFO::Fare_basic_f(km, tax);
+	case FK_SUB:
+		return FARE_INFO::Fare_sub_f(km, tax);
+	case FK_TOKYO:
+		return FARE_INFO::Fare_tokyo_f(km, tax);
+	case FK_OSAKA:
+		return FARE_INFO::Fare_osaka(km, tax);
+	case FK_YAMATE:
+		return FARE_INFO::Fare_yamate_f(km, tax);
+	case FK_OSAKAKAN:
+		return FARE_INFO::Fare_osakakan(km, tax);
+	case FK_HOKKAIDO_BASIC:
+		return FARE_INFO::Fare_hokkaido_basic(km, tax);
+	case FK_HOKKAIDO_SUB:
+		return FARE_INFO::Fare_hokkaido_sub(km, tax);
+	case FK_SHIKOKU:
+		return FARE_INFO::Fare_shikoku(km, km, tax);
+	case FK_KYUSYU:
+		return FARE_INFO::Fare_kyusyu(km, km, tax);
+	default:
+		ASSERT(FALSE);
+		return -1;
+	}
+}
+
+//static
+//	表にするキロ程の上限(km). 参照実装が運賃を定義している範囲
+//
+int32_t FareKernel::MaxKm(FAREKERNEL kind)
+{
+	switch (kind) {
+	case FK_YAMATE:
+	case FK_OSAKAKAN:
+		return 300;
+	case FK_TOKYO:
+	case FK_OSAKA:
+		return 600;
+	case FK_SUB:
+	case FK_HOKKAIDO_SUB:
+		return 1199;	/* 1200kmは運賃表の終端 */
+	default:
+		return FAREKERNEL_MAX_KM;
+	}
+}
+
+#ifdef FARERT_SELFTEST
+//static
+//	表と参照実装の全キロ程(0.1km単位)での比較(SELFTEST=1 のビルドのみ)
+//
+//	@param [in] tax 消費税率(%)
+//	@return 不一致の数
+//
+int32_t FareKernel::Verify(int32_t tax)
+{
+	int32_t mismatch = 0;
+	int32_t kind;
+	int32_t km;
+
+	for (kind = 0; kind < FK_NUM; kind++) {
+		for (km = 1; km <= FareKernel::MaxKm((FAREKERNEL)kind) * 10; km++) {
+			if (FareKernel::Fare((FAREKERNEL)kind, km, tax) != FareKernel::Reference((FAREKERNEL)kind, km, tax)) {
+				TRACE("FareKernel::Verify mismatch tax=%d, kind=%d, km=%d\n", tax, kind, km);
+				mismatch++;
+			}
+		}
+	}
+	/* JR四国・JR九州 営業キロ != 計算キロ */
+	for (km = 11; km <= 200; km++) {
+		if (FareKernel::Fare(FK_SHIKOKU, km - 10, km, tax) != FARE_INFO::Fare_shikoku(km - 10, km, tax)) {
+			mismatch++;
+		}
+		if (FareKernel::Fare(FK_KYUSYU, km - 10, km, tax) != FARE_INFO::Fare_kyusyu(km - 10, km, tax)) {
+			mismatch++;
+		}
+	}
+	return mismatch;
+}
+#endif
+
+//static
+//	表を破棄(DBを開き直した時)
+//
+void FareKernel::Clear()
+{
+	fare_kernels.clear();
+}
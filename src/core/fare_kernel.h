@@ -0,0 +1,51 @@
+#ifndef _FARE_KERNEL_H__
+#define _FARE_KERNEL_H__
+
+#include "alpdb.h"
+
+/*!	@file fare_kernel キロ程→運賃の表引き(運賃カーネル).
+ *	FARE_INFO::Fare_xxx()(運賃表のDB参照 + 賃率計算 + 端数処理)の結果を
+ *	消費税率ごとに1km単位の配列にしておき、配列参照1回で運賃を得る.
+ *	表は初回参照時にFARE_INFO::Fare_xxx()で作る(DBの運賃表を使うのでビルド時には作れない).
+ *	FARE_INFO::Fare_xxx()は参照実装として残す.
+ *	FareArray()は複数のキロ程を一度に引く(表の添字計算をSIMDで行う. wasm SIMD128, AVX2, SSE4.1,
+ *	いずれもなければスカラー. 結果はどれも同じ).
+ */
+
+enum FAREKERNEL {
+	FK_BASIC,				// Fare_basic_f() 幹線
+	FK_SUB,					// Fare_sub_f() 地方交通線
+	FK_TOKYO,				// Fare_tokyo_f() 電車特定区間(東京)
+	FK_OSAKA,				// Fare_osaka() 電車特定区間(大阪)
+	FK_YAMATE,				// Fare_yamate_f() 山手線内
+	FK_OSAKAKAN,			// Fare_osakakan() 大阪環状線内
+	FK_HOKKAIDO_BASIC,		// Fare_hokkaido_basic() JR北海道幹線
+	FK_HOKKAIDO_SUB,		// Fare_hokkaido_sub() JR北海道地方交通線
+	FK_SHIKOKU,				// Fare_shikoku() JR四国(営業キロ=計算キロ)
+	FK_KYUSYU,				// Fare_kyusyu() JR九州(営業キロ=計算キロ)
+	FK_NUM
+};
+
+#define FAREKERNEL_MAX_KM	3000		/* 表にするキロ程の上限(km). 越えたら参照実装で計算 */
+
+class FareKernel
+{
+	int32_t tax;
+	vector<int32_t> table[FK_NUM];		// [km(1km単位, 端数切り上げ)] 運賃
+
+	FareKernel(int32_t tax_) : tax(tax_) {}
+	const vector<int32_t>& tableOf(FAREKERNEL kind);
+	static FareKernel& GetInstance(int32_t tax);
+public:
+	static int32_t	Fare(FAREKERNEL kind, int32_t km, int32_t tax);
+	static int32_t	Fare(FAREKERNEL kind, int32_t skm, int32_t ckm, int32_t tax);
+	static void		FareArray(FAREKERNEL kind, const int32_t* km, int32_t* fares, int32_t count, int32_t tax);
+	static int32_t	Reference(FAREKERNEL kind, int32_t km, int32_t tax);
+	static int32_t	MaxKm(FAREKERNEL kind);
+#ifdef FARERT_SELFTEST
+	static int32_t	Verify(int32_t tax);
+#endif
+	static void		Clear();
+};
+
+#endif	/* _FARE_KERNEL_H__ */
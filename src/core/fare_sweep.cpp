@@ -0,0 +1,319 @@
+#include "fare_sweep.h"
+
+#include <queue>
+#include <functional>
+
+////////////////////////////////////////////
+//	FareSweep
+//
+
+//static
+//	1発駅から全駅(または会社・都道府県で絞り込んだ駅)への最短経路運賃を求める
+//
+//	最短経路木を1回だけ構築し、木を深さ優先でたどりながら親分岐駅までの経路(Route)を
+//	複製して1区間ずつ延長する(共通の前半部分のadd()は1回のみ).
+//	経路木から組み立てられない着駅(新幹線の並行在来線置換等でadd()が通らない)は
+//	changeNeerest()で個別に求める.
+//
+//	@param [in] start_station_id   発駅
+//	@param [in] useBulletTrain     changeNeerest()と同じ(0:在来線のみ, 1:新幹線, 2:会社線, 3:両方, 100:地方交通線除く)
+//	@param [in] companyOrPrefectId 絞り込み(0:全駅, 0x10000以上:都道府県(IDENT2), 以外:会社)
+//	@return [station_id] 運賃(発駅は0, 対象外・到達不可は-1)
+//
+vector<int32_t> FareSweep::FareOfAllStations(int32_t start_station_id, uint8_t useBulletTrain, int32_t companyOrPrefectId /* = 0 */)
+{
+	const RouteGraph& graph = RouteGraph::getInstance();
+	JctPathTree tree;
+	vector<int32_t> fares(graph.maxStationId() + 1, -1);
+	vector<bool> target;
+	vector<vector<IDENT>> children;
+	vector<vector<IDENT>> attach;		// [jctId] 分岐駅から路線で至る非分岐駅([0]は発駅と同一区間)
+	vector<bool> jct_target;			// [jctId] 分岐駅が対象駅
+	vector<int32_t> fallback;			// 個別探索する着駅
+	vector<pair<int32_t, Route>> stack;
+	Route root;
+	int32_t rootNode;
+	int32_t station_id;
+	int32_t jctId;
+	int32_t lineId;
+	int32_t rc;
+
+	if ((start_station_id <= 0) || (graph.maxStationId() < start_station_id)) {
+		return fares;
+	}
+	if (tree.build(start_station_id, useBulletTrain) < 0) {
+		return fares;
+	}
+	target = FareSweep::TargetStations(graph.maxStationId(), companyOrPrefectId);
+	children = tree.children();
+	attach.assign(children.size(), vector<IDENT>());
+	jct_target.assign(children.size(), false);
+
+	for (station_id = 1; station_id <= graph.maxStationId(); station_id++) {
+		if (!target[station_id] || (station_id == start_station_id)) {
+			continue;
+		}
+		if (tree.costOfStation(station_id, &jctId, &lineId) < 0) {
+			continue;	/* 到達不可 */
+		}
+		if (lineId == 0) {
+			jct_target[jctId] = true;
+		} else {
+			attach[jctId].push_back(station_id);
+		}
+	}
+	if (target[start_station_id]) {
+		fares[start_station_id] = 0;
+	}
+
+	rootNode = graph.id2jct(start_station_id);	/* 非分岐駅なら0 */
+	if (root.add(start_station_id) < 0) {
+		return fares;
+	}
+	stack.push_back(pair<int32_t, Route>(rootNode, root));
+
+	while (!stack.empty()) {
+		int32_t node = stack.back().first;
+		Route route(stack.back().second);
+		vector<IDENT>::const_iterator ite;
+
+		stack.pop_back();
+
+		if ((node != rootNode) && jct_target[node]) {
+			fares[graph.jct2id(node)] = FareSweep::FareOf(route);
+		}
+		/* 分岐駅から非分岐駅へ */
+		for (ite = attach[node].cbegin(); ite != attach[node].cend(); ite++) {
+			Route leaf(route);
+			lineId = graph.lineIdFromStationId(*ite);
+			if ((1 < leaf.routeList().size()) && (leaf.routeList().back().lineId == lineId)) {
+				leaf.removeTail();	/* 同一路線は1区間にまとめる */
+			}
+			rc = leaf.add(lineId, *ite);
+			if ((0 <= rc) && (leaf.arriveStationId() == *ite)) {
+				fares[*ite] = FareSweep::FareOf(leaf);
+			} else {
+				fallback.push_back(*ite);
+			}
+		}
+		/* 子の分岐駅へ延長 */
+		for (ite = children[node].cbegin(); ite != children[node].cend(); ite++) {
+			Route next(route);
+			lineId = tree.lineId(*ite);
+			if ((1 < next.routeList().size()) && (next.routeList().back().lineId == lineId)) {
+				next.removeTail();
+			}
+			rc = next.add(lineId, graph.jct2id(*ite));
+			if ((ADDRC_OK == rc) && (next.arriveStationId() == graph.jct2id(*ite))) {
+				stack.push_back(pair<int32_t, Route>(*ite, next));
+			} else {
+				/* 部分木の着駅はすべて個別探索 */
+				vector<IDENT> sub(1, *ite);
+				while (!sub.empty()) {
+					int32_t n = sub.back();
+					sub.pop_back();
+					if (jct_target[n]) {
+						fallback.push_back(graph.jct2id(n));
+					}
+					fallback.insert(fallback.end(), attach[n].cbegin(), attach[n].cend());
+					sub.insert(sub.end(), children[n].cbegin(), children[n].cend());
+				}
+			}
+		}
+	}
+
+	vector<int32_t>::const_iterator itf;
+	for (itf = fallback.cbegin(); itf != fallback.cend(); itf++) {
+		Route route;
+		route.add(start_station_id);
+		rc = route.changeNeerest(useBulletTrain, *itf);
+		if ((0 <= rc) && (route.arriveStationId() == *itf)) {
+			fares[*itf] = FareSweep::FareOf(route);
+		}
+	}
+	return fares;
+}
+
+//static
+//	到達圏検索: 発駅から営業キロまたは運賃の上限以内で行ける駅
+//
+//	駅単位(非分岐駅も含む)のグラフを営業キロでダイクストラ探索し、上限を超えた駅から先は
+//	展開しない. 駅ごとには先行駅と路線だけを持ち、確定した駅の経路(Route)は基点の駅
+//	(発駅・乗換駅など別路線へ延長される駅)の経路を複製して1区間延長して作る(同一路線は
+//	1区間にまとめるので途中の駅の経路は要らない). 経路を保持するのは基点の駅のみ.
+//	経路が組み立てられない駅(add()が通らない)はchangeNeerest()の経路で代用し、その駅を基点にする.
+//
+//	運賃が上限を超えた駅もその先は展開しない. 経路を延ばしても運賃は下がらないことを前提とした
+//	枝刈りで、特定区間運賃・大都市近郊区間の最短経路運賃・会社線の通過などでこれが成り立たない
+//	場合は、その先にある上限以内の駅を返さないことがある.
+//
+//	@param [in] start_station_id 発駅
+//	@param [in] useBulletTrain   changeNeerest()と同じ(0:在来線のみ, 1:新幹線, 2:会社線, 3:両方, 100:地方交通線除く)
+//	@param [in] max_sales_km     営業キロ上限(0.1km単位, 0以下:制限なし)
+//	@param [in] max_fare         運賃上限(0以下:制限なし)
+//	@return 到達圏内の駅(営業キロ昇順, 発駅は含まない)
+//
+vector<ReachStation> FareSweep::ReachableStations(int32_t start_station_id, uint8_t useBulletTrain, int32_t max_sales_km, int32_t max_fare)
+{
+	typedef pair<int32_t, IDENT> QITEM;		/* 営業キロ, 駅 */
+	const RouteGraph& graph = RouteGraph::getInstance();
+	vector<ReachStation> result;
+	vector<int32_t> dist;
+	vector<bool> done;
+	vector<IDENT> pred;				/* [stationId] 先行駅 */
+	vector<IDENT> pred_line;		/* [stationId] 先行駅からの路線 */
+	vector<IDENT> base;				/* [stationId] 経路の基点の駅(bases のキー) */
+	map<IDENT, Route> bases;		/* [基点の駅] 確定した経路 */
+	Route route;
+	priority_queue<QITEM, vector<QITEM>, greater<QITEM>> q;
+
+	if ((start_station_id <= 0) || (graph.maxStationId() < start_station_id)) {
+		return result;
+	}
+	dist.assign(graph.maxStationId() + 1, INT32_MAX);
+	done.assign(graph.maxStationId() + 1, false);
+	pred.assign(graph.maxStationId() + 1, 0);
+	pred_line.assign(graph.maxStationId() + 1, 0);
+	base.assign(graph.maxStationId() + 1, 0);
+
+	if (bases[start_station_id].add(start_station_id) < 0) {
+		return result;
+	}
+	base[start_station_id] = start_station_id;
+	dist[start_station_id] = 0;
+	q.push(QITEM(0, start_station_id));
+
+	while (!q.empty()) {
+		int32_t km = q.top().first;
+		IDENT station_id = q.top().second;
+		IDENT last_line = 0;		/* 経路の最後の区間の路線 */
+		bool branch = false;		/* 別路線へ延長する */
+		vector<StationEdge>::const_iterator ite;
+
+		q.pop();
+		if (done[station_id] || (dist[station_id] < km)) {
+			continue;
+		}
+		if ((0 < max_sales_km) && (max_sales_km < km)) {
+			break;	/* 以降はすべて上限超え */
+		}
+		done[station_id] = true;
+
+		if (station_id != start_station_id) {
+			ReachStation rs;
+			int32_t rc;
+
+			route = bases[base[pred[station_id]]];
+			if ((1 < route.routeList().size()) && (route.routeList().back().lineId == pred_line[station_id])) {
+				route.removeTail();		/* 同一路線は1区間にまとめる */
+			}
+			rc = route.add(pred_line[station_id], station_id);
+			if ((rc < 0) || (route.arriveStationId() != station_id)) {
+				route = Route();
+				route.add(start_station_id);
+				rc = route.changeNeerest(useBulletTrain, station_id);
+				if ((rc < 0) || (route.arriveStationId() != station_id)) {
+					continue;	/* 到達不可(先へも展開しない) */
+				}
+				branch = true;
+			}
+			last_line = route.routeList().back().lineId;
+			branch = branch || (last_line != pred_line[station_id]);
+			base[station_id] = base[pred[station_id]];
+
+			rs.fare = FareSweep::FareOf(route, &rs.salesKm);
+			if (rs.fare < 0) {
+				continue;
+			}
+			if ((0 < max_fare) && (max_fare < rs.fare)) {
+				continue;
+			}
+			if ((max_sales_km <= 0) || (rs.salesKm <= max_sales_km)) {
+				rs.stationId = station_id;
+				rs.route = route.route_script();
+				result.push_back(rs);
+			}
+		}
+		for (ite = graph.nextStation(station_id).cbegin(); ite != graph.nextStation(station_id).cend(); ite++) {
+			if (done[ite->stationId] || !graph.isEnableLine(ite->lineId, useBulletTrain)) {
+				continue;
+			}
+			if ((km + ite->salesKm) < dist[ite->stationId]) {
+				dist[ite->stationId] = km + ite->salesKm;
+				pred[ite->stationId] = station_id;
+				pred_line[ite->stationId] = ite->lineId;
+				q.push(QITEM(dist[ite->stationId], ite->stationId));
+				if (ite->lineId != last_line) {
+					branch = true;
+				}
+			}
+		}
+		if (branch && (base[station_id] != station_id)) {
+			/* 基点にする(同一路線の延長は基点の経路から作り直せるので保持しない) */
+			base[station_id] = station_id;
+			bases[station_id] = route;
+		}
+	}
+	return result;
+}
+
+//static private
+//	対象駅
+//
+//	@param [in] max_station_id     最大駅ID
+//	@param [in] companyOrPrefectId 0:全駅, 0x10000以上:都道府県(IDENT2), 以外:会社
+//	@return [station_id] true:対象
+//
+vector<bool> FareSweep::TargetStations(int32_t max_station_id, int32_t companyOrPrefectId)
+{
+	vector<bool> target(max_station_id + 1, companyOrPrefectId == 0);
+
+	if (companyOrPrefectId != 0) {
+		char sql[128];
+		const char tsql[] = "select rowid from t_station where %s=%d";
+		int32_t ident;
+
+		if (0x10000 <= (PAIRIDENT)companyOrPrefectId) {
+			ident = IDENT2(companyOrPrefectId);
+		} else {
+			ident = companyOrPrefectId;
+		}
+		sqlite3_snprintf(sizeof(sql), sql, tsql,
+		(0x10000 <= (PAIRIDENT)companyOrPrefectId) ? "prefect_id" : "company_id", ident);
+
+		DBO dbo = DBS::getInstance()->compileSql(sql, false);
+		while (dbo.moveNext()) {
+			int32_t id = dbo.getInt(0);
+			if ((0 < id) && (id <= max_station_id)) {
+				target[id] = true;
+			}
+		}
+	}
+	if (0 < max_station_id) {
+		target[0] = false;
+	}
+	return target;
+}
+
+//static private
+//	経路の運賃(会社線含む総額)
+//
+//	@param [in]  route    経路
+//	@param [out] pSalesKm 営業キロ(NULL可)
+//	@retval 0 <= 運賃
+//	@retval -1 運賃計算不可
+//
+int32_t FareSweep::FareOf(const Route& route, int32_t* pSalesKm /* = nullptr */)
+{
+	CalcRoute calc(route);
+	FARE_INFO fi;
+
+	calc.calcFare(&fi);
+	if (fi.resultCode() != 0) {
+		return -1;
+	}
+	if (pSalesKm != nullptr) {
+		*pSalesKm = fi.getTotalSalesKm();
+	}
+	return fi.getFareForDisplay();
+}
@@ -0,0 +1,29 @@
+#ifndef _FARE_SWEEP_H__
+#define _FARE_SWEEP_H__
+
+#include "route_graph.h"
+
+/*!	@file fare_sweep 1発駅→全駅の運賃一括計算.
+ */
+
+// 到達圏内の駅(ReachableStations()の結果1件)
+class ReachStation
+{
+public:
+	IDENT stationId;
+	int32_t salesKm;	// 営業キロ(0.1km単位, 会社線含む)
+	int32_t fare;		// 運賃
+	tstring route;		// 経路(route_script()形式)
+};
+
+class FareSweep
+{
+public:
+	static vector<int32_t> FareOfAllStations(int32_t start_station_id, uint8_t useBulletTrain, int32_t companyOrPrefectId = 0);
+	static vector<ReachStation> ReachableStations(int32_t start_station_id, uint8_t useBulletTrain, int32_t max_sales_km, int32_t max_fare);
+private:
+	static vector<bool> TargetStations(int32_t max_station_id, int32_t companyOrPrefectId);
+	static int32_t FareOf(const Route& route, int32_t* pSalesKm = nullptr);
+};
+
+#endif	/* _FARE_SWEEP_H__ */
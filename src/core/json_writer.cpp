@@ -0,0 +1,101 @@
+#include "json_writer.h"
+
+////////////////////////////////////////////
+//	JsonWriter
+//
+
+//static
+//	共有の出力(空にして返す. 確保済みの領域はそのまま)
+//
+JsonWriter& JsonWriter::Reuse()
+{
+	static JsonWriter writer;
+
+	writer.clear();
+	return writer;
+}
+
+//private
+//	整数を10進で追加
+//
+void JsonWriter::appendInt(int64_t num)
+{
+	char digits[24];
+	char* p = digits + sizeof(digits);
+	uint64_t u = (num < 0) ? (0 - (uint64_t)num) : (uint64_t)num;
+
+	do {
+		*--p = (char)('0' + (u % 10));
+		u /= 10;
+	} while (u != 0);
+	if (num < 0) {
+		*--p = '-';
+	}
+	buf.append(p, digits + sizeof(digits) - p);
+}
+
+//private
+//	文字列を "" で囲んで追加(UTF-8はそのまま)
+//
+void JsonWriter::appendString(std::string_view str)
+{
+	static const char hex[] = "0123456789abcdef";
+	size_t begin = 0;
+	size_t i;
+
+	buf += '"';
+	for (i = 0; i < str.size(); i++) {
+		unsigned char c = (unsigned char)str[i];
+		const char* esc;
+
+		if ((0x20 <= c) && (c != '"') && (c != '\\')) {
+			continue;
+		}
+		buf.append(str.data() + begin, i - begin);
+		begin = i + 1;
+		switch (c) {
+		case '"':  esc = "\\\""; break;
+		case '\\': esc = "\\\\"; break;
+		case '\b': esc = "\\b"; break;
+		case '\f': esc = "\\f"; break;
+		case '\n': esc = "\\n"; break;
+		case '\r': esc = "\\r"; break;
+		case '\t': esc = "\\t"; break;
+		default:   esc = nullptr; break;
+		}
+		if (esc != nullptr) {
+			buf += esc;
+		} else {
+			buf += "\\u00";
+			buf += hex[c >> 4];
+			buf += hex[c & 0x0f];
+		}
+	}
+	buf.append(str.data() + begin, str.size() - begin);
+	buf += '"';
+}
+
+//	オブジェクトのキー("name":)
+//
+//	@param [in] name  キー
+//
+JsonWriter& JsonWriter::key(std::string_view name)
+{
+	separator();
+	appendString(name);
+	buf += ':';
+	return *this;
+}
+
+//	整数の配列([1,2,3])
+//
+//	@param [in] nums  値
+//
+JsonWriter& JsonWriter::values(const std::vector<int>& nums)
+{
+	beginArray();
+	for (std::vector<int>::const_iterator ite = nums.cbegin(); ite != nums.cend(); ite++) {
+		value((int32_t)*ite);
+	}
+	return endArray();
+}
@@ -0,0 +1,56 @@
+#ifndef _JSON_WRITER_H__
+#define _JSON_WRITER_H__
+
+#include <stdint.h>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/*!	@file json_writer JSON文字列の組み立て.
+ *	CalcRouteWrapper::calcFare()や配列系API(farert_wasm.cpp)のJSONを1つの出力文字列に直接書く.
+ *	数値は一時文字列(std::to_string())を作らずに書き、文字列は " \ 制御文字をエスケープする.
+ *	区切りの , は自動で入れる(key()の直後の値には入れない).
+ *	Reuse()で得る共有の出力文字列は呼び出しをまたいで確保済みの領域を使い回す.
+ *	(書き終えてstr()を複写するまで、別のJSONを書く関数を呼ばないこと)
+ */
+
+class JsonWriter
+{
+	std::string buf;
+	bool need_separator;
+
+	void separator() {
+		if (need_separator) {
+			buf += ',';
+		}
+		need_separator = false;
+	}
+	void appendInt(int64_t num);
+	void appendString(std::string_view str);
+public:
+	JsonWriter() : need_separator(false) { buf.reserve(1024); }
+
+	static JsonWriter& Reuse();
+
+	void clear() { buf.clear(); need_separator = false; }
+	const std::string& str() const { return buf; }
+
+	JsonWriter& beginObject() { separator(); buf += '{'; return *this; }
+	JsonWriter& endObject() { buf += '}'; need_separator = true; return *this; }
+	JsonWriter& beginArray() { separator(); buf += '['; return *this; }
+	JsonWriter& endArray() { buf += ']'; need_separator = true; return *this; }
+	JsonWriter& key(std::string_view name);
+
+	JsonWriter& value(int32_t num) { separator(); appendInt(num); need_separator = true; return *this; }
+	JsonWriter& value(int64_t num) { separator(); appendInt(num); need_separator = true; return *this; }
+	JsonWriter& value(bool flag) { separator(); buf += flag ? "true" : "false"; need_separator = true; return *this; }
+	JsonWriter& value(std::string_view str) { separator(); appendString(str); need_separator = true; return *this; }
+	JsonWriter& value(const char* str) { return value(std::string_view(str)); }
+	JsonWriter& value(const std::string& str) { return value(std::string_view(str)); }
+	JsonWriter& values(const std::vector<int>& nums);
+
+	template <typename T>
+	JsonWriter& member(std::string_view name, const T& v) { key(name); return value(v); }
+};
+
+#endif	/* _JSON_WRITER_H__ */
@@ -0,0 +1,297 @@
+#include "kana_utf8.h"
+
+#include <string.h>
+
+#if defined(__wasm_simd128__)
+#include <wasm_simd128.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+/* 3バイト文字(先頭バイト<<16 | 2バイト目<<8 | 3バイト目)の範囲. 文字列の終端で足りないバイトは0 */
+#define KANA_UTF8_HIRA_FIRST	0xe38181		/* ぁ U+3041 */
+#define KANA_UTF8_HIRA_LAST		0xe38293		/* ん U+3093 */
+#define KANA_UTF8_KATA_FIRST	0xe382a1		/* ァ U+30A1 */
+#define KANA_UTF8_KATA_LAST		0xe383b3		/* ン U+30F3 */
+#define KANA_UTF8_DA_FIRST		0xe38380		/* ダ U+30C0 */
+#define KANA_UTF8_MI_LAST		0xe3839f		/* ミ U+30DF */
+
+/* 先頭バイトから文字のバイト数(isKanaString()と同じく不正な先頭バイトも長さを決める) */
+static inline size_t lead_size(unsigned char lead)
+{
+	if (lead < 0x80) {
+		return 1;
+	} else if (lead < 0xe0) {
+		return 2;
+	} else if (lead < 0xf0) {
+		return 3;
+	} else {
+		return 4;
+	}
+}
+
+/* pt からの3バイトを整数に */
+static inline uint32_t three_bytes(const char* str, size_t len, size_t pt)
+{
+	uint32_t v = (uint32_t)(unsigned char)str[pt] << 16;
+
+	if ((pt + 1) < len) {
+		v |= (uint32_t)(unsigned char)str[pt + 1] << 8;
+	}
+	if ((pt + 2) < len) {
+		v |= (uint32_t)(unsigned char)str[pt + 2];
+	}
+	return v;
+}
+
+//static
+//	ASCII(0x00-0x7f)のみか
+//
+//	@param [in] str 文字列
+//	@param [in] len バイト数
+//	@retval true  ASCIIのみ(空も)
+//	@retval false 0x80以上のバイトを含む
+//
+bool KanaUtf8::IsAscii(const char* str, size_t len)
+{
+	size_t i = 0;
+
+#if defined(__wasm_simd128__)
+	for (; (i + 16) <= len; i += 16) {
+		if (wasm_i8x16_bitmask(wasm_v128_load(str + i)) != 0) {
+			return false;
+		}
+	}
+#elif defined(__SSE2__)
+	for (; (i + 16) <= len; i += 16) {
+		if (_mm_movemask_epi8(_mm_loadu_si128((const __m128i*)(str + i))) != 0) {
+			return false;
+		}
+	}
+#endif
+	for (; (i + 8) <= len; i += 8) {
+		uint64_t w;
+		memcpy(&w, str + i, sizeof(w));
+		if ((w & 0x8080808080808080ull) != 0) {
+			return false;
+		}
+	}
+	for (; i < len; i++) {
+		if ((str[i] & 0x80) != 0) {
+			return false;
+		}
+	}
+	return true;
+}
+
+//static
+//	文字列は「漢字」か「かな」か？(isKanaString()と同じ)
+//	ASCIIは「かな」扱い
+//
+//	@param [in] str 文字列(UTF-8)
+//	@param [in] len バイト数
+//	@retval true  文字列はひらがなまたはカタカナ(とASCII)のみである
+//	@retval false 文字列はひらがな、カタカナ以外の文字が含まれている(空も)
+//
+bool KanaUtf8::IsKana(const char* str, size_t len)
+{
+	size_t pt = 0;
+
+	if (IsAscii(str, len)) {
+		return 0 < len;
+	}
+	while (pt < len) {
+		unsigned char lead = (unsigned char)str[pt];
+		size_t cs = lead_size(lead);
+
+		if (cs == 3) {
+			uint32_t v = three_bytes(str, len, pt);
+			if (((v < KANA_UTF8_HIRA_FIRST) || (KANA_UTF8_HIRA_LAST < v)) &&
+				((v < KANA_UTF8_KATA_FIRST) || (KANA_UTF8_KATA_LAST < v))) {
+				return false;
+			}
+		} else if (cs != 1) {
+			return false;		/* 2, 4バイト文字 */
+		}
+		pt += cs;
+	}
+	return true;
+}
+
+//static
+//	カナをかなに(conv_to_kana2hira()と同じ. その場で置き換える)
+//	カナ(U+30A1〜U+30F3)もかなも3バイトなので長さは変わらない
+//	(終端で3バイトに足りない文字はそのまま)
+//
+//	@param [in][out] str  変換文字列
+//
+void KanaUtf8::ToHiragana(tstring& str)
+{
+	size_t len = str.size();
+	size_t pt = 0;
+
+	if (IsAscii(str.data(), len)) {
+		return;
+	}
+	while (pt < len) {
+		size_t cs = lead_size((unsigned char)str[pt]);
+
+		if ((cs == 3) && ((pt + 3) <= len)) {
+			uint32_t v = three_bytes(str.data(), len, pt);
+			if ((KANA_UTF8_KATA_FIRST <= v) && (v <= KANA_UTF8_KATA_LAST)) {
+				if ((KANA_UTF8_DA_FIRST <= v) && (v <= KANA_UTF8_MI_LAST)) {
+					v -= (KANA_UTF8_DA_FIRST - 0xe381a0);		/* ダ -> だ */
+				} else {
+					v -= (KANA_UTF8_KATA_FIRST - KANA_UTF8_HIRA_FIRST);
+				}
+				str[pt] = (char)(v >> 16);
+				str[pt + 1] = (char)(v >> 8);
+				str[pt + 2] = (char)v;
+			}
+		}
+		pt += cs;
+	}
+}
+
+//static
+//	1文字読む
+//
+//	@param [in][out] p   文字の先頭(次の文字へ進める)
+//	@param [in]      end 文字列の終端
+//	@return コードポイント(不正なバイト列は U+FFFD で1バイト進める)
+//
+char32_t KanaUtf8::Decode(const char*& p, const char* end)
+{
+	unsigned char lead = (unsigned char)*p;
+	size_t cs = lead_size(lead);
+	char32_t c;
+	size_t i;
+
+	if (cs == 1) {
+		p++;
+		return lead;
+	}
+	if ((lead < 0xc0) || (0xf8 <= lead) || ((size_t)(end - p) < cs)) {
+		p++;
+		return 0xfffd;
+	}
+	c = lead & (0x7f >> cs);
+	for (i = 1; i < cs; i++) {
+		unsigned char b = (unsigned char)p[i];
+		if ((b & 0xc0) != 0x80) {
+			p++;
+			return 0xfffd;
+		}
+		c = (c << 6) | (b & 0x3f);
+	}
+	p += cs;
+	return c;
+}
+
+#ifdef FARERT_SELFTEST
+/* コードポイント -> UTF-8 */
+static tstring encode_utf8(char32_t c)
+{
+	tstring s;
+
+	if (c < 0x80) {
+		s.push_back((char)c);
+	} else if (c < 0x800) {
+		s.push_back((char)(0xc0 | (c >> 6)));
+		s.push_back((char)(0x80 | (c & 0x3f)));
+	} else if (c < 0x10000) {
+		s.push_back((char)(0xe0 | (c >> 12)));
+		s.push_back((char)(0x80 | ((c >> 6) & 0x3f)));
+		s.push_back((char)(0x80 | (c & 0x3f)));
+	} else {
+		s.push_back((char)(0xf0 | (c >> 18)));
+		s.push_back((char)(0x80 | ((c >> 12) & 0x3f)));
+		s.push_back((char)(0x80 | ((c >> 6) & 0x3f)));
+		s.push_back((char)(0x80 | (c & 0x3f)));
+	}
+	return s;
+}
+
+//static
+//	参照実装(isKanaString(), conv_to_kana2hira())との比較(SELFTEST=1 のビルドのみ)
+//	U+0001〜U+FFFF(サロゲート除く)と一部の4バイト文字の単独・かな／ASCIIとの連結、
+//	終端で切れた文字(かな判定のみ)、ASCIIの長さ0〜40(途中1か所だけかな)、
+//	DBを開いていれば全駅の駅名・よみ・よみのカタカナ表記で比べる
+//
+//	@return 不一致の数
+//
+int32_t KanaUtf8::Verify()
+{
+	int32_t mismatch = 0;
+	vector<tstring> strs;
+	vector<tstring> truncated;
+	tstring ascii;
+	char32_t c;
+
+	for (c = 1; c < 0x10100; c++) {
+		if ((0xd800 <= c) && (c <= 0xdfff)) {
+			continue;
+		}
+		if ((0x10000 <= c) && (c < 0x100f0)) {
+			continue;		/* 4バイト文字は数個で十分 */
+		}
+		tstring s = encode_utf8(c);
+		strs.push_back(s);
+		strs.push_back(u8"あ" + s);
+		strs.push_back(s + u8"ア");
+		strs.push_back("ab" + s + u8"カ");
+		if (1 < s.size()) {
+			truncated.push_back(s.substr(0, s.size() - 1));
+			truncated.push_back(u8"ア" + s.substr(0, s.size() - 1));
+		}
+	}
+	for (size_t len = 0; len <= 40; len++) {
+		strs.push_back(ascii);
+		for (size_t pos = 0; pos < len; pos++) {
+			strs.push_back(ascii.substr(0, pos) + u8"ヂ" + ascii.substr(pos));
+		}
+		ascii.push_back((char)('a' + (len % 26)));
+	}
+	DBO dbo = DBS::getInstance()->compileSql("select name, kana from t_station", false);
+	while (dbo.isvalid() && dbo.moveNext()) {
+		tstring kana = dbo.getText(1);
+		tstring katakana;
+		const char* p = kana.c_str();
+		const char* end = p + kana.size();
+
+		strs.push_back(dbo.getText(0));
+		strs.push_back(kana);
+		while (p < end) {
+			c = KanaUtf8::Decode(p, end);
+			if ((0x3041 <= c) && (c <= 0x3093)) {
+				c += 0x60;
+			}
+			katakana += encode_utf8(c);
+		}
+		strs.push_back(katakana);
+	}
+
+	for (vector<tstring>::const_iterator ite = strs.cbegin(); ite != strs.cend(); ite++) {
+		tstring hira = *ite;
+		tstring reference = *ite;
+
+		if (KanaUtf8::IsKana(*ite) != isKanaString(ite->c_str())) {
+			TRACE("KanaUtf8::Verify IsKana mismatch %s\n", ite->c_str());
+			mismatch++;
+		}
+		KanaUtf8::ToHiragana(hira);
+		conv_to_kana2hira(reference);
+		if (hira != reference) {
+			TRACE("KanaUtf8::Verify ToHiragana mismatch %s\n", ite->c_str());
+			mismatch++;
+		}
+	}
+	for (vector<tstring>::const_iterator ite = truncated.cbegin(); ite != truncated.cend(); ite++) {
+		if (KanaUtf8::IsKana(*ite) != isKanaString(ite->c_str())) {
+			TRACE("KanaUtf8::Verify IsKana mismatch(truncated)\n");
+			mismatch++;
+		}
+	}
+	return mismatch;
+}
+#endif
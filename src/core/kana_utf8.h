@@ -0,0 +1,26 @@
+#ifndef _KANA_UTF8_H__
+#define _KANA_UTF8_H__
+
+#include "alpdb.h"
+
+/*!	@file kana_utf8 UTF-8文字列のかな判定・カナ→かな変換.
+ *	isKanaString(), conv_to_kana2hira()と同じ結果を、文字列を複製せず1回の走査で求める.
+ *	(1文字ずつsubstr()して比較していたのを、先頭バイトで文字長を決め3バイトを整数にして範囲比較する)
+ *	ASCIIのみの文字列は16バイトずつまとめて判定する(wasm SIMD128, SSE2. なければ8バイトずつ).
+ *	isKanaString(), conv_to_kana2hira()は参照実装として残す.
+ */
+
+class KanaUtf8
+{
+public:
+	static bool		IsAscii(const char* str, size_t len);
+	static bool		IsKana(const char* str, size_t len);
+	static bool		IsKana(const tstring& str) { return IsKana(str.data(), str.size()); }
+	static void		ToHiragana(tstring& str);
+	static char32_t	Decode(const char*& p, const char* end);
+#ifdef FARERT_SELFTEST
+	static int32_t	Verify();
+#endif
+};
+
+#endif	/* _KANA_UTF8_H__ */
@@ -0,0 +1,258 @@
+#include "name_table.h"
+
+#include <memory>
+
+////////////////////////////////////////////
+//	NameTable
+//
+
+static unique_ptr<NameTable> name_table;
+
+NameTable::NameTable()
+{
+}
+
+//static
+//	表を得る(初回のみ構築)
+//	返した string_view は Clear() (DBを開き直す)まで有効
+//
+NameTable& NameTable::GetInstance()
+{
+	if (!name_table) {
+		name_table.reset(new NameTable());
+		name_table->build();
+	}
+	return *name_table;
+}
+
+//static
+//	表を破棄(DBを開き直した時)
+//
+void NameTable::Clear()
+{
+	name_table.reset();
+}
+
+//private
+//	(rowid, name) の表を読み込む
+//
+//	@param [in]  sql    select rowid, name from ...
+//	@param [out] spans  [rowid] 名前
+//
+void NameTable::load(const char* sql, vector<Span>& spans)
+{
+	DBO dbo = DBS::getInstance()->compileSql(sql, false);
+
+	while (dbo.moveNext()) {
+		int32_t id = dbo.getInt(0);
+		tstring name = dbo.getText(1);
+
+		if (id < 0) {
+			continue;
+		}
+		if ((int32_t)spans.size() <= id) {
+			spans.resize(id + 1);
+		}
+		spans[id] = Span((uint32_t)arena.size(), (uint32_t)name.size());
+		arena += name;
+	}
+}
+
+//private
+//	t_station, t_line, t_prefect, t_company, t_coreareac, t_jct を読み込む
+//
+void NameTable::build()
+{
+	DBO dbo = DBS::getInstance()->compileSql("select rowid, name, samename, sflg, kana, prefect_id from t_station", false);
+	vector<int32_t> station_ids;	/* 名前→idの対象(GetStationId()と同じく sflg bit18 の駅は除く) */
+
+	arena.reserve(64 * 1024);
+	while (dbo.moveNext()) {
+		int32_t id = dbo.getInt(0);
+		tstring name = dbo.getText(1);
+		tstring samename = dbo.getText(2);
+		tstring kana = dbo.getText(4);
+
+		if ((0 < id) && ((dbo.getInt(3) & (1 << 18)) == 0)) {
+			station_ids.push_back(id);
+		}
+
+		if (id < 0) {
+			continue;
+		}
+		if ((int32_t)station_name.size() <= id) {
+			station_name.resize(id + 1);
+			station_ex.resize(id + 1, 0);
+			station_kana.resize(id + 1);
+			station_prefect.resize(id + 1, 0);
+		}
+		station_name[id] = Span((uint32_t)arena.size(), (uint32_t)name.size());
+		station_ex[id] = (uint32_t)(name.size() + samename.size());
+		arena += name;
+		arena += samename;		/* 駅名の直後に同名駅区別 */
+		station_kana[id] = Span((uint32_t)arena.size(), (uint32_t)kana.size());
+		arena += kana;
+		station_prefect[id] = dbo.getInt(5);
+	}
+	load("select rowid, name from t_line", line_name);
+	load("select rowid, name from t_prefect", prefect_name);
+	load("select rowid, name from t_company", company_name);
+	load("select rowid, name from t_coreareac", corearea_name);
+
+	DBO dbo_j = DBS::getInstance()->compileSql("select id, station_id from t_jct", false);
+	while (dbo_j.moveNext()) {
+		int32_t jct_id = dbo_j.getInt(0);
+
+		if (jct_id < 0) {
+			continue;
+		}
+		if ((int32_t)jct_station.size() <= jct_id) {
+			jct_station.resize(jct_id + 1, 0);
+		}
+		jct_station[jct_id] = dbo_j.getInt(1);
+	}
+
+	makeSlots(station_slot, station_ids.size());
+	for (vector<int32_t>::const_iterator ite = station_ids.cbegin(); ite != station_ids.cend(); ite++) {
+		insert(station_slot, stationNameEx(*ite), *ite, true);
+	}
+	makeSlots(line_slot, line_name.size());
+	for (int32_t id = 1; id < (int32_t)line_name.size(); id++) {
+		if (0 < line_name[id].length) {
+			insert(line_slot, lineName(id), id, false);
+		}
+	}
+}
+
+//private static
+//	名前のハッシュ値(FNV-1a)
+//
+uint32_t NameTable::hash(string_view name)
+{
+	uint32_t h = 2166136261u;
+
+	for (string_view::const_iterator ite = name.cbegin(); ite != name.cend(); ite++) {
+		h ^= (unsigned char)*ite;
+		h *= 16777619u;
+	}
+	return h;
+}
+
+//private static
+//	ハッシュ表を確保(2のべき乗で件数の2倍以上)
+//
+void NameTable::makeSlots(vector<int32_t>& slots, size_t count)
+{
+	size_t size = 16;
+
+	while (size < (count * 2)) {
+		size <<= 1;
+	}
+	slots.assign(size, 0);
+}
+
+//private
+//	ハッシュ表に追加(同じ名前は先に追加したidを残す. DBの select ... limit 1 と同じ)
+//
+void NameTable::insert(vector<int32_t>& slots, string_view name, int32_t id, bool is_station)
+{
+	size_t mask = slots.size() - 1;
+	size_t i = hash(name) & mask;
+
+	while (slots[i] != 0) {
+		if ((is_station ? stationNameEx(slots[i]) : lineName(slots[i])) == name) {
+			return;
+		}
+		i = (i + 1) & mask;
+	}
+	slots[i] = id;
+}
+
+//private
+//	名前からidを引く
+//
+//	@param [in] slots       station_slot or line_slot
+//	@param [in] name        名前
+//	@param [in] is_station  true: 駅名(同名駅区別付き) / false: 路線名
+//	@return id(なければ0)
+//
+int32_t NameTable::find(const vector<int32_t>& slots, string_view name, bool is_station) const
+{
+	size_t mask;
+	size_t i;
+
+	if (slots.empty()) {
+		return 0;
+	}
+	mask = slots.size() - 1;
+	for (i = hash(name) & mask; slots[i] != 0; i = (i + 1) & mask) {
+		if ((is_station ? stationNameEx(slots[i]) : lineName(slots[i])) == name) {
+			return slots[i];
+		}
+	}
+	return 0;
+}
+
+//private
+//	id の名前(なければ空)
+//
+string_view NameTable::view(const vector<Span>& spans, int32_t id) const
+{
+	if ((id < 0) || ((int32_t)spans.size() <= id)) {
+		return string_view();
+	}
+	return string_view(arena.data() + spans[id].offset, spans[id].length);
+}
+
+//	駅名(同名駅区別付き)
+//
+//	@param [in] id  駅id
+//	@return 駅名 "山崎(函)" など(なければ空)
+//
+string_view NameTable::stationNameEx(int32_t id) const
+{
+	if ((id < 0) || ((int32_t)station_name.size() <= id)) {
+		return string_view();
+	}
+	return string_view(arena.data() + station_name[id].offset, station_ex[id]);
+}
+
+//	駅の都道府県名(RouteUtil::GetPrefectByStationId())
+//
+//	@param [in] id  駅id
+//	@return 都道府県名(なければ空)
+//
+string_view NameTable::stationPrefectName(int32_t id) const
+{
+	if ((id < 0) || ((int32_t)station_prefect.size() <= id)) {
+		return string_view();
+	}
+	return prefectName(station_prefect[id]);
+}
+
+//	分岐駅名
+//
+//	@param [in] jctId  分岐id
+//	@return 駅名(なければ空)
+//
+string_view NameTable::jctName(int32_t jctId) const
+{
+	if ((jctId < 0) || ((int32_t)jct_station.size() <= jctId)) {
+		return string_view();
+	}
+	return stationName(jct_station[jctId]);
+}
+
+//	発着駅名(CalcRoute::BeginOrEndStationName())
+//
+//	@param [in] ident  駅id or 都区市内(STATION_ID_AS_CITYNO + 都区市内Id)
+//	@return 駅名(同名駅区別付き) or 都区市内中心駅名
+//
+string_view NameTable::terminalName(int32_t ident) const
+{
+	if (ident < STATION_ID_AS_CITYNO) {
+		return stationNameEx(ident);
+	} else {
+		return coreAreaCenterName(ident - STATION_ID_AS_CITYNO);
+	}
+}
@@ -0,0 +1,69 @@
+#ifndef _NAME_TABLE_H__
+#define _NAME_TABLE_H__
+
+#include "alpdb.h"
+
+#include <string_view>
+
+/*!	@file name_table 駅名・路線名・都道府県名・会社名・都区市内中心駅名の表.
+ *	全ての名前を1本の文字列(arena)に詰め、id -> (位置, 長さ) で string_view を返す.
+ *	駅名の直後に同名駅区別を置くので、駅名(同名駅区別付き)も1つの string_view で返せる.
+ *	駅のよみ(かな)・都道府県も持ち、配列系の名前一括変換(RouteUtility::namesOfIds())もDBを参照しない.
+ *	RouteUtil::StationName()などの1件ごとのDB参照と TCHAR[]へのコピーをなくし、
+ *	経路文字列(Show_route)・運賃表示(showFare)は返した string_view を出力文字列に直接追加する.
+ *	名前→idは駅(同名駅区別付き)・路線それぞれのハッシュ表(開番地法、使用率1/2以下)で引く.
+ *	(Route::setup_route()の1語ごとのDB参照をなくし、駅名と路線名の表を分けて同名でも衝突しない)
+ *	初回参照時に各表を1回ずつ読んで構築し、DBを開き直したらClear()で破棄する.
+ */
+
+class NameTable
+{
+	// arena 内の名前
+	class Span {
+	public:
+		uint32_t offset;
+		uint32_t length;
+		Span() : offset(0), length(0) {}
+		Span(uint32_t offset_, uint32_t length_) : offset(offset_), length(length_) {}
+	};
+	tstring arena;
+	vector<Span> station_name;		// [stationId] 駅名
+	vector<uint32_t> station_ex;	// [stationId] 駅名+同名駅区別の長さ
+	vector<Span> station_kana;		// [stationId] よみ
+	vector<int32_t> station_prefect;	// [stationId] 都道府県id
+	vector<Span> line_name;			// [lineId]
+	vector<Span> prefect_name;		// [prefectId]
+	vector<Span> company_name;		// [companyId]
+	vector<Span> corearea_name;		// [都区市内Id] 中心駅名
+	vector<int32_t> jct_station;	// [jctId] 駅id
+	vector<int32_t> station_slot;	// 駅名(同名駅区別付き)のハッシュ表 駅id(0:空き)
+	vector<int32_t> line_slot;		// 路線名のハッシュ表 路線id(0:空き)
+
+	NameTable();
+	void build();
+	void load(const char* sql, vector<Span>& spans);
+	string_view view(const vector<Span>& spans, int32_t id) const;
+	static uint32_t hash(string_view name);
+	static void makeSlots(vector<int32_t>& slots, size_t count);
+	void insert(vector<int32_t>& slots, string_view name, int32_t id, bool is_station);
+	int32_t find(const vector<int32_t>& slots, string_view name, bool is_station) const;
+public:
+	static NameTable& GetInstance();
+	static void Clear();
+
+	string_view stationName(int32_t id) const { return view(station_name, id); }
+	string_view stationNameEx(int32_t id) const;
+	string_view stationKana(int32_t id) const { return view(station_kana, id); }
+	string_view stationPrefectName(int32_t id) const;
+	string_view lineName(int32_t id) const { return view(line_name, id); }
+	string_view prefectName(int32_t id) const { return view(prefect_name, id); }
+	string_view companyName(int32_t id) const { return view(company_name, id); }
+	string_view coreAreaCenterName(int32_t id) const { return view(corearea_name, id); }
+	string_view jctName(int32_t jctId) const;
+	string_view terminalName(int32_t ident) const;
+
+	int32_t stationId(string_view name) const { return find(station_slot, name, true); }
+	int32_t lineId(string_view name) const { return find(line_slot, name, false); }
+};
+
+#endif	/* _NAME_TABLE_H__ */
@@ -0,0 +1,498 @@
+#include "route_graph.h"
+
+#include <queue>
+#include <functional>
+#include <algorithm>
+#include <memory>
+
+////////////////////////////////////////////
+//	RouteGraph
+//
+RouteGraph::RouteGraph()
+{
+	loaded = false;
+	max_station_id = 0;
+}
+
+static unique_ptr<RouteGraph> route_graph;
+
+//static
+//	インデックスを得る(DBが開いていれば初回のみ読み込む)
+//
+RouteGraph& RouteGraph::getInstance()
+{
+	if (!route_graph) {
+		route_graph.reset(new RouteGraph());
+	}
+	route_graph->load();
+	return *route_graph;
+}
+
+//static
+//	インデックスを破棄(DBを開き直した時)
+//
+void RouteGraph::Clear()
+{
+	route_graph.reset();
+}
+
+// 計算キロ位置(Enum_neer_node()と同じく計算キロ未設定なら営業キロ)
+static int32_t CostPos(const LineStation& ls)
+{
+	return (0 < ls.calcKm) ? ls.calcKm : ls.salesKm;
+}
+
+//private
+//	t_jct, t_node, t_lines を読み込む(初回のみ)
+//
+void RouteGraph::load()
+{
+	if (loaded) {
+		return;
+	}
+	DBO dbo_s = DBS::getInstance()->compileSql("select max(rowid) from t_station", false);
+	if (!dbo_s.isvalid() || !dbo_s.moveNext() || (dbo_s.getInt(0) <= 0)) {
+		return;		/* DB未オープン */
+	}
+	max_station_id = dbo_s.getInt(0);
+
+	station2jct.assign(max_station_id + 1, 0);
+	station_line.assign(max_station_id + 1, 0);
+	jct2station.assign(1, 0);
+	station_company.assign(max_station_id + 1, 0);
+
+	DBO dbo_c = DBS::getInstance()->compileSql("select rowid, company_id, sub_company_id from t_station", false);
+	while (dbo_c.moveNext()) {
+		int32_t stationId = dbo_c.getInt(0);
+		if ((0 < stationId) && (stationId <= max_station_id)) {
+			station_company[stationId] = MAKEPAIR(dbo_c.getInt(1), dbo_c.getInt(2));
+		}
+	}
+
+	DBO dbo_j = DBS::getInstance()->compileSql("select id, station_id from t_jct order by id", false);
+	while (dbo_j.moveNext()) {
+		int32_t jctId = dbo_j.getInt(0);
+		int32_t stationId = dbo_j.getInt(1);
+		if ((int32_t)jct2station.size() <= jctId) {
+			jct2station.resize(jctId + 1, 0);
+		}
+		jct2station[jctId] = stationId;
+		if (stationId <= max_station_id) {
+			station2jct[stationId] = jctId;
+		}
+	}
+	ASSERT((int32_t)jct2station.size() <= MAX_JCT);
+
+	adjacent.assign(jct2station.size(), vector<JctEdge>());
+	DBO dbo_n = DBS::getInstance()->compileSql("select jct_id, neer_id, cost, line_id, attr from t_node", false);
+	while (dbo_n.moveNext()) {
+		JctEdge edge;
+		int32_t jct_id = dbo_n.getInt(0);
+		int32_t neer_id = dbo_n.getInt(1);
+
+		edge.cost = dbo_n.getInt(2);
+		edge.lineId = dbo_n.getInt(3);
+		edge.attr = dbo_n.getInt(4);
+
+		edge.jctId = neer_id;
+		adjacent[jct_id].push_back(edge);
+		edge.jctId = jct_id;
+		adjacent[neer_id].push_back(edge);
+
+		if ((edge.attr == 2) &&
+			!binary_search(local_lines.cbegin(), local_lines.cend(), (int32_t)edge.lineId)) {
+			local_lines.insert(lower_bound(local_lines.begin(), local_lines.end(), (int32_t)edge.lineId), edge.lineId);
+		}
+	}
+
+	DBO dbo_l = DBS::getInstance()->compileSql(
+"select line_id, station_id, sales_km, calc_km, lflg from t_lines order by line_id, sales_km", false);
+	while (dbo_l.moveNext()) {
+		LineStation ls;
+		int32_t lineId = dbo_l.getInt(0);
+
+		ls.stationId = dbo_l.getInt(1);
+		ls.salesKm = dbo_l.getInt(2);
+		ls.calcKm = dbo_l.getInt(3);
+		ls.lflg = (SPECIFICFLAG)dbo_l.getInt(4);
+		line_stations[lineId].push_back(ls);
+
+		if ((0 == (ls.lflg & ((1 << 31) | (1 << 17)))) && (ls.stationId <= max_station_id)) {
+			station_line[ls.stationId] = lineId;	/* 非分岐駅は1つのみ */
+		}
+	}
+	load_station_adjacent();
+	loaded = true;
+}
+
+//private
+//	駅単位の隣接リストを作る(分岐特例・新幹線仮想分岐駅の行は除く)
+//
+void RouteGraph::load_station_adjacent()
+{
+	map<int32_t, vector<LineStation>>::const_iterator itl;
+
+	station_adjacent.assign(max_station_id + 1, vector<StationEdge>());
+
+	for (itl = line_stations.cbegin(); itl != line_stations.cend(); itl++) {
+		vector<LineStation>::const_iterator ite;
+		const LineStation* prev = nullptr;
+
+		for (ite = itl->second.cbegin(); ite != itl->second.cend(); ite++) {
+			if ((0 != (ite->lflg & ((1 << 31) | (1 << 17)))) || (ite->salesKm < 0) ||
+				(max_station_id < ite->stationId)) {
+				continue;
+			}
+			if (prev != nullptr) {
+				StationEdge edge;
+				edge.lineId = itl->first;
+				edge.salesKm = ite->salesKm - prev->salesKm;
+				edge.calcKm = abs(CostPos(*ite) - CostPos(*prev));
+
+				edge.stationId = ite->stationId;
+				station_adjacent[prev->stationId].push_back(edge);
+				edge.stationId = prev->stationId;
+				station_adjacent[ite->stationId].push_back(edge);
+			}
+			prev = &(*ite);
+		}
+	}
+}
+
+//	分岐駅の隣接分岐駅(Node_next()相当)
+//
+const vector<JctEdge>& RouteGraph::nextNode(int32_t jctId) const
+{
+	static const vector<JctEdge> empty;
+
+	if ((jctId <= 0) || ((int32_t)adjacent.size() <= jctId)) {
+		return empty;
+	}
+	return adjacent[jctId];
+}
+
+//	分岐ID→駅ID
+//
+int32_t RouteGraph::jct2id(int32_t jctId) const
+{
+	if ((jctId <= 0) || ((int32_t)jct2station.size() <= jctId)) {
+		return 0;
+	}
+	return jct2station[jctId];
+}
+
+//	駅ID→分岐ID
+//
+int32_t RouteGraph::id2jct(int32_t stationId) const
+{
+	if ((stationId <= 0) || (max_station_id < stationId)) {
+		return 0;
+	}
+	return station2jct[stationId];
+}
+
+//	非分岐駅の所属路線
+//
+int32_t RouteGraph::lineIdFromStationId(int32_t stationId) const
+{
+	if ((stationId <= 0) || (max_station_id < stationId)) {
+		return 0;
+	}
+	return station_line[stationId];
+}
+
+//	路線の駅(営業キロ昇順, lflgによる除外はしない)
+//
+const vector<LineStation>& RouteGraph::stationsOfLine(int32_t lineId) const
+{
+	static const vector<LineStation> empty;
+	map<int32_t, vector<LineStation>>::const_iterator it = line_stations.find(lineId);
+
+	if (it == line_stations.end()) {
+		return empty;
+	}
+	return it->second;
+}
+
+//	両隣の分岐駅を得る(非分岐駅指定, RouteUtil::GetNeerNode()相当)
+//
+//	@param [in] stationId    駅(非分岐駅)
+//	@return PAIRIDENT[2] or PAIRIDENT[1] 近隣の分岐駅(盲腸線の場合1、以外は2)
+//			IDENT1: station_id, IDENT2: calc_km
+//
+vector<PAIRIDENT> RouteGraph::neerNode(int32_t stationId) const
+{
+	vector<PAIRIDENT> result;
+	const vector<LineStation>& stations = stationsOfLine(lineIdFromStationId(stationId));
+	vector<LineStation>::const_iterator ite;
+	vector<LineStation>::const_iterator lower = stations.cend();
+	vector<LineStation>::const_iterator upper = stations.cend();
+	vector<LineStation>::const_iterator self = stations.cend();
+
+	for (ite = stations.cbegin(); ite != stations.cend(); ite++) {
+		if ((ite->stationId == stationId) && (0 == (ite->lflg & ((1 << 31) | (1 << 17))))) {
+			self = ite;
+			break;
+		}
+	}
+	if (self == stations.cend() || (self->salesKm < 0)) {
+		return result;
+	}
+	for (ite = stations.cbegin(); ite != stations.cend(); ite++) {
+		if ((ite->salesKm < 0) ||
+			((ite->lflg & ((1 << 31) | (1 << 17) | (1 << 15))) != (1 << 15))) {
+			continue;
+		}
+		if (ite->salesKm < self->salesKm) {
+			lower = ite;	/* 昇順なので最後が最大 */
+		} else if ((self->salesKm < ite->salesKm) && (upper == stations.cend())) {
+			upper = ite;
+		}
+	}
+	if (lower != stations.cend()) {
+		result.push_back(MAKEPAIR(lower->stationId, abs(CostPos(*self) - CostPos(*lower))));
+	}
+	if (upper != stations.cend()) {
+		result.push_back(MAKEPAIR(upper->stationId, abs(CostPos(*self) - CostPos(*upper))));
+	}
+	return result;
+}
+
+//	隣接駅(駅単位, 非分岐駅も含む)
+//
+const vector<StationEdge>& RouteGraph::nextStation(int32_t stationId) const
+{
+	static const vector<StationEdge> empty;
+
+	if ((stationId <= 0) || (max_station_id < stationId)) {
+		return empty;
+	}
+	return station_adjacent[stationId];
+}
+
+//	地方交通線か(t_node.attr=2の区間を持つ路線)
+//
+bool RouteGraph::isLocalLine(int32_t lineId) const
+{
+	return binary_search(local_lines.cbegin(), local_lines.cend(), lineId);
+}
+
+//	駅の所属会社
+//
+//	@return MAKEPAIR(company_id, sub_company_id) (境界駅以外はsub_company_id=0)
+//
+PAIRIDENT RouteGraph::companyOfStation(int32_t stationId) const
+{
+	if ((stationId <= 0) || (max_station_id < stationId)) {
+		return 0;
+	}
+	return station_company[stationId];
+}
+
+//static
+//	探索条件(changeNeerest()のuseBulletTrain)で通過可能な辺か
+//
+//	@param [in] edge           辺
+//	@param [in] useBulletTrain 0 在来線のみ, bit0:新幹線を利用, bit1:会社線を利用, 100:地方交通線を除く
+//	@retval true 通過可
+//
+bool RouteGraph::IsEnableEdge(const JctEdge& edge, uint8_t useBulletTrain)
+{
+	if (useBulletTrain == 100) {
+		return (edge.attr != 2) && !IS_SHINKANSEN_LINE(edge.lineId) && !IS_COMPANY_LINE(edge.lineId);
+	}
+	return (((0x01 & useBulletTrain) != 0) || !IS_SHINKANSEN_LINE(edge.lineId)) &&
+		   (((0x02 & useBulletTrain) != 0) || !IS_COMPANY_LINE(edge.lineId));
+}
+
+//	探索条件(changeNeerest()のuseBulletTrain)で通過可能な路線か(駅単位の探索用)
+//
+bool RouteGraph::isEnableLine(int32_t lineId, uint8_t useBulletTrain) const
+{
+	if (useBulletTrain == 100) {
+		return !isLocalLine(lineId) && !IS_SHINKANSEN_LINE(lineId) && !IS_COMPANY_LINE(lineId);
+	}
+	return (((0x01 & useBulletTrain) != 0) || !IS_SHINKANSEN_LINE(lineId)) &&
+		   (((0x02 & useBulletTrain) != 0) || !IS_COMPANY_LINE(lineId));
+}
+
+////////////////////////////////////////////
+//	JctPathTree
+//
+JctPathTree::JctPathTree()
+{
+	start_station_id = 0;
+	start_line_id = 0;
+	start_node[0] = start_node[1] = 0;
+}
+
+//	最短経路木の構築
+//
+//	@param [in] start_station_id  発駅
+//	@param [in] useBulletTrain    changeNeerest()と同じ
+//	@retval 0 < 到達分岐駅数
+//	@retval -1 発駅不正
+//
+int32_t JctPathTree::build(int32_t start_station_id_, uint8_t useBulletTrain)
+{
+	const RouteGraph& graph = RouteGraph::getInstance();
+	typedef pair<int32_t, int32_t> QITEM;	// cost, jctId
+	priority_queue<QITEM, vector<QITEM>, greater<QITEM>> que;
+	vector<bool> done;
+	int32_t startNode;
+	int32_t count = 0;
+	int32_t i;
+
+	start_station_id = start_station_id_;
+	start_line_id = 0;
+	start_node[0] = start_node[1] = 0;
+
+	d.assign(graph.numOfJct() + 1, NODE_JCT());
+	for (i = 0; i < (int32_t)d.size(); i++) {
+		d[i].minCost = -1;
+		d[i].fromNode = 0;
+		d[i].lineId = 0;
+	}
+	done.assign(d.size(), false);
+
+	startNode = graph.id2jct(start_station_id);
+	if (startNode == 0) {
+		/* 開始駅は非分岐駅 */
+		vector<PAIRIDENT> neer_node = graph.neerNode(start_station_id);
+		if (neer_node.size() <= 0) {
+			return -1;
+		}
+		start_line_id = graph.lineIdFromStationId(start_station_id);
+		for (i = 0; i < (int32_t)neer_node.size(); i++) {
+			int32_t a = graph.id2jct(IDENT1(neer_node[i]));
+			start_node[i] = a;
+			d[a].minCost = IDENT2(neer_node[i]);
+			d[a].fromNode = -1;		// from駅を-1(分岐駅でないので存在しない分岐駅)として初期化
+			d[a].lineId = start_line_id;
+			que.push(QITEM(d[a].minCost, a));
+		}
+	} else {
+		d[startNode].minCost = 0;
+		que.push(QITEM(0, startNode));
+	}
+
+	while (!que.empty()) {
+		QITEM top = que.top();
+		que.pop();
+		int32_t doneNode = top.second;
+
+		if (done[doneNode] || (top.first != d[doneNode].minCost)) {
+			continue;
+		}
+		done[doneNode] = true;
+		++count;
+
+		const vector<JctEdge>& nodes = graph.nextNode(doneNode);
+		vector<JctEdge>::const_iterator ite;
+		for (ite = nodes.cbegin(); ite != nodes.cend(); ite++) {
+			int32_t a = ite->jctId;
+			int32_t cost;
+
+			if (done[a] || !RouteGraph::IsEnableEdge(*ite, useBulletTrain)) {
+				continue;
+			}
+			cost = d[doneNode].minCost + ite->cost;
+			/* 同一距離に2線ある場合新幹線を採用 */
+			if (((d[a].minCost < 0) || (cost <= d[a].minCost)) &&
+				((cost != d[a].minCost) || IS_SHINKANSEN_LINE(ite->lineId))) {
+				d[a].minCost = cost;
+				d[a].fromNode = doneNode;
+				d[a].lineId = ite->lineId;
+				que.push(QITEM(cost, a));
+			}
+		}
+	}
+	return count;
+}
+
+//	駅(非分岐駅含む)までの最短計算キロ
+//
+//	@param [in]  station_id  着駅
+//	@param [out] pJctId      最後の分岐駅(発駅と同一区間内の非分岐駅なら0)
+//	@param [out] pLineId     最後の分岐駅から着駅への路線(着駅が分岐駅なら0)
+//	@retval 0 <= 計算キロ
+//	@retval -1 到達不可
+//
+int32_t JctPathTree::costOfStation(int32_t station_id, int32_t* pJctId, int32_t* pLineId) const
+{
+	const RouteGraph& graph = RouteGraph::getInstance();
+	int32_t jctId;
+	int32_t lineId;
+	int32_t cost = -1;
+	vector<PAIRIDENT> neer_node;
+	int32_t i;
+
+	*pJctId = 0;
+	*pLineId = 0;
+
+	if (station_id == start_station_id) {
+		*pJctId = graph.id2jct(station_id);
+		return 0;
+	}
+	jctId = graph.id2jct(station_id);
+	if (jctId != 0) {
+		*pJctId = jctId;
+		return d[jctId].minCost;
+	}
+	lineId = graph.lineIdFromStationId(station_id);
+	neer_node = graph.neerNode(station_id);
+	if (neer_node.size() <= 0) {
+		return -1;
+	}
+	*pLineId = lineId;
+
+	if ((start_line_id == lineId) &&
+		(graph.id2jct(IDENT1(neer_node[0])) == start_node[0]) &&
+		((neer_node.size() < 2) || (graph.id2jct(IDENT1(neer_node[1])) == start_node[1]))) {
+		/* 発駅と同一区間(分岐駅を挟まない) */
+		const vector<LineStation>& stations = graph.stationsOfLine(lineId);
+		int32_t pos1 = -1;
+		int32_t pos2 = -1;
+		vector<LineStation>::const_iterator ite;
+		for (ite = stations.cbegin(); ite != stations.cend(); ite++) {
+			if (0 != (ite->lflg & ((1 << 31) | (1 << 17)))) {
+				continue;
+			}
+			if (ite->stationId == station_id) {
+				pos1 = CostPos(*ite);
+			} else if (ite->stationId == start_station_id) {
+				pos2 = CostPos(*ite);
+			}
+		}
+		ASSERT((0 <= pos1) && (0 <= pos2));
+		return abs(pos1 - pos2);
+	}
+	for (i = 0; i < (int32_t)neer_node.size(); i++) {
+		int32_t a = graph.id2jct(IDENT1(neer_node[i]));
+		if ((0 <= d[a].minCost) &&
+			((cost < 0) || ((d[a].minCost + IDENT2(neer_node[i])) < cost))) {
+			cost = d[a].minCost + IDENT2(neer_node[i]);
+			*pJctId = a;
+		}
+	}
+	return cost;
+}
+
+//	最短経路木の子ノード一覧
+//
+//	@return [jctId] 子の分岐ID([0]は非分岐駅の発駅から直接の分岐駅)
+//
+vector<vector<IDENT>> JctPathTree::children() const
+{
+	vector<vector<IDENT>> result(d.size());
+	int32_t i;
+
+	for (i = 1; i < (int32_t)d.size(); i++) {
+		if (d[i].fromNode < 0) {
+			result[0].push_back(i);
+		} else if (0 < d[i].fromNode) {
+			result[d[i].fromNode].push_back(i);
+		}
+	}
+	return result;
+}
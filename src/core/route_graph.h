@@ -0,0 +1,105 @@
+#ifndef _ROUTE_GRAPH_H__
+#define _ROUTE_GRAPH_H__
+
+#include "alpdb.h"
+
+#include <map>
+
+/*!	@file route_graph 分岐駅グラフ(t_node)と路線内駅位置(t_lines)のメモリ常駐インデックス.
+ *	changeNeerest()のNode_next()/GetNeerNode()相当をSQLなしで引く.
+ *	初回参照時に読み込み、DBを開き直したらClear()で破棄する.
+ */
+
+// 路線内駅(t_lines 1レコード)
+class LineStation
+{
+public:
+	IDENT stationId;
+	int32_t salesKm;
+	int32_t calcKm;
+	SPECIFICFLAG lflg;
+};
+
+// 隣接分岐駅(t_node 1レコード)
+class JctEdge
+{
+public:
+	IDENT jctId;		// 隣接分岐ID
+	IDENT lineId;		// 路線
+	int32_t cost;		// 計算キロ
+	int32_t attr;		// 2:地方交通線
+};
+
+// 隣接駅(t_lines 同一路線の隣の駅)
+class StationEdge
+{
+public:
+	IDENT stationId;	// 隣接駅
+	IDENT lineId;		// 路線
+	int32_t salesKm;	// 営業キロ
+	int32_t calcKm;		// 計算キロ
+};
+
+class RouteGraph
+{
+    RouteGraph();
+    bool loaded;
+    int32_t max_station_id;
+    vector<vector<JctEdge>> adjacent;           // [jctId] 隣接分岐駅
+    vector<IDENT> jct2station;                  // [jctId] 駅ID
+    vector<IDENT> station2jct;                  // [stationId] 分岐ID(非分岐駅は0)
+    vector<IDENT> station_line;                 // [stationId] 所属路線(非分岐駅のみ)
+    map<int32_t, vector<LineStation>> line_stations;   // [lineId] 営業キロ昇順
+    vector<vector<StationEdge>> station_adjacent;      // [stationId] 隣接駅(非分岐駅も含む)
+    vector<int32_t> local_lines;                // 地方交通線(t_node.attr=2)の路線ID(昇順)
+    vector<PAIRIDENT> station_company;          // [stationId] MAKEPAIR(company_id, sub_company_id)
+    void load();
+    void load_station_adjacent();
+public:
+    static RouteGraph& getInstance();
+    static void Clear();
+    int32_t numOfJct() const { return (int32_t)jct2station.size() - 1; }
+    int32_t maxStationId() const { return max_station_id; }
+    int32_t maxLineId() const { return line_stations.empty() ? 0 : line_stations.crbegin()->first; }
+    const vector<JctEdge>& nextNode(int32_t jctId) const;
+    int32_t jct2id(int32_t jctId) const;
+    int32_t id2jct(int32_t stationId) const;
+    int32_t lineIdFromStationId(int32_t stationId) const;
+    const vector<LineStation>& stationsOfLine(int32_t lineId) const;
+    vector<PAIRIDENT> neerNode(int32_t stationId) const;
+    const vector<StationEdge>& nextStation(int32_t stationId) const;
+    bool isLocalLine(int32_t lineId) const;
+    PAIRIDENT companyOfStation(int32_t stationId) const;
+
+    static bool IsEnableEdge(const JctEdge& edge, uint8_t useBulletTrain);
+    bool isEnableLine(int32_t lineId, uint8_t useBulletTrain) const;
+};
+
+// 発駅からの全分岐駅への最短経路木(計算キロ)
+//	changeNeerest()のダイクストラと同一の条件(同一距離なら新幹線優先)で構築する
+//
+class JctPathTree
+{
+	class NODE_JCT {
+	public:
+		int32_t minCost;
+		IDENT fromNode;		// 0:未到達 / -1:発駅(非分岐駅)から直接
+		IDENT lineId;
+	};
+	vector<NODE_JCT> d;		// [jctId]
+	int32_t start_station_id;
+	int32_t start_line_id;	// 発駅が非分岐駅の場合の所属路線
+	int32_t start_node[2];	// 発駅が非分岐駅の場合の両隣の分岐ID
+public:
+	JctPathTree();
+	int32_t build(int32_t start_station_id, uint8_t useBulletTrain);
+
+	int32_t minCost(int32_t jctId) const { return d[jctId].minCost; }
+	IDENT fromNode(int32_t jctId) const { return d[jctId].fromNode; }
+	IDENT lineId(int32_t jctId) const { return d[jctId].lineId; }
+	int32_t startStationId() const { return start_station_id; }
+	int32_t costOfStation(int32_t station_id, int32_t* pJctId, int32_t* pLineId) const;
+	vector<vector<IDENT>> children() const;
+};
+
+#endif	/* _ROUTE_GRAPH_H__ */
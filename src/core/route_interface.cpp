@@ -1,9 +1,34 @@
 #include "../include/route_interface.h"
 #include "../db/db.h"
 #include "alpdb.h"
+#include "fare_sweep.h"
+#include "route_search.h"
+#include "station_ch.h"
+#include "fare_batch.h"
+#include "fare_kernel.h"
+#include "rule114.h"
+#include "core_area.h"
+#include "station_search.h"
+#include "station_fuzzy.h"
+#include "kana_utf8.h"
+#include "name_table.h"
+#include "json_writer.h"
+#include "../include/fare_result.h"
 
 // DatabaseManager implementation
 bool DatabaseManager::openDatabase(const std::string& dbPath) {
+    NeerestTreeCache::clear();
+    FareResultCache::clear();
+    FareAggregateCache::clear();
+    OptimizeRouteCache::clear();
+    FareKernel::Clear();
+    StationCH::Clear();
+    Rule114Index::Clear();
+    CoreAreaIndex::Clear();
+    StationSearchIndex::Clear();
+    StationFuzzyIndex::Clear();
+    NameTable::Clear();
+    RouteGraph::Clear();
     return DBS::getInstance()->open(dbPath.c_str());
 }
 
@@ -64,8 +89,28 @@ void RouteWrapper::removeAll() {
 }
 
 int RouteWrapper::autoRoute(int useLine, int arriveStationId) {
-    // TODO: Implement autoRoute functionality
-    return 0;
+    return route->changeNeerest((uint8_t)useLine, arriveStationId);
+}
+
+// 条件付き最短経路(via: (駅ID, 0) または (0, 路線ID) の順序付きリスト, avoidCompanies: 会社IDの並び)
+// 会社IDが1〜31でなければ探索せずSEARCHRC_BADARG
+int RouteWrapper::searchRoute(int arriveStationId, const std::vector<std::pair<int, int>>& via,
+                              const std::vector<int>& avoidLines, const std::vector<int>& avoidCompanies,
+                              int useBulletTrain) {
+    RouteConstraint cond;
+    for (const auto& v : via) {
+        cond.via.push_back(ViaPoint(v.first, v.second));
+    }
+    for (int lineId : avoidLines) {
+        cond.avoidLine(lineId);
+    }
+    for (int companyId : avoidCompanies) {
+        if (!cond.avoidCompany(companyId)) {
+            return SEARCHRC_BADARG;
+        }
+    }
+    cond.useBulletTrain = (uint8_t)useBulletTrain;
+    return RouteSearch::Search(route, arriveStationId, cond);
 }
 
 int RouteWrapper::typeOfPassedLine(int offset) {
@@ -170,40 +215,89 @@ std::string RouteListWrapper::routeScript() const {
 CalcRouteWrapper::CalcRouteWrapper(const RouteWrapper& routeWrapper) {
     calcRoute = new CalcRoute(*routeWrapper.route);
     lastFareResult = -1;  // Initialize to invalid state
+    fareInfo = nullptr;
+    fareInfoMask = 0;
 }
 
 CalcRouteWrapper::CalcRouteWrapper(const RouteWrapper& route, int count) {
     // TODO: Implement constructor with count parameter
     calcRoute = new CalcRoute(*route.route);
     lastFareResult = -1;  // Initialize to invalid state
+    fareInfo = nullptr;
+    fareInfoMask = 0;
 }
 
 CalcRouteWrapper::CalcRouteWrapper(const RouteListWrapper& routeList) {
     calcRoute = new CalcRoute(*routeList.routeList);
     lastFareResult = -1;  // Initialize to invalid state
+    fareInfo = nullptr;
+    fareInfoMask = 0;
 }
 
 CalcRouteWrapper::~CalcRouteWrapper() {
+    delete fareInfo;
     delete calcRoute;
 }
 
 void CalcRouteWrapper::sync(const RouteWrapper& route) {
     calcRoute->sync(*route.route);
+    invalidateFare();
 }
 
 void CalcRouteWrapper::sync(const RouteWrapper& route, int count) {
     // TODO: Implement sync with count parameter
     calcRoute->sync(*route.route);
+    invalidateFare();
+}
+
+// 計算済みの運賃を得る(未計算か、要求項目を計算していなければ計算する)
+FARE_INFO& CalcRouteWrapper::computedFare(int outputMask) const {
+    if ((fareInfo != nullptr) && ((fareInfoMask & outputMask) == outputMask)) {
+        return *fareInfo;
+    }
+    delete fareInfo;
+    fareInfo = new FARE_INFO();
+    fareInfoMask |= outputMask;
+    fareInfo->setOutputMask(fareInfoMask);
+    calcRoute->calcFare(fareInfo);
+    fareText.clear();
+    return *fareInfo;
+}
+
+// 計算済みの運賃を破棄(経路・経路フラグを変更した時)
+void CalcRouteWrapper::invalidateFare() {
+    delete fareInfo;
+    fareInfo = nullptr;
+    fareInfoMask = 0;
+    fareText.clear();
+}
+
+int CalcRouteWrapper::fareResult() {
+    switch (computedFare(FARE_OUT_ALL).resultCode()) {
+        case 0:
+            lastFareResult = 0;
+            break;
+        case -1:
+            lastFareResult = 1;
+            break;
+        default:
+            lastFareResult = -1;
+            break;
+    }
+    return lastFareResult;
 }
 
 std::string CalcRouteWrapper::calcFare() {
-    FARE_INFO fi;  // Using 'fi' to match original c_route.mm variable name
-    int fare_result;
+    return calcFare(FARE_OUT_ALL);
+}
 
-    calcRoute->calcFare(&fi);
-    
-    // Create FareInfoData and populate it exactly like original c_route.mm
-    FareInfoData result;
+// 要求した項目(FARE_OUT_xxx)のみ計算しFareInfoDataに入れる(calcFare(), calcFareBinary())
+// 大人運賃・キロ程・経路フラグは常に入れる
+// 戻り値: 0:正常, 1:経路未完, -1:計算不可(resultは未設定)
+int CalcRouteWrapper::fareInfoData(int outputMask, FareInfoData& result) {
+    FARE_INFO& fi = computedFare(outputMask & FARE_OUT_ALL);  // Using 'fi' to match original c_route.mm variable name
+    int fare_result;
+    auto isRequested = [outputMask](int out) { return (outputMask & out) != 0; };
     
     // Original logic from c_route.mm
     switch (fi.resultCode()) {
@@ -215,7 +309,7 @@ std::string CalcRouteWrapper::calcFare() {
             break;
         default:
             lastFareResult = -1;
-            return "{}"; /* -2:empty or -3:fail - return empty JSON */
+            return -1; /* -2:empty or -3:fail */
             break;
     }
 
@@ -246,27 +340,39 @@ std::string CalcRouteWrapper::calcFare() {
     
     result.fare = fi.getFareForJR();
     result.fareForCompanyline = fi.getFareForCompanyline();
-    result.fareForIC = fi.getFareForIC();
     result.fareForBRT = fi.getFareForBRT();
     result.isBRTdiscount = (fi.getFareForBRT() < fi.getFareForJR());  // Alternative check
-    result.childFare = fi.getChildFareForDisplay();
-    result.academicFare = fi.getAcademicDiscountFare();
     result.ticketAvailDays = fi.getTicketAvailDays();
-    
-    result.routeList = fi.getRoute_string();
-    result.routeListForTOICA = fi.getTOICACalcRoute_string();
-    
-    result.isRoundtrip = calcRoute->refRouteFlag().isRoundTrip();
-    result.isRoundtripDiscount = fi.isRoundTripDiscount();
+    if (isRequested(FARE_OUT_IC)) {
+        result.fareForIC = fi.getFareForIC();
+    }
+    if (isRequested(FARE_OUT_CHILD)) {
+        result.childFare = fi.getChildFareForDisplay();
+    }
+    if (isRequested(FARE_OUT_ACADEMIC)) {
+        result.academicFare = fi.getAcademicDiscountFare();
+    }
+    if (isRequested(FARE_OUT_ROUTE_STRING)) {
+        result.routeList = fi.getRoute_string();
+        result.routeListForTOICA = fi.getTOICACalcRoute_string();
+    }
+    if (isRequested(FARE_OUT_ROUNDTRIP)) {
+        result.isRoundtrip = calcRoute->refRouteFlag().isRoundTrip();
+        result.isRoundtripDiscount = fi.isRoundTripDiscount();
+    }
     
     // Stock discount (114 not applied) - exactly like original c_route.mm
     tstring str1, str2;
-    int w2 = fi.getFareStockDiscount(0, str1);
-    int w3 = fi.getFareStockDiscount(1, str2);
-    result.setFareForStockDiscounts(w2 + fi.getFareForCompanyline(),
-                                    str1,
-                                    w3 + fi.getFareForCompanyline(), 
-                                    str2);
+    int w2;
+    int w3;
+    if (isRequested(FARE_OUT_STOCK)) {
+        w2 = fi.getFareStockDiscount(0, str1);
+        w3 = fi.getFareStockDiscount(1, str2);
+        result.setFareForStockDiscounts(w2 + fi.getFareForCompanyline(),
+                                        str1,
+                                        w3 + fi.getFareForCompanyline(), 
+                                        str2);
+    }
     
     // Rule 114 - exactly like original c_route.mm  
     if (!fi.isRule114()) {
@@ -279,11 +385,13 @@ std::string CalcRouteWrapper::calcFare() {
         result.rule114_calcKm = fi.getRule114CalcKm();
 
         // Stock discount (114 applied) - exactly like original c_route.mm
-        tstring notused;
-        w2 = fi.getFareStockDiscount(0, notused, true);
-        w3 = fi.getFareStockDiscount(1, notused, true);
-        result.setFareForStockDiscountsForR114(w2 + fi.getFareForCompanyline(),
-                                               w3 + fi.getFareForCompanyline());
+        if (isRequested(FARE_OUT_STOCK)) {
+            tstring notused;
+            w2 = fi.getFareStockDiscount(0, notused, true);
+            w3 = fi.getFareStockDiscount(1, notused, true);
+            result.setFareForStockDiscountsForR114(w2 + fi.getFareForCompanyline(),
+                                                   w3 + fi.getFareForCompanyline());
+        }
     }
 
     result.isMeihanCityStartTerminalEnable = calcRoute->refRouteFlag().isMeihanCityEnable();
@@ -294,73 +402,203 @@ std::string CalcRouteWrapper::calcFare() {
     result.isRule115specificTerm = calcRoute->refRouteFlag().isRule115specificTerm();
     result.isEnableRule115 = calcRoute->refRouteFlag().isEnableRule115();
     result.isSpecificFare = (fi.getTicketAvailDays() > 1);  // Alternative check
-    
+    return fare_result;
+}
+
+// 要求した項目(FARE_OUT_xxx)のみ計算しJSONに含める
+// 大人運賃・キロ程・経路フラグは常に含む
+std::string CalcRouteWrapper::calcFare(int outputMask) {
+    auto isRequested = [outputMask](int out) { return (outputMask & out) != 0; };
+    FareInfoData result;
+
+    if (fareInfoData(outputMask, result) < 0) {
+        return "{}"; /* -2:empty or -3:fail - return empty JSON */
+    }
+
     // Convert FareInfoData to JSON string
-    std::string json = "{";
-    json += "\"result\":" + std::to_string(result.result) + ",";
-    json += "\"isResultCompanyBeginEnd\":" + std::string(result.isResultCompanyBeginEnd ? "true" : "false") + ",";
-    json += "\"isResultCompanyMultipassed\":" + std::string(result.isResultCompanyMultipassed ? "true" : "false") + ",";
-    json += "\"beginStationId\":" + std::to_string(result.beginStationId) + ",";
-    json += "\"endStationId\":" + std::to_string(result.endStationId) + ",";
-    json += "\"isBeginInCity\":" + std::string(result.isBeginInCity ? "true" : "false") + ",";
-    json += "\"isEndInCity\":" + std::string(result.isEndInCity ? "true" : "false") + ",";
-    json += "\"totalSalesKm\":" + std::to_string(result.totalSalesKm) + ",";
-    json += "\"jrCalcKm\":" + std::to_string(result.jrCalcKm) + ",";
-    json += "\"jrSalesKm\":" + std::to_string(result.jrSalesKm) + ",";
-    json += "\"companySalesKm\":" + std::to_string(result.companySalesKm) + ",";
-    json += "\"salesKmForHokkaido\":" + std::to_string(result.salesKmForHokkaido) + ",";
-    json += "\"calcKmForHokkaido\":" + std::to_string(result.calcKmForHokkaido) + ",";
-    json += "\"salesKmForKyusyu\":" + std::to_string(result.salesKmForKyusyu) + ",";
-    json += "\"calcKmForKyusyu\":" + std::to_string(result.calcKmForKyusyu) + ",";
-    json += "\"salesKmForShikoku\":" + std::to_string(result.salesKmForShikoku) + ",";
-    json += "\"calcKmForShikoku\":" + std::to_string(result.calcKmForShikoku) + ",";
-    json += "\"brtSalesKm\":" + std::to_string(result.brtSalesKm) + ",";
-    json += "\"fare\":" + std::to_string(result.fare) + ",";
-    json += "\"fareForCompanyline\":" + std::to_string(result.fareForCompanyline) + ",";
-    json += "\"fareForIC\":" + std::to_string(result.fareForIC) + ",";
-    json += "\"fareForBRT\":" + std::to_string(result.fareForBRT) + ",";
-    json += "\"isBRTdiscount\":" + std::string(result.isBRTdiscount ? "true" : "false") + ",";
-    json += "\"childFare\":" + std::to_string(result.childFare) + ",";
-    json += "\"academicFare\":" + std::to_string(result.academicFare) + ",";
-    json += "\"ticketAvailDays\":" + std::to_string(result.ticketAvailDays) + ",";
-    json += "\"routeList\":\"" + result.routeList + "\",";
-    json += "\"routeListForTOICA\":\"" + result.routeListForTOICA + "\",";
-    json += "\"isRoundtrip\":" + std::string(result.isRoundtrip ? "true" : "false") + ",";
-    json += "\"isRoundtripDiscount\":" + std::string(result.isRoundtripDiscount ? "true" : "false") + ",";
+    JsonWriter& json = JsonWriter::Reuse();
+    json.beginObject();
+    json.member("result", result.result);
+    json.member("isResultCompanyBeginEnd", result.isResultCompanyBeginEnd);
+    json.member("isResultCompanyMultipassed", result.isResultCompanyMultipassed);
+    json.member("beginStationId", result.beginStationId);
+    json.member("endStationId", result.endStationId);
+    json.member("isBeginInCity", result.isBeginInCity);
+    json.member("isEndInCity", result.isEndInCity);
+    json.member("totalSalesKm", result.totalSalesKm);
+    json.member("jrCalcKm", result.jrCalcKm);
+    json.member("jrSalesKm", result.jrSalesKm);
+    json.member("companySalesKm", result.companySalesKm);
+    json.member("salesKmForHokkaido", result.salesKmForHokkaido);
+    json.member("calcKmForHokkaido", result.calcKmForHokkaido);
+    json.member("salesKmForKyusyu", result.salesKmForKyusyu);
+    json.member("calcKmForKyusyu", result.calcKmForKyusyu);
+    json.member("salesKmForShikoku", result.salesKmForShikoku);
+    json.member("calcKmForShikoku", result.calcKmForShikoku);
+    json.member("brtSalesKm", result.brtSalesKm);
+    json.member("fare", result.fare);
+    json.member("fareForCompanyline", result.fareForCompanyline);
+    if (isRequested(FARE_OUT_IC)) {
+        json.member("fareForIC", result.fareForIC);
+    }
+    json.member("fareForBRT", result.fareForBRT);
+    json.member("isBRTdiscount", result.isBRTdiscount);
+    if (isRequested(FARE_OUT_CHILD)) {
+        json.member("childFare", result.childFare);
+    }
+    if (isRequested(FARE_OUT_ACADEMIC)) {
+        json.member("academicFare", result.academicFare);
+    }
+    json.member("ticketAvailDays", result.ticketAvailDays);
+    if (isRequested(FARE_OUT_ROUTE_STRING)) {
+        json.member("routeList", result.routeList);
+        json.member("routeListForTOICA", result.routeListForTOICA);
+    }
+    if (isRequested(FARE_OUT_ROUNDTRIP)) {
+        json.member("isRoundtrip", result.isRoundtrip);
+        json.member("isRoundtripDiscount", result.isRoundtripDiscount);
+    }
     
     // Stock discount info using proper FareInfo methods
-    json += "\"availCountForFareOfStockDiscount\":" + std::to_string(result.availCountForFareOfStockDiscount) + ",";
-    json += "\"fareStockDiscount1\":" + std::to_string(result.fareForStockDiscount(0)) + ",";
-    json += "\"fareStockDiscountTitle1\":\"" + result.fareForStockDiscountTitle(0) + "\",";
-    json += "\"fareStockDiscount2\":" + std::to_string(result.fareForStockDiscount(1)) + ",";
-    json += "\"fareStockDiscountTitle2\":\"" + result.fareForStockDiscountTitle(1) + "\",";
+    if (isRequested(FARE_OUT_STOCK)) {
+        json.member("availCountForFareOfStockDiscount", result.availCountForFareOfStockDiscount);
+        json.member("fareStockDiscount1", result.fareForStockDiscount(0));
+        json.member("fareStockDiscountTitle1", result.fareForStockDiscountTitle(0));
+        json.member("fareStockDiscount2", result.fareForStockDiscount(1));
+        json.member("fareStockDiscountTitle2", result.fareForStockDiscountTitle(1));
+    }
     
     // Rule 114 info
-    json += "\"isRule114Applied\":" + std::string(result.isRule114Applied ? "true" : "false") + ",";
-    json += "\"rule114_salesKm\":" + std::to_string(result.rule114_salesKm) + ",";
-    json += "\"rule114_calcKm\":" + std::to_string(result.rule114_calcKm) + ",";
-    json += "\"fareStockDiscountR1141\":" + std::to_string(result.fareForStockDiscount(2)) + ",";
-    json += "\"fareStockDiscountR1142\":" + std::to_string(result.fareForStockDiscount(3)) + ",";
+    if (isRequested(FARE_OUT_RULE114)) {
+        json.member("isRule114Applied", result.isRule114Applied);
+        json.member("rule114_salesKm", result.rule114_salesKm);
+        json.member("rule114_calcKm", result.rule114_calcKm);
+        if (isRequested(FARE_OUT_STOCK)) {
+            json.member("fareStockDiscountR1141", result.fareForStockDiscount(2));
+            json.member("fareStockDiscountR1142", result.fareForStockDiscount(3));
+        }
+    }
     
     // Route flags
-    json += "\"isMeihanCityStartTerminalEnable\":" + std::string(result.isMeihanCityStartTerminalEnable ? "true" : "false") + ",";
-    json += "\"isMeihanCityStart\":" + std::string(result.isMeihanCityStart ? "true" : "false") + ",";
-    json += "\"isMeihanCityTerminal\":" + std::string(result.isMeihanCityTerminal ? "true" : "false") + ",";
-    json += "\"isEnableLongRoute\":" + std::string(result.isEnableLongRoute ? "true" : "false") + ",";
-    json += "\"isLongRoute\":" + std::string(result.isLongRoute ? "true" : "false") + ",";
-    json += "\"isRule115specificTerm\":" + std::string(result.isRule115specificTerm ? "true" : "false") + ",";
-    json += "\"isEnableRule115\":" + std::string(result.isEnableRule115 ? "true" : "false") + ",";
-    json += "\"isSpecificFare\":" + std::string(result.isSpecificFare ? "true" : "false");
-    
-    json += "}";
-    return json;
+    json.member("isMeihanCityStartTerminalEnable", result.isMeihanCityStartTerminalEnable);
+    json.member("isMeihanCityStart", result.isMeihanCityStart);
+    json.member("isMeihanCityTerminal", result.isMeihanCityTerminal);
+    json.member("isEnableLongRoute", result.isEnableLongRoute);
+    json.member("isLongRoute", result.isLongRoute);
+    json.member("isRule115specificTerm", result.isRule115specificTerm);
+    json.member("isEnableRule115", result.isEnableRule115);
+    json.member("isSpecificFare", result.isSpecificFare);
+    json.endObject();
+    return json.str();
+}
+
+// 要求した項目(FARE_OUT_xxx)のみ計算し、結果をバイナリ(fare_result.h)で返す
+// 返した領域は次のcalcFareBinary()の呼び出しかこのオブジェクトの破棄まで有効
+const int32_t* CalcRouteWrapper::calcFareBinary(int outputMask) {
+    FareInfoData result;
+    const std::string* strings[FARE_RESULT_STRING_COUNT];
+    size_t string_bytes = 0;
+    int32_t* words;
+    int32_t flags = 0;
+    size_t pos;
+    int i;
+
+    if (fareInfoData(outputMask, result) < 0) {
+        fareBinary.assign(FARE_RESULT_HEADER_WORDS, 0);
+        words = fareBinary.data();
+        words[FARE_RESULT_W_VERSION] = FARE_RESULT_VERSION;
+        words[FARE_RESULT_W_SIZE] = FARE_RESULT_HEADER_WORDS * sizeof(int32_t);
+        words[FARE_RESULT_W_MASK] = outputMask;
+        words[FARE_RESULT_W_result] = -1;
+        return words;
+    }
+    // FareInfoDataにない値
+    std::string stockTitle1 = result.fareForStockDiscountTitle(0);
+    std::string stockTitle2 = result.fareForStockDiscountTitle(1);
+    int fareStockDiscount1 = result.fareForStockDiscount(0);
+    int fareStockDiscount2 = result.fareForStockDiscount(1);
+    int fareStockDiscountR1141 = result.fareForStockDiscount(2);
+    int fareStockDiscountR1142 = result.fareForStockDiscount(3);
+    if ((outputMask & FARE_OUT_STOCK) == 0) {
+        result.availCountForFareOfStockDiscount = 0;
+        fareStockDiscount1 = fareStockDiscount2 = 0;
+        fareStockDiscountR1141 = fareStockDiscountR1142 = 0;
+    }
+    if ((outputMask & FARE_OUT_RULE114) == 0) {
+        result.isRule114Applied = false;
+        result.rule114_salesKm = result.rule114_calcKm = 0;
+        fareStockDiscountR1141 = fareStockDiscountR1142 = 0;
+    }
+
+    strings[FARE_RESULT_S_routeList] = &result.routeList;
+    strings[FARE_RESULT_S_routeListForTOICA] = &result.routeListForTOICA;
+    strings[FARE_RESULT_S_fareStockDiscountTitle1] = &stockTitle1;
+    strings[FARE_RESULT_S_fareStockDiscountTitle2] = &stockTitle2;
+    for (i = 0; i < FARE_RESULT_STRING_COUNT; i++) {
+        string_bytes += strings[i]->size() + 1;
+    }
+    fareBinary.assign(FARE_RESULT_HEADER_WORDS + (string_bytes + 3) / 4, 0);
+    words = fareBinary.data();
+    words[FARE_RESULT_W_VERSION] = FARE_RESULT_VERSION;
+    words[FARE_RESULT_W_SIZE] = (int32_t)(fareBinary.size() * sizeof(int32_t));
+    words[FARE_RESULT_W_MASK] = outputMask;
+
+    // FARE_RESULT_INT_FIELDSに足したら、ここで値を入れること
+    static_assert(FARE_RESULT_W_STRINGS - FARE_RESULT_W_result == 28, "FARE_RESULT_INT_FIELDS changed");
+#define FARE_RESULT_X(name) words[FARE_RESULT_W_##name] = name;
+    FARE_RESULT_X(fareStockDiscount1)
+    FARE_RESULT_X(fareStockDiscount2)
+    FARE_RESULT_X(fareStockDiscountR1141)
+    FARE_RESULT_X(fareStockDiscountR1142)
+#undef FARE_RESULT_X
+#define FARE_RESULT_X(name) words[FARE_RESULT_W_##name] = result.name;
+    FARE_RESULT_X(result)
+    FARE_RESULT_X(beginStationId)
+    FARE_RESULT_X(endStationId)
+    FARE_RESULT_X(totalSalesKm)
+    FARE_RESULT_X(jrCalcKm)
+    FARE_RESULT_X(jrSalesKm)
+    FARE_RESULT_X(companySalesKm)
+    FARE_RESULT_X(salesKmForHokkaido)
+    FARE_RESULT_X(calcKmForHokkaido)
+    FARE_RESULT_X(salesKmForKyusyu)
+    FARE_RESULT_X(calcKmForKyusyu)
+    FARE_RESULT_X(salesKmForShikoku)
+    FARE_RESULT_X(calcKmForShikoku)
+    FARE_RESULT_X(brtSalesKm)
+    FARE_RESULT_X(fare)
+    FARE_RESULT_X(fareForCompanyline)
+    FARE_RESULT_X(fareForIC)
+    FARE_RESULT_X(fareForBRT)
+    FARE_RESULT_X(childFare)
+    FARE_RESULT_X(academicFare)
+    FARE_RESULT_X(ticketAvailDays)
+    FARE_RESULT_X(availCountForFareOfStockDiscount)
+    FARE_RESULT_X(rule114_salesKm)
+    FARE_RESULT_X(rule114_calcKm)
+#undef FARE_RESULT_X
+#define FARE_RESULT_X(name) if (result.name) { flags |= (1 << FARE_RESULT_F_##name); }
+    FARE_RESULT_FLAG_FIELDS(FARE_RESULT_X)
+#undef FARE_RESULT_X
+    words[FARE_RESULT_W_FLAGS] = flags;
+
+    pos = FARE_RESULT_HEADER_WORDS * sizeof(int32_t);
+    for (i = 0; i < FARE_RESULT_STRING_COUNT; i++) {
+        words[FARE_RESULT_W_STRINGS + 2 * i] = (int32_t)pos;
+        words[FARE_RESULT_W_STRINGS + 2 * i + 1] = (int32_t)strings[i]->size();
+        memcpy((char*)words + pos, strings[i]->data(), strings[i]->size());
+        pos += strings[i]->size() + 1;      /* '\0' */
+    }
+    return words;
 }
 
 std::string CalcRouteWrapper::showFare() const {
     // Original implementation from c_route.mm
-    FARE_INFO fi;
-    calcRoute->calcFare(&fi);
-    return fi.showFare(calcRoute->getRouteFlag());
+    FARE_INFO& fi = computedFare(FARE_OUT_ALL);
+    if (fareText.empty()) {
+        fareText = fi.showFare(calcRoute->getRouteFlag());
+    }
+    return fareText;
 }
 
 // Options and settings
@@ -382,16 +620,19 @@ void CalcRouteWrapper::setSpecificTermRule115(bool enable) {
 void CalcRouteWrapper::setStartAsCity() {
     // Original implementation from c_route.mm
     calcRoute->refRouteFlag().setStartAsCity();
+    invalidateFare();
 }
 
 void CalcRouteWrapper::setArriveAsCity() {
     // Original implementation from c_route.mm
     calcRoute->refRouteFlag().setArriveAsCity();
+    invalidateFare();
 }
 
 void CalcRouteWrapper::setLongRoute(bool flag) {
     // Original implementation from c_route.mm
     calcRoute->refRouteFlag().setLongRoute(flag);
+    invalidateFare();
 }
 
 // Route list operations (inherited from RouteList)
@@ -478,6 +719,58 @@ std::string RouteUtility::getKanaFromStationId(int stationId) {
     return kanaName.empty() ? "" : kanaName;
 }
 
+// idの並びの名前を1本の文字列に詰める(1件ごとの std::string を作らない)
+//  kind: NAME_xxx, offsets: ids.size() + 1 個(名前iは names の [offsets[i], offsets[i+1]). 名前がなければ空)
+//  戻り値 0:正常, -1:kind不正(names, offsetsは空)
+int RouteUtility::namesOfIds(int kind, const std::vector<int>& ids, std::string& names, std::vector<int>& offsets) {
+    const NameTable& table = NameTable::GetInstance();
+    
+    names.clear();
+    offsets.clear();
+    if ((kind < NAME_STATION) || (NAME_PREFECT < kind)) {
+        return -1;
+    }
+    names.reserve(ids.size() * 16);
+    offsets.reserve(ids.size() + 1);
+    offsets.push_back(0);
+    for (std::vector<int>::const_iterator ite = ids.cbegin(); ite != ids.cend(); ite++) {
+        switch (kind) {
+            case NAME_STATION:    names += table.stationName(*ite); break;
+            case NAME_STATION_EX: names += table.stationNameEx(*ite); break;
+            case NAME_LINE:       names += table.lineName(*ite); break;
+            case NAME_KANA:       names += table.stationKana(*ite); break;
+            case NAME_PREFECT:    names += table.stationPrefectName(*ite); break;
+        }
+        offsets.push_back((int)names.size());
+    }
+    return 0;
+}
+
+// 詰めた名前の並びのid(namesOfIds()の逆. 見つからない名前・範囲外は0)
+//  kind: NAME_STATION / NAME_STATION_EX (同名駅区別付きで引く. getStationId()と同じ), NAME_LINE
+//  戻り値: offsets.size() - 1 個のid(kind不正は空)
+std::vector<int> RouteUtility::idsOfNames(int kind, const std::string& names, const std::vector<int>& offsets) {
+    const NameTable& table = NameTable::GetInstance();
+    std::vector<int> ids;
+    
+    if (((kind != NAME_STATION) && (kind != NAME_STATION_EX) && (kind != NAME_LINE)) || offsets.empty()) {
+        return ids;
+    }
+    ids.reserve(offsets.size() - 1);
+    for (size_t i = 1; i < offsets.size(); i++) {
+        int begin = offsets[i - 1];
+        int end = offsets[i];
+        
+        if ((begin < 0) || (end < begin) || ((int)names.size() < end)) {
+            ids.push_back(0);
+            continue;
+        }
+        std::string_view name(names.data() + begin, end - begin);
+        ids.push_back((kind == NAME_LINE) ? table.lineId(name) : table.stationId(name));
+    }
+    return ids;
+}
+
 // Company and prefecture operations
 RouteUtility::CompanyPrefectData RouteUtility::getCompanyAndPrefects() {
     CompanyPrefectData data;
@@ -499,16 +792,17 @@ RouteUtility::CompanyPrefectData RouteUtility::getCompanyAndPrefects() {
 }
 
 std::vector<int> RouteUtility::keyMatchStations(const std::string& key) {
-    std::vector<int> stations;
-    DBO dbo = RouteUtil::Enum_station_match(key.c_str());
-    
-    if (dbo.isvalid()) {
-        while (dbo.moveNext()) {
-            stations.push_back(dbo.getInt(1)); // station_id
-        }
-    }
-    
-    return stations;
+    return keyMatchStations(key, 0);
+}
+
+std::vector<int> RouteUtility::keyMatchStations(const std::string& key, int limit) {
+    // Enum_station_match()と同じ駅・同じ順(かな順)をインデックスから引く
+    return StationSearchIndex::GetInstance().match(key.c_str(), limit);
+}
+
+std::vector<int> RouteUtility::fuzzyMatchStations(const std::string& key, int limit) {
+    // ローマ字・半角カナ・打ち間違いを許す(n-gramインデックス)
+    return StationFuzzyIndex::GetInstance().match(key.c_str(), limit);
 }
 
 std::vector<int> RouteUtility::linesFromCompanyOrPrefect(int id) {
@@ -537,6 +831,131 @@ std::vector<int> RouteUtility::stationsWithinCompanyOrPrefectAndLine(int company
     return stations;
 }
 
+std::vector<int> RouteUtility::fareOfAllStations(int startStationId, int useBulletTrain, int companyOrPrefectId) {
+    return FareSweep::FareOfAllStations(startStationId, (uint8_t)useBulletTrain, companyOrPrefectId);
+}
+
+std::vector<RouteUtility::ReachableStationData> RouteUtility::reachableStations(int startStationId, int useBulletTrain, int maxSalesKm, int maxFare) {
+    std::vector<ReachableStationData> result;
+    std::vector<ReachStation> reach = FareSweep::ReachableStations(startStationId, (uint8_t)useBulletTrain, maxSalesKm, maxFare);
+    for (const auto& rs : reach) {
+        ReachableStationData data;
+        data.stationId = rs.stationId;
+        data.salesKm = rs.salesKm;
+        data.fare = rs.fare;
+        data.route = rs.route;
+        result.push_back(data);
+    }
+    return result;
+}
+
+RouteUtility::RouteCacheStats RouteUtility::getRouteCacheStats() {
+    RouteCacheStats stats;
+    stats.hits = NeerestTreeCache::hitCount();
+    stats.misses = NeerestTreeCache::missCount();
+    stats.size = NeerestTreeCache::size();
+    stats.capacity = NeerestTreeCache::capacity();
+    return stats;
+}
+
+void RouteUtility::setRouteCacheCapacity(int capacity) {
+    NeerestTreeCache::setCapacity(capacity);
+}
+
+RouteUtility::RouteCacheStats RouteUtility::getFareCacheStats() {
+    RouteCacheStats stats;
+    stats.hits = FareResultCache::hitCount();
+    stats.misses = FareResultCache::missCount();
+    stats.size = FareResultCache::size();
+    stats.capacity = FareResultCache::capacity();
+    return stats;
+}
+
+void RouteUtility::setFareCacheCapacity(int capacity) {
+    FareResultCache::setCapacity(capacity);
+}
+
+RouteUtility::RouteCacheStats RouteUtility::getFareAggregateStats() {
+    RouteCacheStats stats;
+    stats.hits = FareAggregateCache::hitCount();
+    stats.misses = FareAggregateCache::missCount();
+    stats.size = FareAggregateCache::size();
+    stats.capacity = FareAggregateCache::capacity();
+    return stats;
+}
+
+void RouteUtility::setFareAggregateCapacity(int capacity) {
+    FareAggregateCache::setCapacity(capacity);
+}
+
+RouteUtility::RouteCacheStats RouteUtility::getOptimizeRouteCacheStats() {
+    RouteCacheStats stats;
+    stats.hits = OptimizeRouteCache::hitCount();
+    stats.misses = OptimizeRouteCache::missCount();
+    stats.size = OptimizeRouteCache::size();
+    stats.capacity = OptimizeRouteCache::capacity();
+    return stats;
+}
+
+int RouteUtility::getOptimizeRoutePrunedCount() {
+    return OptimizeRouteCache::prunedCount();
+}
+
+void RouteUtility::setOptimizeRouteCacheCapacity(int capacity) {
+    OptimizeRouteCache::setCapacity(capacity);
+}
+
+#ifdef FARERT_SELFTEST
+int RouteUtility::verifyFareKernel(int tax) {
+    return FareKernel::Verify(tax);
+}
+#endif
+
+#ifdef FARERT_SELFTEST
+int RouteUtility::verifyKanaUtf8() {
+    return KanaUtf8::Verify();
+}
+#endif
+
+std::vector<int> RouteUtility::fareOfKmArray(int kind, const std::vector<int>& km, int tax) {
+    if ((kind < 0) || (FK_NUM <= kind)) {
+        return std::vector<int>();
+    }
+    std::vector<int32_t> kms(km.begin(), km.end());
+    std::vector<int32_t> fares(kms.size());
+    FareKernel::FareArray((FAREKERNEL)kind, kms.data(), fares.data(), (int32_t)kms.size(), tax);
+    return std::vector<int>(fares.begin(), fares.end());
+}
+
+int RouteUtility::shortestDistance(int stationId1, int stationId2, bool salesKm, int useBulletTrain) {
+    return StationCH::getInstance(salesKm, (uint8_t)useBulletTrain).distance(stationId1, stationId2);
+}
+
+std::vector<int> RouteUtility::fareBatchOfScripts(const std::string& scripts) {
+    std::vector<int32_t> results;
+    FareBatch::FareOfScripts(scripts.c_str(), &results);
+    return std::vector<int>(results.begin(), results.end());
+}
+
+std::vector<int> RouteUtility::fareBatchOfScripts(const std::string& scripts, const std::vector<int>& taxes) {
+    std::vector<int32_t> results;
+    FareBatch::FareOfScripts(scripts.c_str(), std::vector<int32_t>(taxes.begin(), taxes.end()), &results);
+    return std::vector<int>(results.begin(), results.end());
+}
+
+std::vector<int> RouteUtility::fareBatchOfPacked(const std::vector<int>& packed) {
+    std::vector<int32_t> results;
+    FareBatch::FareOfPacked(std::vector<int32_t>(packed.begin(), packed.end()), &results);
+    return std::vector<int>(results.begin(), results.end());
+}
+
+std::vector<int> RouteUtility::fareBatchOfPacked(const std::vector<int>& packed, const std::vector<int>& taxes) {
+    std::vector<int32_t> results;
+    FareBatch::FareOfPacked(std::vector<int32_t>(packed.begin(), packed.end()),
+                            std::vector<int32_t>(taxes.begin(), taxes.end()), &results);
+    return std::vector<int>(results.begin(), results.end());
+}
+
 // Station properties
 std::string RouteUtility::getTerminalName(int stationId) {
     return CalcRoute::BeginOrEndStationName(stationId);
@@ -0,0 +1,326 @@
+#include "route_search.h"
+
+#include <queue>
+#include <functional>
+
+////////////////////////////////////////////
+//	RouteConstraint
+//
+
+//	通らない路線を追加
+//
+void RouteConstraint::avoidLine(int32_t lineId)
+{
+	if (lineId <= 0) {
+		return;
+	}
+	if ((int32_t)avoid_line.size() <= lineId) {
+		avoid_line.resize(lineId + 1, false);
+	}
+	avoid_line[lineId] = true;
+}
+
+////////////////////////////////////////////
+//	RouteSearch
+//
+
+//static
+//	条件付き最短経路(計算キロ)
+//
+//	駅単位のグラフを (駅, 満たした経由条件の数) の組を状態として探索する.
+//	経由駅の先で折り返すなど同一駅を2度通る経路はadd()できないので、状態ごとに最短の1経路だけを
+//	残すダイクストラ法では、残した経路が後の区間と駅を共有すると迂回する経路を見つけられない.
+//	このため部分経路(Label)ごとに経路上の駅を判定し、同じ状態でも別の部分経路は別に探索する(A*).
+//	推定値は同一駅を2度通ることを許した着駅までの計算キロ(CostToGoal())で、実際の残りより長くならない.
+//	同一駅を2度通らずに済む場合は、最短経路上の部分経路のみ取り出して最短経路を求める.
+//	2度通る必要がある場合は、探索量を抑えるため1つの状態から展開する部分経路を
+//	SEARCH_LABELS_PER_STATE 本(短い順)までとする. この場合は近似で、最短でないか経路なしとなることがある.
+//	同一距離なら新幹線以外の計算キロが短い経路を採る.
+//	除外路線・会社・新幹線は探索前に路線マスクとして作り、辺ごとに判定する.
+//	結果は発駅から順に一時経路にadd()して組み立て、すべての区間をadd()できた時のみ経路を置き換える.
+//
+//	@param [in/out] route          経路(発駅のみ参照. 成功時のみ結果の経路で置き換える)
+//	@param [in]     end_station_id 着駅
+//	@param [in]     cond           探索条件
+//	@retval 0 <= 最後のadd()の戻り値(ADDRC_xxx)
+//	@retval SEARCHRC_xxx 経路なし・引数不正・打ち切り・途中終了(経路は変更しない)
+//	@retval それ以外の負数 add()のエラー(経路は変更しない)
+//
+int32_t RouteSearch::Search(Route* route, int32_t end_station_id, const RouteConstraint& cond)
+{
+	typedef pair<pair<int32_t, int32_t>, int32_t> QITEM;	/* (推定計算キロ, 新幹線以外の計算キロ), Label */
+	const RouteGraph& graph = RouteGraph::getInstance();
+	const int32_t num_station = graph.maxStationId() + 1;
+	const int32_t num_via = (int32_t)cond.via.size();
+	int32_t start_station_id = route->departureStationId();
+	vector<bool> line_mask;			/* [lineId] 通過可 */
+	vector<int32_t> h;				/* [状態] 状態 = 満たした経由条件の数 * num_station + 駅 */
+	vector<Label> labels;
+	vector<int32_t> mark;			/* [駅] 取り出した部分経路上の駅なら その番号 + 1 */
+	vector<uint8_t> expanded;		/* [状態] 取り出した部分経路の数 */
+	priority_queue<QITEM, vector<QITEM>, greater<QITEM>> q;
+	int32_t goal;
+	int32_t found = -1;
+	int32_t pops = 0;
+	int32_t k;
+	int32_t i;
+	int32_t lineId;
+
+	if ((start_station_id <= 0) || (end_station_id <= 0) || (num_station <= end_station_id) ||
+		(start_station_id == end_station_id)) {
+		return SEARCHRC_BADARG;
+	}
+
+	line_mask.assign(graph.maxLineId() + 1, false);
+	for (lineId = 1; lineId <= graph.maxLineId(); lineId++) {
+		line_mask[lineId] = graph.isEnableLine(lineId, cond.useBulletTrain) && !cond.isAvoidLine(lineId);
+	}
+
+	/* 発駅が経由駅 */
+	for (k = 0; (k < num_via) && (cond.via[k].stationId == start_station_id); k++) {
+		;
+	}
+	goal = num_via * num_station + end_station_id;
+	RouteSearch::CostToGoal(graph, line_mask, cond, start_station_id, end_station_id, h);
+	if (h[k * num_station + start_station_id] == INT32_MAX) {
+		return SEARCHRC_NOROUTE;
+	}
+	mark.assign(num_station, 0);
+	expanded.assign(h.size(), 0);
+	labels.push_back(Label(k * num_station + start_station_id, 0, 0, -1, 0));
+	q.push(QITEM(make_pair(h[labels.back().state], 0), 0));
+
+	while (!q.empty()) {
+		int32_t index = q.top().second;
+		int32_t state = labels[index].state;
+		int32_t station_id = state % num_station;
+		int32_t level = state / num_station;
+		int32_t cost = labels[index].cost;
+		int32_t local_km = labels[index].local_km;
+		vector<StationEdge>::const_iterator ite;
+
+		q.pop();
+		if (state == goal) {
+			found = index;
+			break;
+		}
+		if (SEARCH_LABELS_PER_STATE <= expanded[state]) {
+			continue;
+		}
+		expanded[state]++;
+		if (SEARCH_LABEL_MAX <= ++pops) {
+			return SEARCHRC_LIMIT;
+		}
+		/* 部分経路上の駅に印を付ける(辺ごとに経路をたどらない) */
+		for (i = index; 0 <= i; i = labels[i].parent) {
+			mark[labels[i].state % num_station] = index + 1;
+		}
+		for (ite = graph.nextStation(station_id).cbegin(); ite != graph.nextStation(station_id).cend(); ite++) {
+			int32_t next;
+
+			if (mark[ite->stationId] == (index + 1)) {
+				continue;	/* 同一駅を2度通る経路はadd()できない */
+			}
+			if (!RouteSearch::IsPassableEdge(graph, line_mask, cond, start_station_id, end_station_id, station_id, *ite)) {
+				continue;
+			}
+			next = RouteSearch::NextLevel(cond, level, *ite) * num_station + ite->stationId;
+			if (h[next] == INT32_MAX) {
+				continue;	/* 着駅に達しない */
+			}
+			labels.push_back(Label(next, cost + ite->calcKm,
+								   local_km + (IS_SHINKANSEN_LINE(ite->lineId) ? 0 : ite->calcKm), index, ite->lineId));
+			q.push(QITEM(make_pair(labels.back().cost + h[next], labels.back().local_km), (int32_t)labels.size() - 1));
+		}
+	}
+	if (found < 0) {
+		return SEARCHRC_NOROUTE;
+	}
+
+	/* 着駅から逆にたどり、同一路線の区間をまとめる */
+	vector<PAIRIDENT> section;		/* MAKEPAIR(lineId, 区間の終端駅) 着駅側から */
+	for (i = found; 0 <= labels[i].parent; i = labels[i].parent) {
+		if (section.empty() || (IDENT1(section.back()) != labels[i].lineId)) {
+			section.push_back(MAKEPAIR(labels[i].lineId, labels[i].state % num_station));
+		}
+	}
+
+	vector<PAIRIDENT>::const_reverse_iterator itr;
+	Route result(*route);		/* 経路のフラグ(小倉-博多間新在別線など)は引き継ぐ */
+	int32_t rc = SEARCHRC_NOROUTE;
+
+	result.removeAll();
+	if (result.add(start_station_id) < 0) {
+		return SEARCHRC_BADARG;
+	}
+	for (itr = section.crbegin(); itr != section.crend(); itr++) {
+		rc = result.add(IDENT1(*itr), IDENT2(*itr));
+		if (rc < 0) {
+			return rc;
+		}
+		if ((rc != ADDRC_OK) && ((itr + 1) != section.crend())) {
+			return SEARCHRC_INCOMPLETE;
+		}
+	}
+	*route = result;
+	return rc;
+}
+
+//static private
+//	辺を通った後の満たした経由条件の数
+//
+//	@param [in] cond   探索条件
+//	@param [in] level  辺の始点までに満たした経由条件の数
+//	@param [in] edge   辺
+//	@return 満たした経由条件の数
+//
+int32_t RouteSearch::NextLevel(const RouteConstraint& cond, int32_t level, const StationEdge& edge)
+{
+	const int32_t num_via = (int32_t)cond.via.size();
+	int32_t k = level;
+
+	if ((k < num_via) && (cond.via[k].lineId == edge.lineId)) {
+		k++;	/* 経由路線を通過 */
+	}
+	while ((k < num_via) && (cond.via[k].stationId == edge.stationId)) {
+		k++;	/* 経由駅に到着 */
+	}
+	return k;
+}
+
+//static private
+//	着駅までの計算キロの下限(同一駅を2度通ることを許した最短距離)
+//
+//	着駅の状態から辺を逆向きにたどるダイクストラ法. 隣接駅の表は双方向(同じ路線・キロ程)であること.
+//
+//	@param [in]  graph            グラフ
+//	@param [in]  line_mask        [lineId] 通過可能な路線
+//	@param [in]  cond             探索条件
+//	@param [in]  start_station_id 発駅
+//	@param [in]  end_station_id   着駅
+//	@param [out] h                [状態] 着駅までの計算キロ(INT32_MAX: 着駅に達しない)
+//
+void RouteSearch::CostToGoal(const RouteGraph& graph, const vector<bool>& line_mask, const RouteConstraint& cond,
+							 int32_t start_station_id, int32_t end_station_id, vector<int32_t>& h)
+{
+	typedef pair<int32_t, int32_t> QITEM;		/* 計算キロ, 状態 */
+	const int32_t num_station = graph.maxStationId() + 1;
+	const int32_t num_via = (int32_t)cond.via.size();
+	priority_queue<QITEM, vector<QITEM>, greater<QITEM>> q;
+	int32_t goal = num_via * num_station + end_station_id;
+
+	h.assign(num_station * (num_via + 1), INT32_MAX);
+	h[goal] = 0;
+	q.push(QITEM(0, goal));
+	while (!q.empty()) {
+		int32_t cost = q.top().first;
+		int32_t state = q.top().second;
+		int32_t station_id = state % num_station;
+		int32_t level = state / num_station;
+		vector<StationEdge>::const_iterator ite;
+
+		q.pop();
+		if (h[state] < cost) {
+			continue;
+		}
+		for (ite = graph.nextStation(station_id).cbegin(); ite != graph.nextStation(station_id).cend(); ite++) {
+			StationEdge edge = *ite;		/* ite->stationId から station_id への辺 */
+			int32_t k;
+
+			edge.stationId = station_id;
+			if (!RouteSearch::IsPassableEdge(graph, line_mask, cond, start_station_id, end_station_id, ite->stationId, edge)) {
+				continue;
+			}
+			for (k = 0; k <= level; k++) {
+				int32_t prev = k * num_station + ite->stationId;
+
+				if ((RouteSearch::NextLevel(cond, k, edge) == level) && ((cost + edge.calcKm) < h[prev])) {
+					h[prev] = cost + edge.calcKm;
+					q.push(QITEM(h[prev], prev));
+				}
+			}
+		}
+	}
+}
+
+//static private
+//	新幹線のみの駅(上毛高原など)または会社線のみの駅(海部など)か
+//
+//	@param [in] graph      グラフ
+//	@param [in] station_id 駅
+//	@param [in] lineId     駅の所属路線
+//	@retval true 駅の所属路線がすべて新幹線(lineIdが新幹線の場合)または会社線(lineIdが会社線の場合)
+//
+bool RouteSearch::IsOnlyLineKind(const RouteGraph& graph, int32_t station_id, int32_t lineId)
+{
+	vector<StationEdge>::const_iterator ite;
+
+	if (!IS_SHINKANSEN_LINE(lineId) && !IS_COMPANY_LINE(lineId)) {
+		return false;
+	}
+	for (ite = graph.nextStation(station_id).cbegin(); ite != graph.nextStation(station_id).cend(); ite++) {
+		if ((IS_SHINKANSEN_LINE(ite->lineId) != IS_SHINKANSEN_LINE(lineId)) ||
+			(IS_COMPANY_LINE(ite->lineId) != IS_COMPANY_LINE(lineId))) {
+			return false;
+		}
+	}
+	return true;
+}
+
+//static private
+//	探索で通過可能な辺か
+//
+//	@param [in] graph         グラフ
+//	@param [in] line_mask     [lineId] 通過可能な路線
+//	@param [in] avoid_company 通らない会社(bit[company_id])
+//	@param [in] station_id1   辺の始点
+//	@param [in] edge          辺
+//	@retval true 通過可
+//
+bool RouteSearch::IsEnableEdge(const RouteGraph& graph, const vector<bool>& line_mask, uint32_t avoid_company,
+							   int32_t station_id1, const StationEdge& edge)
+{
+	if (((int32_t)line_mask.size() <= edge.lineId) || !line_mask[edge.lineId]) {
+		return false;
+	}
+	if (avoid_company != 0) {
+		/* 区間の会社 = 両端駅の所属会社(境界駅は2社)の共通部分. すべて除外対象なら通らない */
+		PAIRIDENT c1 = graph.companyOfStation(station_id1);
+		PAIRIDENT c2 = graph.companyOfStation(edge.stationId);
+		uint32_t m1 = (1u << (IDENT1(c1) & 31)) | ((IDENT2(c1) != 0) ? (1u << (IDENT2(c1) & 31)) : 0);
+		uint32_t m2 = (1u << (IDENT1(c2) & 31)) | ((IDENT2(c2) != 0) ? (1u << (IDENT2(c2) & 31)) : 0);
+		uint32_t common = m1 & m2;
+
+		if (common == 0) {
+			common = m1 | m2;
+		}
+		if ((common & ~avoid_company) == 0) {
+			return false;
+		}
+	}
+	return true;
+}
+
+//static private
+//	探索で通る辺か(IsEnableEdge() に加え、新幹線・会社線のみの駅の発着は利用しない指定でも使う)
+//
+//	@param [in] graph            グラフ
+//	@param [in] line_mask        [lineId] 通過可能な路線
+//	@param [in] cond             探索条件
+//	@param [in] start_station_id 発駅
+//	@param [in] end_station_id   着駅
+//	@param [in] station_id1      辺の始点
+//	@param [in] edge             辺
+//	@retval true 通過可
+//
+bool RouteSearch::IsPassableEdge(const RouteGraph& graph, const vector<bool>& line_mask, const RouteConstraint& cond,
+								 int32_t start_station_id, int32_t end_station_id, int32_t station_id1, const StationEdge& edge)
+{
+	if (RouteSearch::IsEnableEdge(graph, line_mask, cond.avoid_company, station_id1, edge)) {
+		return true;
+	}
+	/* changeNeerest()と同じ */
+	return !cond.isAvoidLine(edge.lineId) &&
+		   (((station_id1 == start_station_id) && RouteSearch::IsOnlyLineKind(graph, station_id1, edge.lineId)) ||
+			((edge.stationId == end_station_id) && RouteSearch::IsOnlyLineKind(graph, end_station_id, edge.lineId)));
+}
@@ -0,0 +1,81 @@
+#ifndef _ROUTE_SEARCH_H__
+#define _ROUTE_SEARCH_H__
+
+#include "route_graph.h"
+
+/*!	@file route_search 条件付き最短経路探索(経由駅・経由路線, 除外路線・会社・新幹線).
+ *	changeNeerest()は新幹線/会社線/地方交通線の利用有無のみ指定可能.
+ *	同一駅を2度通らない経路のうち計算キロ最短のものを求める(部分経路ごとに経路上の駅を判定する).
+ *	迂回が必要な場合は状態ごとの部分経路数を制限した近似(RouteSearch::Search()参照).
+ */
+
+// 経由条件(駅または路線のどちらか一方を指定)
+class ViaPoint
+{
+public:
+	IDENT stationId;	// 経由駅(0:路線指定)
+	IDENT lineId;		// 経由路線(0:駅指定)
+	ViaPoint() : stationId(0), lineId(0) {}
+	ViaPoint(IDENT station_id, IDENT line_id) : stationId(station_id), lineId(line_id) {}
+};
+
+// 探索条件
+class RouteConstraint
+{
+	vector<bool> avoid_line;		// [lineId] 通らない路線
+public:
+	vector<ViaPoint> via;			// 経由(この順に通る)
+	uint32_t avoid_company;			// 通らない会社(bit[company_id])
+	uint8_t useBulletTrain;			// changeNeerest()と同じ(新幹線を除外するならbit0=0)
+
+	RouteConstraint() : avoid_company(0), useBulletTrain(1) {}
+	void avoidLine(int32_t lineId);
+	bool isAvoidLine(int32_t lineId) const {
+		return (0 < lineId) && (lineId < (int32_t)avoid_line.size()) && avoid_line[lineId];
+	}
+	bool avoidCompany(int32_t companyId) {
+		if ((companyId <= 0) || (32 <= companyId)) {
+			return false;		/* avoid_companyのビットにない */
+		}
+		avoid_company |= (1u << companyId);
+		return true;
+	}
+};
+
+// Search()の戻り値(add()のエラー -1〜-N と重ならない値)
+#define SEARCHRC_NOROUTE	(-1000)		// 条件を満たす経路なし
+#define SEARCHRC_BADARG		(-1001)		// 引数不正(発駅未設定・着駅不正・発駅=着駅・会社ID範囲外)
+#define SEARCHRC_LIMIT		(-1002)		// 探索数の上限(SEARCH_LABEL_MAX)で打ち切り
+#define SEARCHRC_INCOMPLETE	(-1003)		// 着駅の手前でadd()が経路の終了を返した
+
+// 探索で取り出す部分経路数の上限(全体, 1つの状態あたり)
+#define SEARCH_LABEL_MAX		200000
+#define SEARCH_LABELS_PER_STATE	4
+
+class RouteSearch
+{
+	// 探索中の部分経路(末端の状態と、1つ前の部分経路)
+	class Label {
+	public:
+		int32_t state;		// 満たした経由条件の数 * 駅数 + 駅
+		int32_t cost;		// 計算キロ
+		int32_t local_km;	// 新幹線以外の計算キロ(同一距離の経路の選択用)
+		int32_t parent;		// 1つ前のLabel(-1: 発駅)
+		IDENT lineId;		// 1つ前の駅からの路線
+		Label(int32_t state_, int32_t cost_, int32_t local_km_, int32_t parent_, IDENT lineId_) :
+			state(state_), cost(cost_), local_km(local_km_), parent(parent_), lineId(lineId_) {}
+	};
+public:
+	static int32_t Search(Route* route, int32_t end_station_id, const RouteConstraint& cond);
+private:
+	static int32_t NextLevel(const RouteConstraint& cond, int32_t level, const StationEdge& edge);
+	static bool IsOnlyLineKind(const RouteGraph& graph, int32_t station_id, int32_t lineId);
+	static bool IsEnableEdge(const RouteGraph& graph, const vector<bool>& line_mask, uint32_t avoid_company,
+							 int32_t station_id1, const StationEdge& edge);
+	static bool IsPassableEdge(const RouteGraph& graph, const vector<bool>& line_mask, const RouteConstraint& cond,
+							   int32_t start_station_id, int32_t end_station_id, int32_t station_id1, const StationEdge& edge);
+	static void CostToGoal(const RouteGraph& graph, const vector<bool>& line_mask, const RouteConstraint& cond,
+						   int32_t start_station_id, int32_t end_station_id, vector<int32_t>& h);
+};
+
+#endif	/* _ROUTE_SEARCH_H__ */
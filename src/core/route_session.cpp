@@ -0,0 +1,140 @@
+#include "route_session.h"
+
+////////////////////////////////////////////
+//	RouteSessionPool
+//
+
+#define SESSION_SLOT_MASK		0xffff
+#define SESSION_GENERATION_MAX	0x7fff
+#define SESSION_SLOT_MAX		(SESSION_SLOT_MASK + 1)
+
+static std::unique_ptr<RouteSessionPool> route_session_pool;
+
+RouteSessionPool::RouteSessionPool()
+{
+}
+
+//static
+//	プールを得る(初回のみ生成)
+//	DBを開き直しても経路はそのまま使えるので破棄しない
+//
+RouteSessionPool& RouteSessionPool::GetInstance()
+{
+	if (!route_session_pool) {
+		route_session_pool.reset(new RouteSessionPool());
+	}
+	return *route_session_pool;
+}
+
+//private
+//	ハンドルのセッション
+//
+//	@param [in] handle  Create()の戻り値
+//	@return 使用中で世代が一致すればセッション、それ以外は nullptr
+//
+RouteSessionPool::Session* RouteSessionPool::session(int32_t handle) const
+{
+	uint32_t slot;
+	Session* s;
+
+	if (handle <= 0) {
+		return nullptr;
+	}
+	slot = (uint32_t)handle & SESSION_SLOT_MASK;
+	if (sessions.size() <= slot) {
+		return nullptr;
+	}
+	s = sessions[slot].get();
+	if (!s->used || (s->generation != (uint32_t)handle >> 16)) {
+		return nullptr;
+	}
+	return s;
+}
+
+//	セッションを作る(空きスロットがあれば使い回す)
+//
+//	@return ハンドル(1以上), -1: スロットが一杯
+//
+int32_t RouteSessionPool::Create()
+{
+	uint16_t slot;
+	Session* s;
+
+	if (!free_slots.empty()) {
+		slot = free_slots.back();
+		free_slots.pop_back();
+	} else if (sessions.size() < SESSION_SLOT_MAX) {
+		slot = (uint16_t)sessions.size();
+		sessions.emplace_back(new Session());
+	} else {
+		return -1;
+	}
+	s = sessions[slot].get();
+	s->used = true;
+	return ((int32_t)s->generation << 16) | slot;
+}
+
+//	セッションを破棄(経路を空にしてスロットを空きに戻す. 以後このハンドルは無効)
+//
+//	@param [in] handle  Create()の戻り値
+//	@retval true 破棄した
+//	@retval false 無効なハンドル
+//
+bool RouteSessionPool::Destroy(int32_t handle)
+{
+	Session* s = session(handle);
+
+	if (s == nullptr) {
+		return false;
+	}
+	s->route.removeAll();
+	s->route.setNotSameKokuraHakataShinZai(false);
+	s->calculated = false;
+	s->generation = (s->generation < SESSION_GENERATION_MAX) ? (s->generation + 1) : 1;
+	s->used = false;
+	free_slots.push_back((uint16_t)((uint32_t)handle & SESSION_SLOT_MASK));
+	return true;
+}
+
+//	経路
+//
+//	@return 無効なハンドルは nullptr
+//
+RouteWrapper* RouteSessionPool::RouteOf(int32_t handle) const
+{
+	Session* s = session(handle);
+
+	return (s != nullptr) ? &s->route : nullptr;
+}
+
+//	直前のCalculate()の運賃計算
+//
+//	@return 無効なハンドルか、まだ計算していなければ nullptr
+//
+CalcRouteWrapper* RouteSessionPool::CalcOf(int32_t handle) const
+{
+	Session* s = session(handle);
+
+	return ((s != nullptr) && s->calculated) ? s->calc.get() : nullptr;
+}
+
+//	今の経路で運賃計算を準備(前回のCalcRouteWrapperがあれば経路を写して使い回す)
+//	運賃はCalcRouteWrapperの calcFare() などで計算する
+//
+//	@return 無効なハンドルは nullptr
+//
+CalcRouteWrapper* RouteSessionPool::Calculate(int32_t handle)
+{
+	Session* s = session(handle);
+
+	if (s == nullptr) {
+		return nullptr;
+	}
+	if (!s->calc) {
+		s->calc.reset(new CalcRouteWrapper(s->route));
+	} else {
+		s->calc->sync(s->route);
+	}
+	s->calculated = true;
+	return s->calc.get();
+}
@@ -0,0 +1,45 @@
+#ifndef _ROUTE_SESSION_H__
+#define _ROUTE_SESSION_H__
+
+#include "../include/route_interface.h"
+
+#include <memory>
+
+/*!	@file route_session 経路セッション(RouteWrapper + CalcRouteWrapper)のハンドル管理.
+ *	1つのモジュールで複数の経路を同時に扱うため、経路ごとに整数のハンドルを返す.
+ *	セッションは破棄しても解放せず、経路を空にして次のCreate()で使い回す(空きスロットのリスト).
+ *	ハンドルは スロット番号(下位16bit) と 世代(上位15bit) で、破棄するたびに世代を進めるので
+ *	破棄したハンドルや使い回された後の古いハンドルは無効(nullptr)になる.
+ */
+
+class RouteSessionPool
+{
+	// セッション(スロット)
+	class Session {
+	public:
+		RouteWrapper route;
+		std::unique_ptr<CalcRouteWrapper> calc;	// 1度も計算していなければnullptr
+		bool calculated;						// 今のセッションで計算済み(calcが有効)
+		bool used;
+		uint16_t generation;					// 1〜0x7fff
+		Session() : calculated(false), used(false), generation(1) {}
+	};
+	std::vector<std::unique_ptr<Session>> sessions;
+	std::vector<uint16_t> free_slots;
+
+	RouteSessionPool();
+	Session* session(int32_t handle) const;
+public:
+	static RouteSessionPool& GetInstance();
+
+	int32_t Create();
+	bool Destroy(int32_t handle);
+	RouteWrapper* RouteOf(int32_t handle) const;
+	CalcRouteWrapper* CalcOf(int32_t handle) const;
+	CalcRouteWrapper* Calculate(int32_t handle);
+
+	int32_t activeCount() const { return (int32_t)(sessions.size() - free_slots.size()); }
+	int32_t slotCount() const { return (int32_t)sessions.size(); }
+};
+
+#endif	/* _ROUTE_SESSION_H__ */
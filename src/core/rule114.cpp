@@ -0,0 +1,215 @@
+#include "rule114.h"
+
+#include <memory>
+#include <algorithm>
+
+////////////////////////////////////////////
+//	Rule114Index
+//
+
+static unique_ptr<Rule114Index> rule114_index;
+
+Rule114Index::Rule114Index()
+{
+	max_station_id = 0;
+}
+
+//static
+//	インデックスを得る(初回のみ構築)
+//
+Rule114Index& Rule114Index::GetInstance()
+{
+	if (!rule114_index) {
+		rule114_index.reset(new Rule114Index());
+		rule114_index->build();
+	}
+	return *rule114_index;
+}
+
+//static
+//	インデックスを破棄(DBを開き直した時)
+//
+void Rule114Index::Clear()
+{
+	rule114_index.reset();
+}
+
+//private
+//	t_lines, t_station を読み込む
+//
+void Rule114Index::build()
+{
+	DBO dbo_s = DBS::getInstance()->compileSql("select max(rowid) from t_station", false);
+	if (dbo_s.isvalid() && dbo_s.moveNext()) {
+		max_station_id = dbo_s.getInt(0);
+	}
+	station_lines.assign(max_station_id + 1, vector<int32_t>());
+	station_lines_loaded.assign(max_station_id + 1, false);
+
+	DBO dbo = DBS::getInstance()->compileSql(
+"select l.line_id, l.station_id, l.sales_km, l.lflg, t.sflg from t_lines l"
+" left join t_station t on t.rowid=l.station_id order by l.line_id, l.sales_km", false);
+	while (dbo.moveNext()) {
+		int32_t line_id = dbo.getInt(0);
+		int32_t station_id = dbo.getInt(1);
+		int32_t sales_km = dbo.getInt(2);
+		SPECIFICFLAG lflg = (SPECIFICFLAG)dbo.getInt(3);
+		SPECIFICFLAG sflg = (SPECIFICFLAG)dbo.getInt(4);
+
+		sales_km_of[MAKEPAIR(line_id, station_id)] = sales_km;
+		if ((lflg & ((1 << 17) | (1u << 31))) == 0) {
+			bool junction = ((lflg & (1 << 15)) != 0) && ((sflg & (1 << 12)) != 0);
+			line_stops[line_id].push_back(Stop(sales_km, (IDENT)station_id, junction));
+		}
+	}
+}
+
+//private
+//	路線の駅(営業キロ昇順). 路線がなければnullptr
+//
+const vector<Rule114Index::Stop>* Rule114Index::stopsOf(int32_t line_id) const
+{
+	map<int32_t, vector<Stop>>::const_iterator ite = line_stops.find(line_id);
+
+	if (ite == line_stops.end()) {
+		return nullptr;
+	}
+	return &ite->second;
+}
+
+//static private
+//	起点駅からの探索距離
+//	旧実装のSQL(%uで埋め込み)と同じく、負になる場合は符号なし32bitとして扱う(=路線の端まで)
+//
+//	@param [in] cond_km   下り: 100=1000, 200=2000(上り: -1000 / -2000)
+//	@param [in] km_offset 中心駅から起点駅までの営業キロ
+//	@return 距離
+//
+int64_t Rule114Index::Range(int32_t cond_km, int32_t km_offset)
+{
+	if (cond_km < 0) {
+		cond_km = -cond_km;
+	}
+	return (int64_t)(uint32_t)(cond_km - km_offset);
+}
+
+//	指定路線・駅からの100/200km到達地点の駅を得る
+//
+//	@param [in] cond_km    下り: 100=1000, 200=2000(上り: -1000 / -2000)
+//	@param [in] km_offset  中心駅から起点駅までの営業キロ
+//	@param [in] line_id    路線
+//	@param [in] station_id 起点駅
+//	@retval 到達駅id. 0はなし
+//
+int32_t Rule114Index::reachPoint(int32_t cond_km, int32_t km_offset, int32_t line_id, int32_t station_id) const
+{
+	const vector<Stop>* stops = stopsOf(line_id);
+	unordered_map<PAIRIDENT, int32_t>::const_iterator itk = sales_km_of.find(MAKEPAIR(line_id, station_id));
+	vector<Stop>::const_iterator ite;
+	int64_t range = Range(cond_km, km_offset);
+
+	if ((stops == nullptr) || (itk == sales_km_of.end())) {
+		return 0;
+	}
+	if (cond_km < 0) {
+		/* 上り: 起点から range より遠い最初の駅 */
+		int64_t limit = itk->second - range;
+		ite = lower_bound(stops->cbegin(), stops->cend(), limit,
+						  [](const Stop& stop, int64_t km) { return stop.salesKm < km; });
+		if (ite == stops->cbegin()) {
+			return 0;
+		}
+		return (--ite)->stationId;
+	} else {
+		/* 下り */
+		int64_t limit = itk->second + range;
+		ite = upper_bound(stops->cbegin(), stops->cend(), limit,
+						  [](int64_t km, const Stop& stop) { return km < stop.salesKm; });
+		if (ite == stops->cend()) {
+			return 0;
+		}
+		return ite->stationId;
+	}
+}
+
+//	指定路線・駅から、指定方面へ100/200kmまでの分岐駅を得る(起点駅に近い順)
+//
+//	@param [in]	cond_km		  上り ／ 下り, 86(200km) or 87(100km)
+//	@param [in] base_sales_km 86,87条中心駅からの指定駅までの営業キロ
+//	@param [in] line_id       指定路線
+//	@param [in] station_id    指定駅
+//	@return [](one:指定駅からの営業キロ, two:分岐駅)
+//
+vector<IntPair> Rule114Index::junctionRange(int32_t cond_km, int32_t base_sales_km, int32_t line_id, int32_t station_id) const
+{
+	const vector<Stop>* stops = stopsOf(line_id);
+	unordered_map<PAIRIDENT, int32_t>::const_iterator itk = sales_km_of.find(MAKEPAIR(line_id, station_id));
+	vector<IntPair> result;
+	int64_t range = Range(cond_km, base_sales_km);
+	int32_t base_km;
+
+	if ((stops == nullptr) || (itk == sales_km_of.end())) {
+		return result;
+	}
+	base_km = itk->second;
+	if (cond_km < 0) {
+		/* 上り */
+		vector<Stop>::const_reverse_iterator ite;
+		ite = vector<Stop>::const_reverse_iterator(
+				lower_bound(stops->cbegin(), stops->cend(), base_km,
+							[](const Stop& stop, int32_t km) { return stop.salesKm < km; }));
+		for (; (ite != stops->crend()) && ((base_km - range) <= ite->salesKm); ite++) {
+			if (ite->junction) {
+				result.push_back(IntPair(base_km - ite->salesKm, ite->stationId));
+			}
+		}
+	} else {
+		/* 下り */
+		vector<Stop>::const_iterator ite;
+		ite = upper_bound(stops->cbegin(), stops->cend(), base_km,
+						  [](int32_t km, const Stop& stop) { return km < stop.salesKm; });
+		for (; (ite != stops->cend()) && (ite->salesKm <= (base_km + range)); ite++) {
+			if (ite->junction) {
+				result.push_back(IntPair(ite->salesKm - base_km, ite->stationId));
+			}
+		}
+	}
+	return result;
+}
+
+//	駅の所属する路線一覧を返す（新幹線・会社線・BRT除く, 路線名かな順）
+//	初回のみDBから引いて以降は保持する
+//
+//	@param [in] station_id 駅
+//	@return 路線一覧
+//
+const vector<int32_t>& Rule114Index::linesOfStation(int32_t station_id)
+{
+	static const vector<int32_t> empty;
+
+	if ((station_id <= 0) || (max_station_id < station_id)) {
+		return empty;
+	}
+	if (!station_lines_loaded[station_id]) {
+		DBO lines = RouteUtil::Enum_line_of_stationId(station_id);
+		vector<int32_t>& results = station_lines[station_id];
+
+		if (lines.isvalid()) {
+			while (lines.moveNext()) {
+				int lflg = lines.getInt(2);
+				if (((1<<31) & lflg) == 0) {
+					int line_id = lines.getInt(1);
+					if (!IS_SHINKANSEN_LINE(line_id) && !IS_COMPANY_LINE(line_id)
+					   && !IS_BRT_LINE(line_id)) {
+						results.push_back(line_id);
+					}
+				}
+			}
+		} else {
+			TRACE("Could execute query Enum_line_of_stationId()\n");
+			ASSERT(FALSE);
+		}
+		station_lines_loaded[station_id] = true;
+	}
+	return station_lines[station_id];
+}
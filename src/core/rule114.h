@@ -0,0 +1,45 @@
+#ifndef _RULE114_H__
+#define _RULE114_H__
+
+#include "alpdb.h"
+
+#include <unordered_map>
+
+/*!	@file rule114 114条判定(CalcRoute::CRule114)用の路線内駅インデックス.
+ *	路線ごとの駅の営業キロ昇順配列(t_lines)と駅の所属路線一覧をメモリに持ち、
+ *	100km/200km到達駅と到達までの分岐駅をSQLなしで二分探索で引く.
+ *	初回参照時にt_lines, t_stationを1回ずつ読んで構築し、DBを開き直したらClear()で破棄する.
+ */
+
+class Rule114Index
+{
+	// 路線内駅(lflg bit17, bit31 の駅は除く)
+	class Stop {
+	public:
+		int32_t salesKm;
+		IDENT stationId;
+		bool junction;		// 分岐駅(lflg bit15 かつ sflg bit12)
+		Stop(int32_t salesKm_, IDENT stationId_, bool junction_) :
+			salesKm(salesKm_), stationId(stationId_), junction(junction_) {}
+	};
+	int32_t max_station_id;
+	map<int32_t, vector<Stop>> line_stops;				// [lineId] 営業キロ昇順
+	unordered_map<PAIRIDENT, int32_t> sales_km_of;		// [MAKEPAIR(lineId, stationId)] 営業キロ(lflgによる除外なし)
+	vector<vector<int32_t>> station_lines;				// [stationId] 所属路線(未取得は空)
+	vector<bool> station_lines_loaded;					// [stationId] station_linesを取得済み
+
+	Rule114Index();
+	void build();
+	const vector<Stop>* stopsOf(int32_t line_id) const;
+	static int64_t Range(int32_t cond_km, int32_t km_offset);
+public:
+	static Rule114Index& GetInstance();
+	static void Clear();
+
+	int32_t maxStationId() const { return max_station_id; }
+	int32_t reachPoint(int32_t cond_km, int32_t km_offset, int32_t line_id, int32_t station_id) const;
+	vector<IntPair> junctionRange(int32_t cond_km, int32_t base_sales_km, int32_t line_id, int32_t station_id) const;
+	const vector<int32_t>& linesOfStation(int32_t station_id);
+};
+
+#endif	/* _RULE114_H__ */
@@ -0,0 +1,292 @@
+#include "station_ch.h"
+
+#include <queue>
+#include <functional>
+#include <memory>
+
+#define CH_WITNESS_SETTLE_LIMIT	500		/* 証人探索の確定ノード数上限(超えたらショートカットを張る) */
+
+static map<int32_t, unique_ptr<StationCH>> station_ch_instances;
+
+////////////////////////////////////////////
+//	StationCH
+//
+StationCH::StationCH(bool sales_km_, uint8_t useBulletTrain_)
+{
+	sales_km = sales_km_;
+	useBulletTrain = useBulletTrain_;
+	num_shortcut = 0;
+}
+
+//static
+//	インデックスを得る(初回のみ構築)
+//
+//	@param [in] sales_km       true:営業キロ, false:計算キロ
+//	@param [in] useBulletTrain changeNeerest()と同じ(0:在来線のみ, 1:新幹線, 2:会社線, 3:両方, 100:地方交通線除く)
+//
+StationCH& StationCH::getInstance(bool sales_km, uint8_t useBulletTrain)
+{
+	int32_t key = (sales_km ? 0x100 : 0) | useBulletTrain;
+	map<int32_t, unique_ptr<StationCH>>::iterator ite = station_ch_instances.find(key);
+
+	if (ite == station_ch_instances.end()) {
+		StationCH* ch = new StationCH(sales_km, useBulletTrain);
+		ch->build();
+		ite = station_ch_instances.insert(make_pair(key, unique_ptr<StationCH>(ch))).first;
+	}
+	return *ite->second;
+}
+
+//static
+//	インデックスを破棄(DBを開き直した時)
+//
+void StationCH::Clear()
+{
+	station_ch_instances.clear();
+}
+
+//static private
+//	無向辺を追加(同じ駅間に既に辺があれば短い方を残す)
+//
+void StationCH::AddEdge(vector<vector<CHEdge>>& g, IDENT from, IDENT to, int32_t cost)
+{
+	vector<CHEdge>::iterator ite;
+
+	for (ite = g[from].begin(); ite != g[from].end(); ite++) {
+		if (ite->to == to) {
+			if (cost < ite->cost) {
+				ite->cost = cost;
+			}
+			return;
+		}
+	}
+	g[from].push_back(CHEdge(to, cost));
+}
+
+//static private
+//	証人探索: sourceからskipを通らずに各駅へ行く距離(max_costまで)
+//
+//	@param [in]  g          グラフ
+//	@param [in]  contracted [stationId] 縮約済み
+//	@param [in]  source     始点
+//	@param [in]  skip       通らない駅(縮約する駅)
+//	@param [in]  max_cost   探索する距離の上限
+//	@param [out] dist       [stationId] 距離(INT32_MAX:未到達). visitedの駅のみ設定される
+//	@param [out] visited    距離を設定した駅
+//	@return 確定した駅数
+//
+int32_t StationCH::WitnessSearch(const vector<vector<CHEdge>>& g, const vector<bool>& contracted,
+								 IDENT source, IDENT skip, int32_t max_cost, vector<int32_t>& dist, vector<IDENT>& visited)
+{
+	typedef pair<int32_t, IDENT> QITEM;
+	priority_queue<QITEM, vector<QITEM>, greater<QITEM>> q;
+	int32_t settled = 0;
+
+	dist[source] = 0;
+	visited.push_back(source);
+	q.push(QITEM(0, source));
+
+	while (!q.empty() && (settled < CH_WITNESS_SETTLE_LIMIT)) {
+		int32_t cost = q.top().first;
+		IDENT node = q.top().second;
+		vector<CHEdge>::const_iterator ite;
+
+		q.pop();
+		if (dist[node] < cost) {
+			continue;
+		}
+		if (max_cost < cost) {
+			break;
+		}
+		settled++;
+		for (ite = g[node].cbegin(); ite != g[node].cend(); ite++) {
+			if ((ite->to == skip) || contracted[ite->to]) {
+				continue;
+			}
+			if ((cost + ite->cost) < dist[ite->to]) {
+				if (dist[ite->to] == INT32_MAX) {
+					visited.push_back(ite->to);
+				}
+				dist[ite->to] = cost + ite->cost;
+				q.push(QITEM(dist[ite->to], ite->to));
+			}
+		}
+	}
+	return settled;
+}
+
+//private
+//	駅を縮約する(simulate=trueなら必要なショートカット数を数えるだけ)
+//
+//	@return 辺の増減(ショートカット数 - 未縮約の隣接駅数)
+//
+int32_t StationCH::contract(vector<vector<CHEdge>>& g, const vector<bool>& contracted, IDENT node, bool simulate,
+							vector<int32_t>& dist, vector<IDENT>& visited)
+{
+	vector<CHEdge> neighbor;
+	vector<CHEdge>::const_iterator ite;
+	int32_t shortcut = 0;
+	int32_t max_out = 0;
+	size_t i;
+	size_t j;
+
+	for (ite = g[node].cbegin(); ite != g[node].cend(); ite++) {
+		if (!contracted[ite->to]) {
+			neighbor.push_back(*ite);
+			if (max_out < ite->cost) {
+				max_out = ite->cost;
+			}
+		}
+	}
+	for (i = 0; i < neighbor.size(); i++) {
+		vector<IDENT>::const_iterator itv;
+
+		StationCH::WitnessSearch(g, contracted, neighbor[i].to, node, neighbor[i].cost + max_out, dist, visited);
+		for (j = i + 1; j < neighbor.size(); j++) {
+			int32_t via_cost = neighbor[i].cost + neighbor[j].cost;
+			if (via_cost < dist[neighbor[j].to]) {
+				shortcut++;
+				if (!simulate) {
+					StationCH::AddEdge(g, neighbor[i].to, neighbor[j].to, via_cost);
+					StationCH::AddEdge(g, neighbor[j].to, neighbor[i].to, via_cost);
+				}
+			}
+		}
+		for (itv = visited.cbegin(); itv != visited.cend(); itv++) {
+			dist[*itv] = INT32_MAX;
+		}
+		visited.clear();
+	}
+	if (!simulate) {
+		up[node] = neighbor;	/* 未縮約の隣接駅 = 上位の駅 */
+		num_shortcut += shortcut;
+	}
+	return shortcut - (int32_t)neighbor.size();
+}
+
+//private
+//	縮約階層を構築する
+//
+//	縮約順は辺の増減 + 縮約済みの隣接駅数 の小さい順(優先度は取り出し時に再計算する)
+//
+void StationCH::build()
+{
+	typedef pair<int32_t, IDENT> QITEM;
+	const RouteGraph& graph = RouteGraph::getInstance();
+	const int32_t num_station = graph.maxStationId() + 1;
+	vector<vector<CHEdge>> g(num_station);
+	vector<bool> contracted(num_station, false);
+	vector<int32_t> deleted_neighbor(num_station, 0);
+	vector<int32_t> dist(num_station, INT32_MAX);
+	vector<IDENT> visited;
+	priority_queue<QITEM, vector<QITEM>, greater<QITEM>> q;
+	IDENT station_id;
+	int32_t order = 0;
+
+	for (station_id = 1; station_id < num_station; station_id++) {
+		vector<StationEdge>::const_iterator ite;
+		for (ite = graph.nextStation(station_id).cbegin(); ite != graph.nextStation(station_id).cend(); ite++) {
+			if (graph.isEnableLine(ite->lineId, useBulletTrain)) {
+				StationCH::AddEdge(g, station_id, ite->stationId, sales_km ? ite->salesKm : ite->calcKm);
+			}
+		}
+	}
+	rank.assign(num_station, 0);
+	up.assign(num_station, vector<CHEdge>());
+	dist_f.assign(num_station, INT32_MAX);
+	dist_b.assign(num_station, INT32_MAX);
+
+	for (station_id = 1; station_id < num_station; station_id++) {
+		q.push(QITEM(contract(g, contracted, station_id, true, dist, visited), station_id));
+	}
+	while (!q.empty()) {
+		IDENT node = q.top().second;
+		int32_t priority;
+		vector<CHEdge>::const_iterator ite;
+
+		q.pop();
+		if (contracted[node]) {
+			continue;
+		}
+		priority = contract(g, contracted, node, true, dist, visited) + deleted_neighbor[node];
+		if (!q.empty() && (q.top().first < priority)) {
+			q.push(QITEM(priority, node));	/* 優先度が下がった. 後回し */
+			continue;
+		}
+		contract(g, contracted, node, false, dist, visited);
+		contracted[node] = true;
+		rank[node] = ++order;
+		for (ite = up[node].cbegin(); ite != up[node].cend(); ite++) {
+			deleted_neighbor[ite->to]++;
+		}
+	}
+}
+
+//private
+//	上位方向のみのダイクストラ
+//
+void StationCH::upwardSearch(IDENT start, vector<int32_t>& dist)
+{
+	typedef pair<int32_t, IDENT> QITEM;
+	priority_queue<QITEM, vector<QITEM>, greater<QITEM>> q;
+
+	dist[start] = 0;
+	touched.push_back(start);
+	q.push(QITEM(0, start));
+
+	while (!q.empty()) {
+		int32_t cost = q.top().first;
+		IDENT node = q.top().second;
+		vector<CHEdge>::const_iterator ite;
+
+		q.pop();
+		if (dist[node] < cost) {
+			continue;
+		}
+		for (ite = up[node].cbegin(); ite != up[node].cend(); ite++) {
+			if ((cost + ite->cost) < dist[ite->to]) {
+				if ((dist_f[ite->to] == INT32_MAX) && (dist_b[ite->to] == INT32_MAX)) {
+					touched.push_back(ite->to);
+				}
+				dist[ite->to] = cost + ite->cost;
+				q.push(QITEM(dist[ite->to], ite->to));
+			}
+		}
+	}
+}
+
+//	駅間の最短距離
+//
+//	@param [in] station_id1 駅1
+//	@param [in] station_id2 駅2
+//	@retval 0 <= 最短距離(計算キロまたは営業キロ)
+//	@retval -1 到達不可・駅ID不正
+//
+int32_t StationCH::distance(int32_t station_id1, int32_t station_id2)
+{
+	vector<IDENT>::const_iterator ite;
+	int32_t best = INT32_MAX;
+
+	if ((station_id1 <= 0) || ((int32_t)rank.size() <= station_id1) ||
+		(station_id2 <= 0) || ((int32_t)rank.size() <= station_id2)) {
+		return -1;
+	}
+	if (station_id1 == station_id2) {
+		return 0;
+	}
+	upwardSearch(station_id1, dist_f);
+	upwardSearch(station_id2, dist_b);
+
+	for (ite = touched.cbegin(); ite != touched.cend(); ite++) {
+		if ((dist_f[*ite] != INT32_MAX) && (dist_b[*ite] != INT32_MAX) &&
+			((dist_f[*ite] + dist_b[*ite]) < best)) {
+			best = dist_f[*ite] + dist_b[*ite];
+		}
+	}
+	for (ite = touched.cbegin(); ite != touched.cend(); ite++) {
+		dist_f[*ite] = INT32_MAX;
+		dist_b[*ite] = INT32_MAX;
+	}
+	touched.clear();
+	return (best == INT32_MAX) ? -1 : best;
+}
@@ -0,0 +1,45 @@
+#ifndef _STATION_CH_H__
+#define _STATION_CH_H__
+
+#include "route_graph.h"
+
+/*!	@file station_ch 駅単位グラフの縮約階層(Contraction Hierarchies)インデックス.
+ *	駅間の最短計算キロ・最短営業キロを求める. 探索条件(useBulletTrain)・距離種別ごとに
+ *	初回の問い合わせ時に構築し、DBを開き直したらClear()で破棄する.
+ */
+
+class StationCH
+{
+	class CHEdge {
+	public:
+		IDENT to;
+		int32_t cost;
+		CHEdge(IDENT to_, int32_t cost_) : to(to_), cost(cost_) {}
+	};
+	bool sales_km;						// true:営業キロ, false:計算キロ
+	uint8_t useBulletTrain;				// changeNeerest()と同じ
+	int32_t num_shortcut;
+	vector<int32_t> rank;				// [stationId] 縮約順
+	vector<vector<CHEdge>> up;			// [stationId] 上位の駅への辺(ショートカット含む)
+
+	/* 問い合わせ用作業領域 */
+	vector<int32_t> dist_f;				// [stationId] 発駅側
+	vector<int32_t> dist_b;				// [stationId] 着駅側
+	vector<IDENT> touched;
+
+	StationCH(bool sales_km_, uint8_t useBulletTrain_);
+	void build();
+	static void AddEdge(vector<vector<CHEdge>>& g, IDENT from, IDENT to, int32_t cost);
+	static int32_t WitnessSearch(const vector<vector<CHEdge>>& g, const vector<bool>& contracted,
+								 IDENT source, IDENT skip, int32_t max_cost, vector<int32_t>& dist, vector<IDENT>& visited);
+	int32_t contract(vector<vector<CHEdge>>& g, const vector<bool>& contracted, IDENT node, bool simulate,
+					 vector<int32_t>& dist, vector<IDENT>& visited);
+	void upwardSearch(IDENT start, vector<int32_t>& dist);
+public:
+	static StationCH& getInstance(bool sales_km, uint8_t useBulletTrain);
+	static void Clear();
+	int32_t distance(int32_t station_id1, int32_t station_id2);
+	int32_t numOfShortcut() const { return num_shortcut; }
+};
+
+#endif	/* _STATION_CH_H__ */
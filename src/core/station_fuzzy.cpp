@@ -0,0 +1,551 @@
+#include "station_fuzzy.h"
+#include "kana_utf8.h"
+
+#include <memory>
+#include <algorithm>
+
+#if defined(__wasm_simd128__)
+#include <wasm_simd128.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+/* 1文字のgram(2文字目なし) */
+#define FUZZY_UNIGRAM(c)		(((uint64_t)(c) << 32) | 0xffffffffu)
+#define FUZZY_BIGRAM(c1, c2)	(((uint64_t)(c1) << 32) | (uint32_t)(c2))
+
+////////////////////////////////////////////
+//	正規化
+
+/* 半角カナ(U+FF66〜U+FF9D) -> 全角カナ */
+static const char32_t halfwidth_kana[] = {
+	0x30F2, 0x30A1, 0x30A3, 0x30A5, 0x30A7, 0x30A9, 0x30E3, 0x30E5,
+	0x30E7, 0x30C3, 0x30FC, 0x30A2, 0x30A4, 0x30A6, 0x30A8, 0x30AA,
+	0x30AB, 0x30AD, 0x30AF, 0x30B1, 0x30B3, 0x30B5, 0x30B7, 0x30B9,
+	0x30BB, 0x30BD, 0x30BF, 0x30C1, 0x30C4, 0x30C6, 0x30C8, 0x30CA,
+	0x30CB, 0x30CC, 0x30CD, 0x30CE, 0x30CF, 0x30D2, 0x30D5, 0x30D8,
+	0x30DB, 0x30DE, 0x30DF, 0x30E0, 0x30E1, 0x30E2, 0x30E4, 0x30E6,
+	0x30E8, 0x30E9, 0x30EA, 0x30EB, 0x30EC, 0x30ED, 0x30EF, 0x30F3,
+};
+
+/* ローマ字 -> かな(ヘボン式・訓令式・日本式) */
+static const struct {
+	const char* romaji;
+	const char32_t* kana;
+} romaji_table[] = {
+	{ "a", U"あ" }, { "i", U"い" }, { "u", U"う" }, { "e", U"え" }, { "o", U"お" },
+	{ "ka", U"か" }, { "ki", U"き" }, { "ku", U"く" }, { "ke", U"け" }, { "ko", U"こ" },
+	{ "kya", U"きゃ" }, { "kyu", U"きゅ" }, { "kyo", U"きょ" },
+	{ "ga", U"が" }, { "gi", U"ぎ" }, { "gu", U"ぐ" }, { "ge", U"げ" }, { "go", U"ご" },
+	{ "gya", U"ぎゃ" }, { "gyu", U"ぎゅ" }, { "gyo", U"ぎょ" },
+	{ "sa", U"さ" }, { "shi", U"し" }, { "si", U"し" }, { "su", U"す" }, { "se", U"せ" }, { "so", U"そ" },
+	{ "sha", U"しゃ" }, { "shu", U"しゅ" }, { "sho", U"しょ" }, { "she", U"しぇ" },
+	{ "sya", U"しゃ" }, { "syu", U"しゅ" }, { "syo", U"しょ" },
+	{ "za", U"ざ" }, { "ji", U"じ" }, { "zi", U"じ" }, { "zu", U"ず" }, { "ze", U"ぜ" }, { "zo", U"ぞ" },
+	{ "ja", U"じゃ" }, { "ju", U"じゅ" }, { "jo", U"じょ" }, { "je", U"じぇ" },
+	{ "jya", U"じゃ" }, { "jyu", U"じゅ" }, { "jyo", U"じょ" },
+	{ "zya", U"じゃ" }, { "zyu", U"じゅ" }, { "zyo", U"じょ" },
+	{ "ta", U"た" }, { "chi", U"ち" }, { "ti", U"ち" }, { "tsu", U"つ" }, { "tu", U"つ" }, { "te", U"て" }, { "to", U"と" },
+	{ "cha", U"ちゃ" }, { "chu", U"ちゅ" }, { "cho", U"ちょ" }, { "che", U"ちぇ" },
+	{ "tya", U"ちゃ" }, { "tyu", U"ちゅ" }, { "tyo", U"ちょ" },
+	{ "cya", U"ちゃ" }, { "cyu", U"ちゅ" }, { "cyo", U"ちょ" },
+	{ "da", U"だ" }, { "di", U"ぢ" }, { "du", U"づ" }, { "de", U"で" }, { "do", U"ど" },
+	{ "dya", U"ぢゃ" }, { "dyu", U"ぢゅ" }, { "dyo", U"ぢょ" },
+	{ "na", U"な" }, { "ni", U"に" }, { "nu", U"ぬ" }, { "ne", U"ね" }, { "no", U"の" },
+	{ "nya", U"にゃ" }, { "nyu", U"にゅ" }, { "nyo", U"にょ" },
+	{ "ha", U"は" }, { "hi", U"ひ" }, { "fu", U"ふ" }, { "hu", U"ふ" }, { "he", U"へ" }, { "ho", U"ほ" },
+	{ "hya", U"ひゃ" }, { "hyu", U"ひゅ" }, { "hyo", U"ひょ" },
+	{ "fa", U"ふぁ" }, { "fi", U"ふぃ" }, { "fe", U"ふぇ" }, { "fo", U"ふぉ" },
+	{ "ba", U"ば" }, { "bi", U"び" }, { "bu", U"ぶ" }, { "be", U"べ" }, { "bo", U"ぼ" },
+	{ "bya", U"びゃ" }, { "byu", U"びゅ" }, { "byo", U"びょ" },
+	{ "pa", U"ぱ" }, { "pi", U"ぴ" }, { "pu", U"ぷ" }, { "pe", U"ぺ" }, { "po", U"ぽ" },
+	{ "pya", U"ぴゃ" }, { "pyu", U"ぴゅ" }, { "pyo", U"ぴょ" },
+	{ "ma", U"ま" }, { "mi", U"み" }, { "mu", U"む" }, { "me", U"め" }, { "mo", U"も" },
+	{ "mya", U"みゃ" }, { "myu", U"みゅ" }, { "myo", U"みょ" },
+	{ "ya", U"や" }, { "yu", U"ゆ" }, { "yo", U"よ" },
+	{ "ra", U"ら" }, { "ri", U"り" }, { "ru", U"る" }, { "re", U"れ" }, { "ro", U"ろ" },
+	{ "rya", U"りゃ" }, { "ryu", U"りゅ" }, { "ryo", U"りょ" },
+	{ "la", U"ら" }, { "li", U"り" }, { "lu", U"る" }, { "le", U"れ" }, { "lo", U"ろ" },
+	{ "wa", U"わ" }, { "wi", U"うぃ" }, { "we", U"うぇ" }, { "wo", U"を" },
+	{ "va", U"ゔぁ" }, { "vi", U"ゔぃ" }, { "vu", U"ゔ" }, { "ve", U"ゔぇ" }, { "vo", U"ゔぉ" },
+	{ "xa", U"ぁ" }, { "xi", U"ぃ" }, { "xu", U"ぅ" }, { "xe", U"ぇ" }, { "xo", U"ぉ" },
+	{ "xya", U"ゃ" }, { "xyu", U"ゅ" }, { "xyo", U"ょ" }, { "xtu", U"っ" }, { "xtsu", U"っ" },
+};
+
+static bool is_vowel(char c)
+{
+	return (c == 'a') || (c == 'i') || (c == 'u') || (c == 'e') || (c == 'o');
+}
+
+/* お段(のばす「う」「お」が続く) */
+static bool is_o_row(char32_t c)
+{
+	static const char32_t o_row[] = U"おこそとのほもよろごぞどぼぽょぉ";
+	return (c != 0) && (std::char_traits<char32_t>::find(o_row, NumOf(o_row) - 1, c) != nullptr);
+}
+
+/* う段(のばす「う」が続く) */
+static bool is_u_row(char32_t c)
+{
+	static const char32_t u_row[] = U"うくすつぬふむゆるぐずぶぷゅぅゔ";
+	return (c != 0) && (std::char_traits<char32_t>::find(u_row, NumOf(u_row) - 1, c) != nullptr);
+}
+
+/* UTF-8 -> コードポイント列 */
+static u32string decode_utf8(const char* str)
+{
+	u32string result;
+	const char* end = str + strlen(str);
+
+	while (str < end) {
+		result.push_back(KanaUtf8::Decode(str, end));
+	}
+	return result;
+}
+
+//static private
+//	ローマ字をかなに
+//	子音の重なりは「っ」、子音の前・末尾の n と nn・n' は「ん」、b/m/p の前の m は「ん」.
+//	かなにならない文字(入力途中の子音など)は捨てる
+//
+//	@param [in]  romaji  ローマ字(英小文字)
+//	@param [out] kana    かな(追加する)
+//
+void StationFuzzyIndex::RomajiToKana(const string& romaji, u32string& kana)
+{
+	size_t i = 0;
+
+	while (i < romaji.size()) {
+		char c = romaji[i];
+		char next = ((i + 1) < romaji.size()) ? romaji[i + 1] : '\0';
+		char next2 = ((i + 2) < romaji.size()) ? romaji[i + 2] : '\0';
+		size_t len;
+
+		if (c == '-') {
+			kana.push_back(U'ー');
+			i++;
+			continue;
+		}
+		if ((c < 'a') || ('z' < c)) {
+			i++;
+			continue;
+		}
+		if (c == 'n') {
+			if ((next == 'n') && !is_vowel(next2) && (next2 != 'y')) {
+				kana.push_back(U'ん');		/* nn */
+				i += 2;
+				continue;
+			}
+			if (next == '\'') {
+				kana.push_back(U'ん');		/* n' */
+				i += 2;
+				continue;
+			}
+			if (!is_vowel(next) && (next != 'y')) {
+				kana.push_back(U'ん');
+				i++;
+				continue;
+			}
+		}
+		if ((c == 'm') && ((next == 'b') || (next == 'm') || (next == 'p'))) {
+			kana.push_back(U'ん');
+			i++;
+			continue;
+		}
+		if (((c == next) && !is_vowel(c)) || ((c == 't') && (next == 'c') && (next2 == 'h'))) {
+			kana.push_back(U'っ');
+			i++;
+			continue;
+		}
+		for (len = 4; 0 < len; len--) {
+			size_t k;
+			for (k = 0; k < NumOf(romaji_table); k++) {
+				if (romaji.compare(i, len, romaji_table[k].romaji) == 0) {
+					break;
+				}
+			}
+			if (k < NumOf(romaji_table)) {
+				kana.append(romaji_table[k].kana);
+				i += len;
+				break;
+			}
+		}
+		if (len == 0) {
+			i++;		/* かなにならない */
+		}
+	}
+}
+
+//static
+//	検索用のキーに正規化する
+//	全角英数は半角に、英大文字は小文字に、半角カナ(濁点・半濁点付き)は全角にし、
+//	(romaji指定時)英数記号のみならローマ字としてかなにしたあと、カナはかなに、
+//	長音・空白・中黒と、お段に続く「う」「お」、う段に続く「う」を除き、ぢ→じ, づ→ず, を→お とする.
+//
+//	@param [in] str    文字列(UTF-8)
+//	@param [in] romaji true: 英数記号のみの文字列をローマ字としてかなにする
+//	@return キー
+//
+u32string StationFuzzyIndex::Normalize(LPCTSTR str, bool romaji)
+{
+	u32string src = decode_utf8(str);
+	u32string wide;
+	u32string result;
+
+	for (u32string::const_iterator ite = src.cbegin(); ite != src.cend(); ite++) {
+		char32_t c = *ite;
+
+		if ((0xff01 <= c) && (c <= 0xff5e)) {
+			c -= 0xfee0;								/* 全角英数 */
+		} else if ((0xff66 <= c) && (c <= 0xff9d)) {
+			c = halfwidth_kana[c - 0xff66];				/* 半角カナ */
+		} else if ((c == 0xff9e) && !wide.empty()) {	/* 半角濁点 */
+			char32_t& prev = wide.back();
+			if (((0x30ab <= prev) && (prev <= 0x30c2) && ((prev & 1) != 0))
+				|| ((0x30c4 <= prev) && (prev <= 0x30c8) && ((prev & 1) == 0))
+				|| ((0x30cf <= prev) && (prev <= 0x30dd) && (((prev - 0x30cf) % 3) == 0))) {
+				prev++;
+			} else if (prev == 0x30a6) {
+				prev = 0x30f4;			/* ヴ */
+			}
+			continue;
+		} else if ((c == 0xff9f) && !wide.empty()) {	/* 半角半濁点 */
+			char32_t& prev = wide.back();
+			if ((0x30cf <= prev) && (prev <= 0x30dd) && (((prev - 0x30cf) % 3) == 0)) {
+				prev += 2;
+			}
+			continue;
+		}
+		if (('A' <= c) && (c <= 'Z')) {
+			c = c - 'A' + 'a';
+		}
+		if (0x80 <= c) {
+			romaji = false;
+		}
+		wide.push_back(c);
+	}
+
+	if (romaji) {
+		/* 英数記号のみ */
+		string ascii(wide.cbegin(), wide.cend());
+		wide.clear();
+		RomajiToKana(ascii, wide);
+	}
+
+	for (u32string::const_iterator ite = wide.cbegin(); ite != wide.cend(); ite++) {
+		char32_t c = *ite;
+
+		if ((0x30a1 <= c) && (c <= 0x30f6)) {
+			c -= 0x60;									/* カナ -> かな */
+		}
+		switch (c) {
+		case U'ー':
+		case U'-':
+		case U' ':
+		case U'　':
+		case U'・':
+		case U'\'':
+			continue;
+		case U'ぢ':
+			c = U'じ';
+			break;
+		case U'づ':
+			c = U'ず';
+			break;
+		case U'を':
+			c = U'お';
+			break;
+		default:
+			break;
+		}
+		if (!result.empty()) {
+			char32_t prev = result.back();
+			if (((c == U'う') || (c == U'お')) && is_o_row(prev)) {
+				continue;
+			}
+			if ((c == U'う') && is_u_row(prev)) {
+				continue;
+			}
+		}
+		result.push_back(c);
+	}
+	return result;
+}
+
+//static private
+//	キーのgram(1文字のみならその文字, 2文字以上ならbigram)を追加する
+//
+void StationFuzzyIndex::AddGrams(const u32string& key, vector<uint64_t>& grams)
+{
+	if (key.size() == 1) {
+		grams.push_back(FUZZY_UNIGRAM(key[0]));
+	}
+	for (size_t i = 1; i < key.size(); i++) {
+		grams.push_back(FUZZY_BIGRAM(key[i - 1], key[i]));
+	}
+}
+
+//static private
+//	キーのgram数(類似度の分母)
+//
+int32_t StationFuzzyIndex::GramCount(const u32string& key)
+{
+	return (key.size() <= 1) ? 1 : (int32_t)(key.size() - 1);
+}
+
+////////////////////////////////////////////
+//	StationFuzzyIndex
+//
+
+static unique_ptr<StationFuzzyIndex> station_fuzzy_index;
+
+StationFuzzyIndex::StationFuzzyIndex()
+{
+}
+
+//static
+//	インデックスを得る(初回のみ構築)
+//
+StationFuzzyIndex& StationFuzzyIndex::GetInstance()
+{
+	if (!station_fuzzy_index) {
+		station_fuzzy_index.reset(new StationFuzzyIndex());
+		station_fuzzy_index->build();
+	}
+	return *station_fuzzy_index;
+}
+
+//static
+//	インデックスを破棄(DBを開き直した時)
+//
+void StationFuzzyIndex::Clear()
+{
+	station_fuzzy_index.reset();
+}
+
+//private
+//	t_station を読み込み、駅ごとに よみ・駅名 の1文字(全文字)とbigramを転置リストに加える
+//
+void StationFuzzyIndex::build()
+{
+	DBO dbo = DBS::getInstance()->compileSql(
+				"select rowid, name, kana from t_station order by kana, rowid", false);
+	vector<uint64_t> grams;
+
+	while (dbo.moveNext()) {
+		int32_t index = (int32_t)entries.size();
+
+		entries.push_back(Entry(dbo.getInt(0), Normalize(dbo.getText(2).c_str(), false),
+								Normalize(dbo.getText(1).c_str(), false)));
+		grams.clear();
+		for (const u32string* key : { &entries.back().kanaKey, &entries.back().nameKey }) {
+			for (size_t i = 0; i < key->size(); i++) {
+				grams.push_back(FUZZY_UNIGRAM((*key)[i]));
+				if (0 < i) {
+					grams.push_back(FUZZY_BIGRAM((*key)[i - 1], (*key)[i]));
+				}
+			}
+		}
+		for (vector<uint64_t>::const_iterator ite = grams.cbegin(); ite != grams.cend(); ite++) {
+			vector<int32_t>& posting = postings[*ite];
+			if (posting.empty() || (posting.back() != index)) {
+				posting.push_back(index);
+			}
+		}
+	}
+}
+
+//static
+//	昇順の配列同士の積(共通要素)
+//	4要素ずつの組を総当たりで比較する(wasm SIMD128, SSE2). 残りは1要素ずつ
+//
+//	@param [in]  a      昇順(重複なし)
+//	@param [in]  b      昇順(重複なし)
+//	@param [out] result 共通要素(昇順)
+//
+void StationFuzzyIndex::Intersect(const vector<int32_t>& a, const vector<int32_t>& b, vector<int32_t>& result)
+{
+	size_t i = 0;
+	size_t j = 0;
+
+	result.clear();
+#if defined(__wasm_simd128__) || defined(__SSE2__)
+	while (((i + 4) <= a.size()) && ((j + 4) <= b.size())) {
+		int32_t mask;
+#if defined(__wasm_simd128__)
+		v128_t va = wasm_v128_load(&a[i]);
+		v128_t vb = wasm_v128_load(&b[j]);
+		v128_t eq = wasm_i32x4_eq(va, vb);
+
+		eq = wasm_v128_or(eq, wasm_i32x4_eq(va, wasm_i32x4_shuffle(vb, vb, 1, 2, 3, 0)));
+		eq = wasm_v128_or(eq, wasm_i32x4_eq(va, wasm_i32x4_shuffle(vb, vb, 2, 3, 0, 1)));
+		eq = wasm_v128_or(eq, wasm_i32x4_eq(va, wasm_i32x4_shuffle(vb, vb, 3, 0, 1, 2)));
+		mask = wasm_i32x4_bitmask(eq);
+#else
+		__m128i va = _mm_loadu_si128((const __m128i*)&a[i]);
+		__m128i vb = _mm_loadu_si128((const __m128i*)&b[j]);
+		__m128i eq = _mm_cmpeq_epi32(va, vb);
+
+		eq = _mm_or_si128(eq, _mm_cmpeq_epi32(va, _mm_shuffle_epi32(vb, _MM_SHUFFLE(0, 3, 2, 1))));
+		eq = _mm_or_si128(eq, _mm_cmpeq_epi32(va, _mm_shuffle_epi32(vb, _MM_SHUFFLE(1, 0, 3, 2))));
+		eq = _mm_or_si128(eq, _mm_cmpeq_epi32(va, _mm_shuffle_epi32(vb, _MM_SHUFFLE(2, 1, 0, 3))));
+		mask = _mm_movemask_ps(_mm_castsi128_ps(eq));
+#endif
+		for (int32_t k = 0; k < 4; k++) {
+			if ((mask & (1 << k)) != 0) {
+				result.push_back(a[i + k]);
+			}
+		}
+		int32_t a_max = a[i + 3];
+		int32_t b_max = b[j + 3];
+		if (a_max <= b_max) {
+			i += 4;
+		}
+		if (b_max <= a_max) {
+			j += 4;
+		}
+	}
+#endif
+	while ((i < a.size()) && (j < b.size())) {
+		if (a[i] < b[j]) {
+			i++;
+		} else if (b[j] < a[i]) {
+			j++;
+		} else {
+			result.push_back(a[i]);
+			i++;
+			j++;
+		}
+	}
+}
+
+//	駅のあいまい検索
+//	英数記号のみの検索語はローマ字として、それ以外はかな・漢字として正規化し、
+//	1. 検索語が駅のよみ(漢字を含む検索語は駅名)の先頭に一致
+//	2. 検索語の全bigramを含む
+//	3. 検索語のbigramの半数以上を含む(打ち間違い)
+//	の順、同じ順位内はDice係数の大きい順(同じならかな順)に返す.
+//	1, 2だけでlimit件に達すれば 3 の数え上げは行わない.
+//
+//	@param [in] key    検索語
+//	@param [in] limit  最大件数(0以下は全件)
+//	@return 駅idの並び
+//
+vector<int32_t> StationFuzzyIndex::match(LPCTSTR key, int32_t limit) const
+{
+	// 候補駅
+	class Candidate {
+	public:
+		int32_t index;		// entriesの添字
+		int32_t rank;		// 0:前方一致, 1:全bigram一致, 2:一部一致
+		int32_t common;		// 一致したgram数
+		int32_t grams;		// 駅のキーのgram数
+		Candidate(int32_t index_, int32_t rank_, int32_t common_, int32_t grams_) :
+			index(index_), rank(rank_), common(common_), grams(grams_) {}
+	};
+	vector<int32_t> results;
+	vector<Candidate> candidates;
+	vector<uint64_t> grams;
+	bool kana = true;
+
+	u32string query = Normalize(key, true);
+	if (query.empty()) {
+		query = Normalize(key, false);		/* かなにならない英字("JR"など) */
+	}
+	if (query.empty()) {
+		return results;
+	}
+	for (u32string::const_iterator ite = query.cbegin(); ite != query.cend(); ite++) {
+		if ((*ite < 0x3041) || (0x3096 < *ite)) {
+			kana = false;		/* 漢字を含む: 駅名で比べる */
+			break;
+		}
+	}
+	AddGrams(query, grams);
+	sort(grams.begin(), grams.end());
+	grams.erase(unique(grams.begin(), grams.end()), grams.end());
+
+	int32_t query_grams = (int32_t)grams.size();
+	vector<const vector<int32_t>*> lists;
+	for (vector<uint64_t>::const_iterator ite = grams.cbegin(); ite != grams.cend(); ite++) {
+		unordered_map<uint64_t, vector<int32_t>>::const_iterator itp = postings.find(*ite);
+		if (itp != postings.end()) {
+			lists.push_back(&itp->second);
+		}
+	}
+	if (lists.empty()) {
+		return results;
+	}
+	if (limit <= 0) {
+		limit = INT32_MAX;
+	}
+
+	auto addCandidate = [this, &query, &candidates, kana](int32_t index, int32_t common, bool all) {
+		const u32string& target = kana ? entries[index].kanaKey : entries[index].nameKey;
+		int32_t rank = 2;
+		if (all) {
+			rank = (target.compare(0, query.size(), query) == 0) ? 0 : 1;
+		}
+		candidates.push_back(Candidate(index, rank, common, GramCount(target)));
+	};
+
+	/* 全bigramを含む駅: 短い転置リストから順に積をとる */
+	if ((int32_t)lists.size() == query_grams) {
+		vector<const vector<int32_t>*> sorted_lists(lists);
+		vector<int32_t> all;
+		vector<int32_t> work;
+
+		sort(sorted_lists.begin(), sorted_lists.end(),
+			 [](const vector<int32_t>* a, const vector<int32_t>* b) { return a->size() < b->size(); });
+		all = *sorted_lists[0];
+		for (size_t i = 1; (i < sorted_lists.size()) && !all.empty(); i++) {
+			Intersect(all, *sorted_lists[i], work);
+			all.swap(work);
+		}
+		for (vector<int32_t>::const_iterator ite = all.cbegin(); ite != all.cend(); ite++) {
+			addCandidate(*ite, query_grams, true);
+		}
+	}
+
+	/* 足りなければ半数以上のgramを含む駅を数える */
+	if ((int32_t)candidates.size() < limit) {
+		vector<int32_t> counts(entries.size(), 0);
+		vector<int32_t> touched;
+
+		for (vector<const vector<int32_t>*>::const_iterator itl = lists.cbegin(); itl != lists.cend(); itl++) {
+			for (vector<int32_t>::const_iterator ite = (*itl)->cbegin(); ite != (*itl)->cend(); ite++) {
+				if (counts[*ite]++ == 0) {
+					touched.push_back(*ite);
+				}
+			}
+		}
+		for (vector<int32_t>::const_iterator ite = touched.cbegin(); ite != touched.cend(); ite++) {
+			if ((counts[*ite] < query_grams) && (query_grams <= (counts[*ite] * 2))) {
+				addCandidate(*ite, counts[*ite], false);
+			}
+		}
+	}
+
+	/* 順位, Dice係数(2 * common / (query_grams + grams))の大きい順, かな順 */
+	auto better = [query_grams](const Candidate& a, const Candidate& b) {
+		if (a.rank != b.rank) {
+			return a.rank < b.rank;
+		}
+		int64_t da = (int64_t)a.common * (query_grams + b.grams);
+		int64_t db = (int64_t)b.common * (query_grams + a.grams);
+		if (da != db) {
+			return db < da;
+		}
+		return a.index < b.index;
+	};
+	if (limit < (int32_t)candidates.size()) {
+		partial_sort(candidates.begin(), candidates.begin() + limit, candidates.end(), better);
+		candidates.erase(candidates.begin() + limit, candidates.end());
+	} else {
+		sort(candidates.begin(), candidates.end(), better);
+	}
+	for (vector<Candidate>::const_iterator ite = candidates.cbegin(); ite != candidates.cend(); ite++) {
+		results.push_back(entries[ite->index].stationId);
+	}
+	return results;
+}
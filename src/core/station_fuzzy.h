@@ -0,0 +1,46 @@
+#ifndef _STATION_FUZZY_H__
+#define _STATION_FUZZY_H__
+
+#include "alpdb.h"
+
+#include <string>
+#include <unordered_map>
+
+/*!	@file station_fuzzy 駅のあいまい検索(ローマ字・半角カナ・打ち間違い)用のn-gramインデックス.
+ *	駅のよみ・駅名を正規化(カナ→かな, 長音・のばす「う」「お」を除く, ぢ→じ など)したキーの
+ *	1文字・2文字(bigram)の転置インデックス(駅の添字の昇順配列)をメモリに持つ.
+ *	検索語はローマ字(ヘボン式・訓令式)、半角カナ、全角英字も同じキーに正規化し、
+ *	全bigramを含む駅(転置リストの積. SIMDで求める)、足りなければ半数以上を含む駅を
+ *	前方一致 > 全bigram一致 > 一部一致、同じ順位内は類似度(Dice係数)順に上位K件返す.
+ *	初回参照時にt_stationを1回読んで構築し、DBを開き直したらClear()で破棄する.
+ */
+
+class StationFuzzyIndex
+{
+	// 駅(t_station 1レコード)
+	class Entry {
+	public:
+		int32_t stationId;
+		u32string kanaKey;		// 正規化したよみ
+		u32string nameKey;		// 正規化した駅名
+		Entry(int32_t stationId_, const u32string& kanaKey_, const u32string& nameKey_) :
+			stationId(stationId_), kanaKey(kanaKey_), nameKey(nameKey_) {}
+	};
+	vector<Entry> entries;								// かな昇順(同じかなはrowid順)
+	unordered_map<uint64_t, vector<int32_t>> postings;	// [gram] entriesの添字(昇順)
+
+	StationFuzzyIndex();
+	void build();
+	static void AddGrams(const u32string& key, vector<uint64_t>& grams);
+	static int32_t GramCount(const u32string& key);
+	static void RomajiToKana(const string& romaji, u32string& kana);
+public:
+	static StationFuzzyIndex& GetInstance();
+	static void Clear();
+
+	static u32string Normalize(LPCTSTR str, bool romaji);
+	static void Intersect(const vector<int32_t>& a, const vector<int32_t>& b, vector<int32_t>& result);
+	vector<int32_t> match(LPCTSTR key, int32_t limit) const;
+};
+
+#endif	/* _STATION_FUZZY_H__ */
@@ -0,0 +1,135 @@
+#include "station_search.h"
+#include "kana_utf8.h"
+
+#include <memory>
+#include <algorithm>
+
+////////////////////////////////////////////
+//	StationSearchIndex
+//
+
+static unique_ptr<StationSearchIndex> station_search_index;
+
+StationSearchIndex::StationSearchIndex()
+{
+}
+
+//static
+//	インデックスを得る(初回のみ構築)
+//
+StationSearchIndex& StationSearchIndex::GetInstance()
+{
+	if (!station_search_index) {
+		station_search_index.reset(new StationSearchIndex());
+		station_search_index->build();
+	}
+	return *station_search_index;
+}
+
+//static
+//	インデックスを破棄(DBを開き直した時)
+//
+void StationSearchIndex::Clear()
+{
+	station_search_index.reset();
+}
+
+//static private
+//	ASCII英字を小文字に(LIKEは英字の大小を区別しないため)
+//
+tstring StationSearchIndex::FoldCase(const tstring& str)
+{
+	tstring result(str);
+
+	for (tstring::iterator ite = result.begin(); ite != result.end(); ite++) {
+		if ((_T('A') <= *ite) && (*ite <= _T('Z'))) {
+			*ite = *ite - _T('A') + _T('a');
+		}
+	}
+	return result;
+}
+
+//private
+//	t_station を読み込む
+//
+void StationSearchIndex::build()
+{
+	DBO dbo = DBS::getInstance()->compileSql(
+				"select rowid, name, kana, samename from t_station order by kana, rowid", false);
+	while (dbo.moveNext()) {
+		entries.push_back(Entry(FoldCase(dbo.getText(1)), dbo.getText(2), dbo.getText(3), dbo.getInt(0)));
+	}
+	name_order.resize(entries.size());
+	for (int32_t i = 0; i < (int32_t)entries.size(); i++) {
+		name_order[i] = i;
+	}
+	stable_sort(name_order.begin(), name_order.end(),
+				[this](int32_t a, int32_t b) { return entries[a].name < entries[b].name; });
+}
+
+//	駅名のパターンマッチ(前方一致)の列挙(ひらがな、カタカナ、ひらがなカタカナ混じり、漢字）
+//	RouteUtil::Enum_station_match()と同じ駅を同じ順(かな昇順)で返す / 会社線駅も含む
+//	"駅名(函)"のように同名駅区別を付けた場合は駅名の前方一致かつ同名駅区別の一致
+//
+//	@param [in] station   えきめい
+//	@param [in] limit     最大件数(0以下は全件)
+//	@return 駅idの並び
+//
+vector<int32_t> StationSearchIndex::match(LPCTSTR station, int32_t limit) const
+{
+	vector<int32_t> results;
+	tstring sameName;
+	tstring stationName(station);
+	bool bSameName = false;
+
+	if (MAX_STATION_CHR < stationName.length()) {
+		stationName = stationName.erase(MAX_STATION_CHR);
+	}
+	if (limit <= 0) {
+		limit = INT32_MAX;
+	}
+	if (stationName.find_first_of(_T("%_")) != tstring::npos) {
+		/* LIKEのワイルドカードを含む(駅名にはない)ものは従来通りDBに問い合わせる */
+		DBO dbo = RouteUtil::Enum_station_match(station);
+		while (dbo.moveNext() && ((int32_t)results.size() < limit)) {
+			results.push_back(dbo.getInt(1));
+		}
+		return results;
+	}
+
+	int32_t pos = (int32_t)stationName.find('(');
+	if (0 <= pos) {
+		sameName = stationName.substr(pos);
+		stationName = stationName.substr(0, pos);
+		bSameName = true;
+	} else if (KanaUtf8::IsKana(stationName)) {
+		/* かなは entries の並びそのものがかな順 */
+		KanaUtf8::ToHiragana(stationName);
+		vector<Entry>::const_iterator ite;
+		ite = lower_bound(entries.cbegin(), entries.cend(), stationName,
+						  [](const Entry& entry, const tstring& key) { return entry.kana < key; });
+		for (; (ite != entries.cend()) && ((int32_t)results.size() < limit)
+			   && (ite->kana.compare(0, stationName.length(), stationName) == 0); ite++) {
+			results.push_back(ite->stationId);
+		}
+		return results;
+	}
+
+	/* 漢字(駅名) */
+	vector<int32_t> matches;
+	vector<int32_t>::const_iterator ite;
+	tstring key(FoldCase(stationName));
+
+	ite = lower_bound(name_order.cbegin(), name_order.cend(), key,
+					  [this](int32_t index, const tstring& prefix) { return entries[index].name < prefix; });
+	for (; (ite != name_order.cend()) && (entries[*ite].name.compare(0, key.length(), key) == 0); ite++) {
+		if (!bSameName || (entries[*ite].samename == sameName)) {
+			matches.push_back(*ite);
+		}
+	}
+	sort(matches.begin(), matches.end());		/* かな順に */
+	for (ite = matches.cbegin(); (ite != matches.cend()) && ((int32_t)results.size() < limit); ite++) {
+		results.push_back(entries[*ite].stationId);
+	}
+	return results;
+}
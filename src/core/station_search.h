@@ -0,0 +1,37 @@
+#ifndef _STATION_SEARCH_H__
+#define _STATION_SEARCH_H__
+
+#include "alpdb.h"
+
+/*!	@file station_search 駅名前方一致検索(RouteUtil::Enum_station_match相当)用のインデックス.
+ *	t_stationの駅名・かな・同名駅区別をかな順(同順はrowid順)に並べてメモリに持ち、
+ *	駅名順の添字配列とあわせてSQLなしで二分探索で引く.
+ *	初回参照時にt_stationを1回読んで構築し、DBを開き直したらClear()で破棄する.
+ */
+
+class StationSearchIndex
+{
+	// 駅(t_station 1レコード)
+	class Entry {
+	public:
+		tstring name;			// 駅名(ASCIIは小文字化. LIKEと同じく英字の大小は区別しない)
+		tstring kana;			// よみ(同上)
+		tstring samename;		// 同名駅区別 "(函)" など
+		int32_t stationId;
+		Entry(const tstring& name_, const tstring& kana_, const tstring& samename_, int32_t stationId_) :
+			name(name_), kana(kana_), samename(samename_), stationId(stationId_) {}
+	};
+	vector<Entry> entries;				// かな昇順(同じかなはrowid順)
+	vector<int32_t> name_order;			// entriesの添字 駅名昇順
+
+	StationSearchIndex();
+	void build();
+	static tstring FoldCase(const tstring& str);
+public:
+	static StationSearchIndex& GetInstance();
+	static void Clear();
+
+	vector<int32_t> match(LPCTSTR station, int32_t limit) const;
+};
+
+#endif	/* _STATION_SEARCH_H__ */
@@ -106,7 +106,7 @@ void DBS::cache_restrict(const char* sql)
 		map<string, STMT_CACHE*>::iterator itr = cache_pool.begin();
 		while (itr != cache_pool.end()) {
 			STMT_CACHE* cache = (STMT_CACHE*)itr->second;
-			if (history < (current - cache->tmstamp)) {
+			if ((key == "") || (history < (current - cache->tmstamp))) {	/* 同一msec内でも必ず1つ選ぶ */
 				history = (current - cache->tmstamp);
 				key = itr->first;	// remove candidate
 			}// else {
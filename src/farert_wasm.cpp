@@ -1,12 +1,23 @@
 #include <emscripten.h>
 #include <emscripten/bind.h>
+#include <emscripten/val.h>
 #include "include/route_interface.h"
 #include "include/common.h"
 #include "core/alpdb.h"
+#include "core/json_writer.h"
+#include "core/route_session.h"
+#include "include/fare_result.h"
 
-// Global route instance for simple API
-static RouteWrapper* g_route = nullptr;
-static CalcRouteWrapper* g_calcRoute = nullptr;
+// Route session of the simple API (createRoute() ... destroyRoute())
+static int32_t g_handle = 0;
+
+static RouteWrapper* currentRoute() {
+    return RouteSessionPool::GetInstance().RouteOf(g_handle);
+}
+
+static CalcRouteWrapper* currentCalc() {
+    return RouteSessionPool::GetInstance().CalcOf(g_handle);
+}
 
 extern "C" {
 
@@ -25,79 +36,227 @@ void farert_close_database() {
 // Route management functions
 EMSCRIPTEN_KEEPALIVE
 int farert_create_route() {
-    if (g_route) {
-        delete g_route;
-    }
-    g_route = new RouteWrapper();
-    return g_route ? 1 : 0;
+    RouteSessionPool::GetInstance().Destroy(g_handle);
+    g_handle = RouteSessionPool::GetInstance().Create();
+    return (0 < g_handle) ? 1 : 0;
 }
 
 EMSCRIPTEN_KEEPALIVE
 void farert_destroy_route() {
-    if (g_route) {
-        delete g_route;
-        g_route = nullptr;
-    }
-    if (g_calcRoute) {
-        delete g_calcRoute;
-        g_calcRoute = nullptr;
-    }
+    RouteSessionPool::GetInstance().Destroy(g_handle);
+    g_handle = 0;
 }
 
 EMSCRIPTEN_KEEPALIVE
 int farert_add_station(int stationId) {
-    if (!g_route) return -1;
-    return g_route->addRoute(stationId);
+    RouteWrapper* route = currentRoute();
+    if (!route) return -1;
+    return route->addRoute(stationId);
 }
 
 EMSCRIPTEN_KEEPALIVE
 int farert_add_route(int lineId, int stationId) {
-    if (!g_route) return -1;
-    return g_route->addRoute(lineId, stationId);
+    RouteWrapper* route = currentRoute();
+    if (!route) return -1;
+    return route->addRoute(lineId, stationId);
 }
 
 EMSCRIPTEN_KEEPALIVE
 void farert_remove_tail() {
-    if (g_route) {
-        g_route->removeTail();
+    RouteWrapper* route = currentRoute();
+    if (route) {
+        route->removeTail();
     }
 }
 
 EMSCRIPTEN_KEEPALIVE
 void farert_remove_all() {
-    if (g_route) {
-        g_route->removeAll();
+    RouteWrapper* route = currentRoute();
+    if (route) {
+        route->removeAll();
     }
 }
 
 EMSCRIPTEN_KEEPALIVE
 int farert_reverse_route() {
-    if (!g_route) return -1;
-    return g_route->reverseRoute();
+    RouteWrapper* route = currentRoute();
+    if (!route) return -1;
+    return route->reverseRoute();
 }
 
 EMSCRIPTEN_KEEPALIVE
 int farert_get_route_count() {
-    if (!g_route) return 0;
-    return g_route->getRouteCount();
+    RouteWrapper* route = currentRoute();
+    if (!route) return 0;
+    return route->getRouteCount();
 }
 
 EMSCRIPTEN_KEEPALIVE
 int farert_start_station_id() {
-    if (!g_route) return 0;
-    return g_route->startStationId();
+    RouteWrapper* route = currentRoute();
+    if (!route) return 0;
+    return route->startStationId();
 }
 
 EMSCRIPTEN_KEEPALIVE
 int farert_last_station_id() {
-    if (!g_route) return 0;
-    return g_route->lastStationId();
+    RouteWrapper* route = currentRoute();
+    if (!route) return 0;
+    return route->lastStationId();
 }
 
 EMSCRIPTEN_KEEPALIVE
 int farert_is_end() {
-    if (!g_route) return 0;
-    return g_route->isEnd() ? 1 : 0;
+    RouteWrapper* route = currentRoute();
+    if (!route) return 0;
+    return route->isEnd() ? 1 : 0;
+}
+
+// ===== 経路セッション(ハンドル)API =====
+// routeCreate() のハンドルで複数の経路を同時に扱う(上のcreateRoute()系は1つの経路のみ)
+// 破棄したハンドルは無効(経路系は -1/0, 運賃系は ""/"{}"/0 を返す). セッションは使い回す(route_session.h)
+
+// 経路セッションを作る(ハンドル: 1以上, -1: 作れない)
+int route_create() {
+    return RouteSessionPool::GetInstance().Create();
+}
+
+// 経路セッションを破棄(1:破棄した, 0:無効なハンドル)
+int route_destroy(int handle) {
+    return RouteSessionPool::GetInstance().Destroy(handle) ? 1 : 0;
+}
+
+int route_add_station(int handle, int stationId) {
+    RouteWrapper* route = RouteSessionPool::GetInstance().RouteOf(handle);
+    if (!route) return -1;
+    return route->addRoute(stationId);
+}
+
+int route_add_route(int handle, int lineId, int stationId) {
+    RouteWrapper* route = RouteSessionPool::GetInstance().RouteOf(handle);
+    if (!route) return -1;
+    return route->addRoute(lineId, stationId);
+}
+
+void route_remove_tail(int handle) {
+    RouteWrapper* route = RouteSessionPool::GetInstance().RouteOf(handle);
+    if (route) {
+        route->removeTail();
+    }
+}
+
+void route_remove_all(int handle) {
+    RouteWrapper* route = RouteSessionPool::GetInstance().RouteOf(handle);
+    if (route) {
+        route->removeAll();
+    }
+}
+
+int route_reverse(int handle) {
+    RouteWrapper* route = RouteSessionPool::GetInstance().RouteOf(handle);
+    if (!route) return -1;
+    return route->reverseRoute();
+}
+
+int route_get_count(int handle) {
+    RouteWrapper* route = RouteSessionPool::GetInstance().RouteOf(handle);
+    if (!route) return 0;
+    return route->getRouteCount();
+}
+
+int route_start_station_id(int handle) {
+    RouteWrapper* route = RouteSessionPool::GetInstance().RouteOf(handle);
+    if (!route) return 0;
+    return route->startStationId();
+}
+
+int route_last_station_id(int handle) {
+    RouteWrapper* route = RouteSessionPool::GetInstance().RouteOf(handle);
+    if (!route) return 0;
+    return route->lastStationId();
+}
+
+int route_is_end(int handle) {
+    RouteWrapper* route = RouteSessionPool::GetInstance().RouteOf(handle);
+    if (!route) return 0;
+    return route->isEnd() ? 1 : 0;
+}
+
+// 最短経路で着駅まで延長(useBulletTrain は autoRoute() と同じ)
+int route_auto_route(int handle, int useBulletTrain, int arriveStationId) {
+    RouteWrapper* route = RouteSessionPool::GetInstance().RouteOf(handle);
+    if (!route) return -1;
+    return route->autoRoute(useBulletTrain, arriveStationId);
+}
+
+// 経路スクリプト("東京,東海道線,名古屋")で経路を置き換える
+int route_setup(int handle, const std::string& routeScript) {
+    RouteWrapper* route = RouteSessionPool::GetInstance().RouteOf(handle);
+    if (!route) return -1;
+    return route->setupRoute(routeScript);
+}
+
+// 運賃計算(1:成功, 0:失敗). 結果は次の計算か破棄まで route_get_fare_xxx() で使い回す
+int route_calculate_fare(int handle) {
+    CalcRouteWrapper* calc = RouteSessionPool::GetInstance().Calculate(handle);
+    if (!calc) return 0;
+    
+    if (0 <= calc->fareResult()) {
+        return 1; // Calculation succeeded
+    }
+    return 0; // Calculation failed
+}
+
+std::string route_get_fare_string(int handle) {
+    CalcRouteWrapper* calc = RouteSessionPool::GetInstance().CalcOf(handle);
+    if (!calc) return "";
+    return calc->showFare();
+}
+
+std::string route_get_fare_info_json(int handle, int outputMask) {
+    CalcRouteWrapper* calc = RouteSessionPool::GetInstance().CalcOf(handle);
+    if (!calc) return "{}";
+    return calc->calcFare(outputMask);
+}
+
+// getFareResultPointer() のハンドル版(0:未計算か無効なハンドル)
+int route_get_fare_result_pointer(int handle, int outputMask) {
+    CalcRouteWrapper* calc = RouteSessionPool::GetInstance().CalcOf(handle);
+    if (!calc) return 0;
+    return (int)reinterpret_cast<uintptr_t>(calc->calcFareBinary(outputMask));
+}
+
+void route_set_long_route(int handle, int flag) {
+    CalcRouteWrapper* calc = RouteSessionPool::GetInstance().CalcOf(handle);
+    if (calc) {
+        calc->setLongRoute(flag != 0);
+    }
+}
+
+void route_set_start_as_city(int handle) {
+    CalcRouteWrapper* calc = RouteSessionPool::GetInstance().CalcOf(handle);
+    if (calc) {
+        calc->setStartAsCity();
+    }
+}
+
+void route_set_arrive_as_city(int handle) {
+    CalcRouteWrapper* calc = RouteSessionPool::GetInstance().CalcOf(handle);
+    if (calc) {
+        calc->setArriveAsCity();
+    }
+}
+
+// 経路セッションの数 {active:使用中, slots:確保済み}
+std::string getRouteSessionStatsAsJson() {
+    RouteSessionPool& pool = RouteSessionPool::GetInstance();
+    JsonWriter& json = JsonWriter::Reuse();
+    
+    json.beginObject();
+    json.member("active", pool.activeCount());
+    json.member("slots", pool.slotCount());
+    json.endObject();
+    return json.str();
 }
 
 // Station/Line utility functions
@@ -121,20 +280,72 @@ std::string getLineNameFromId(int id) {
 }
 
 std::string getFareStringResult() {
-    if (g_calcRoute) {
-        return g_calcRoute->showFare();
+    CalcRouteWrapper* calc = currentCalc();
+    if (calc) {
+        return calc->showFare();
     }
     return "";
 }
 
 // Get detailed FareInfo as JSON
 std::string getFareInfoJson() {
-    if (g_calcRoute) {
-        return g_calcRoute->calcFare();
+    CalcRouteWrapper* calc = currentCalc();
+    if (calc) {
+        return calc->calcFare();
     }
     return "{}";
 }
 
+// 要求した項目のみのFareInfo(outputMask: FARE_OUT_xxx の論理和)
+std::string getFareInfoJsonWithMask(int outputMask) {
+    CalcRouteWrapper* calc = currentCalc();
+    if (calc) {
+        return calc->calcFare(outputMask);
+    }
+    return "{}";
+}
+
+// 要求した項目のFareInfoをバイナリ(fare_result.h)で計算し、wasmメモリ上の位置(バイト)を返す(0:経路なし)
+// JSは src/js/fare_result.js の getFareResult() で HEAP32 を直接読む
+// 次の呼び出しか経路の変更・破棄まで有効
+int getFareResultPointer(int outputMask) {
+    CalcRouteWrapper* calc = currentCalc();
+    if (calc) {
+        return (int)reinterpret_cast<uintptr_t>(calc->calcFareBinary(outputMask));
+    }
+    return 0;
+}
+
+// バイナリの配置 {version, headerWords, flagsWord, stringsWord, ints:{名前:語位置}, flags:{名前:bit}, strings:{名前:番号}}
+// (fare_result.h の項目リストから作る)
+std::string getFareResultLayout() {
+    JsonWriter& json = JsonWriter::Reuse();
+    json.beginObject();
+    json.member("version", FARE_RESULT_VERSION);
+    json.member("headerWords", FARE_RESULT_HEADER_WORDS);
+    json.member("sizeWord", (int32_t)FARE_RESULT_W_SIZE);
+    json.member("maskWord", (int32_t)FARE_RESULT_W_MASK);
+    json.member("flagsWord", (int32_t)FARE_RESULT_W_FLAGS);
+    json.member("stringsWord", (int32_t)FARE_RESULT_W_STRINGS);
+    json.key("ints").beginObject();
+#define FARE_RESULT_X(name) json.member(#name, (int32_t)FARE_RESULT_W_##name);
+    FARE_RESULT_INT_FIELDS(FARE_RESULT_X)
+#undef FARE_RESULT_X
+    json.endObject();
+    json.key("flags").beginObject();
+#define FARE_RESULT_X(name) json.member(#name, (int32_t)FARE_RESULT_F_##name);
+    FARE_RESULT_FLAG_FIELDS(FARE_RESULT_X)
+#undef FARE_RESULT_X
+    json.endObject();
+    json.key("strings").beginObject();
+#define FARE_RESULT_X(name) json.member(#name, (int32_t)FARE_RESULT_S_##name);
+    FARE_RESULT_STRING_FIELDS(FARE_RESULT_X)
+#undef FARE_RESULT_X
+    json.endObject();
+    json.endObject();
+    return json.str();
+}
+
 std::string debugStationsResult() {
     std::string result = "";
     
@@ -176,27 +387,15 @@ const char* farert_get_line_name(int id) {
 // Fare calculation functions
 EMSCRIPTEN_KEEPALIVE
 int farert_calculate_fare() {
-    if (!g_route) return 0;
-    
-    if (g_calcRoute) {
-        delete g_calcRoute;
-    }
-    
-    g_calcRoute = new CalcRouteWrapper(*g_route);
-    if (!g_calcRoute) return 0;
-    
-    std::string fareJson = g_calcRoute->calcFare();
-    if (!fareJson.empty() && fareJson != "{}") {
-        return 1; // Calculation succeeded
-    }
-    return 0; // Calculation failed
+    return route_calculate_fare(g_handle);
 }
 
 EMSCRIPTEN_KEEPALIVE
 const char* farert_get_fare_string() {
     static std::string result;
-    if (g_calcRoute) {
-        result = g_calcRoute->showFare();
+    CalcRouteWrapper* calc = currentCalc();
+    if (calc) {
+        result = calc->showFare();
     } else {
         result = "";
     }
@@ -205,22 +404,25 @@ const char* farert_get_fare_string() {
 
 EMSCRIPTEN_KEEPALIVE
 void farert_set_long_route(int flag) {
-    if (g_calcRoute) {
-        g_calcRoute->setLongRoute(flag != 0);
+    CalcRouteWrapper* calc = currentCalc();
+    if (calc) {
+        calc->setLongRoute(flag != 0);
     }
 }
 
 EMSCRIPTEN_KEEPALIVE
 void farert_set_start_as_city() {
-    if (g_calcRoute) {
-        g_calcRoute->setStartAsCity();
+    CalcRouteWrapper* calc = currentCalc();
+    if (calc) {
+        calc->setStartAsCity();
     }
 }
 
 EMSCRIPTEN_KEEPALIVE
 void farert_set_arrive_as_city() {
-    if (g_calcRoute) {
-        g_calcRoute->setArriveAsCity();
+    CalcRouteWrapper* calc = currentCalc();
+    if (calc) {
+        calc->setArriveAsCity();
     }
 }
 
@@ -262,61 +464,123 @@ int farert_test() {
 // 駅から路線IDリストを取得（JSON文字列として返す）
 std::string getLineIdsFromStationAsJson(int stationId) {
     std::vector<int> lineIds = RouteUtility::getLineIdsFromStation(stationId);
-    std::string json = "[";
-    for (size_t i = 0; i < lineIds.size(); i++) {
-        json += std::to_string(lineIds[i]);
-        if (i < lineIds.size() - 1) json += ",";
-    }
-    json += "]";
-    return json;
+    return JsonWriter::Reuse().values(lineIds).str();
 }
 
 // 路線の駅IDリストを取得
 std::string getStationIdsOfLineAsJson(int lineId) {
     std::vector<int> stationIds = RouteUtility::getStationIdsOfLine(lineId);
-    std::string json = "[";
-    for (size_t i = 0; i < stationIds.size(); i++) {
-        json += std::to_string(stationIds[i]);
-        if (i < stationIds.size() - 1) json += ",";
-    }
-    json += "]";
-    return json;
+    return JsonWriter::Reuse().values(stationIds).str();
 }
 
 // 路線のジャンクション駅IDリストを取得
 std::string getJunctionIdsOfLineAsJson(int lineId, int stationId) {
     std::vector<int> junctionIds = RouteUtility::getJunctionIdsOfLine(lineId, stationId);
-    std::string json = "[";
-    for (size_t i = 0; i < junctionIds.size(); i++) {
-        json += std::to_string(junctionIds[i]);
-        if (i < junctionIds.size() - 1) json += ",";
-    }
-    json += "]";
-    return json;
+    return JsonWriter::Reuse().values(junctionIds).str();
 }
 
 // キーワード検索で駅を取得
 std::string keyMatchStationsAsJson(const std::string& key) {
     std::vector<int> stationIds = RouteUtility::keyMatchStations(key);
-    std::string json = "[";
-    for (size_t i = 0; i < stationIds.size(); i++) {
-        json += std::to_string(stationIds[i]);
-        if (i < stationIds.size() - 1) json += ",";
-    }
-    json += "]";
-    return json;
+    return JsonWriter::Reuse().values(stationIds).str();
+}
+
+// キーワード検索で駅を取得(最大limit件. 0以下は全件)
+std::string keyMatchStationsWithLimitAsJson(const std::string& key, int limit) {
+    std::vector<int> stationIds = RouteUtility::keyMatchStations(key, limit);
+    return JsonWriter::Reuse().values(stationIds).str();
+}
+
+// あいまい検索で駅を取得(ローマ字・半角カナ・打ち間違い可. 一致度順に最大limit件)
+std::string fuzzyMatchStationsAsJson(const std::string& key, int limit) {
+    std::vector<int> stationIds = RouteUtility::fuzzyMatchStations(key, limit);
+    return JsonWriter::Reuse().values(stationIds).str();
 }
 
 // 会社・都道府県の路線を取得
 std::string linesFromCompanyOrPrefectAsJson(int id) {
     std::vector<int> lineIds = RouteUtility::linesFromCompanyOrPrefect(id);
-    std::string json = "[";
-    for (size_t i = 0; i < lineIds.size(); i++) {
-        json += std::to_string(lineIds[i]);
-        if (i < lineIds.size() - 1) json += ",";
+    return JsonWriter::Reuse().values(lineIds).str();
+}
+
+// 1発駅→全駅の最短経路運賃(駅IDを添字とする密な配列, 対象外・到達不可は-1)
+std::string faresFromStationAsJson(int stationId, int useBulletTrain, int companyOrPrefectId) {
+    std::vector<int> fares = RouteUtility::fareOfAllStations(stationId, useBulletTrain, companyOrPrefectId);
+    return JsonWriter::Reuse().values(fares).str();
+}
+
+// 到達圏検索(営業キロ・運賃の上限以内で行ける駅, 0以下は制限なし)
+std::string reachableStationsAsJson(int stationId, int useBulletTrain, int maxSalesKm, int maxFare) {
+    std::vector<RouteUtility::ReachableStationData> reach = RouteUtility::reachableStations(stationId, useBulletTrain, maxSalesKm, maxFare);
+    JsonWriter& json = JsonWriter::Reuse();
+    json.beginArray();
+    for (size_t i = 0; i < reach.size(); i++) {
+        json.beginObject();
+        json.member("stationId", reach[i].stationId);
+        json.member("salesKm", reach[i].salesKm);
+        json.member("fare", reach[i].fare);
+        json.member("route", reach[i].route);
+        json.endObject();
     }
-    json += "]";
-    return json;
+    json.endArray();
+    return json.str();
+}
+
+// 駅間の最短距離(0.1km単位, salesKm: 0:計算キロ 1:営業キロ, 到達不可は-1)
+int getShortestDistance(int stationId1, int stationId2, int salesKm, int useBulletTrain) {
+    return RouteUtility::shortestDistance(stationId1, stationId2, salesKm != 0, useBulletTrain);
+}
+
+// 整数配列をInt32Arrayで返す
+static emscripten::val int32ArrayOf(const std::vector<int>& results) {
+    emscripten::val view(emscripten::typed_memory_view(results.size(), results.data()));
+    return emscripten::val::global("Int32Array").new_(view);   // WASMメモリのビューではなく複製を返す
+}
+
+// 運賃一括計算(経路ごとに [状態, 運賃, 小児運賃, IC運賃, 営業キロ, 有効日数] のInt32Array)
+//  改行区切りの経路文字列("東京 東海道線 品川\n...")
+emscripten::val getFaresOfRouteScripts(const std::string& scripts) {
+    return int32ArrayOf(RouteUtility::fareBatchOfScripts(scripts));
+}
+
+// [0, 発駅, 路線, 駅, ..., 0, 発駅, ...] の数値配列(Int32Arrayまたは配列)
+emscripten::val getFaresOfPackedRoutes(const emscripten::val& packed) {
+    return int32ArrayOf(RouteUtility::fareBatchOfPacked(emscripten::convertJSArrayToNumberVector<int>(packed)));
+}
+
+// 消費税率ごとの運賃一括計算(経路ごとに taxes の順で [状態, 運賃, ...] を taxes.length 組)
+//  taxes: 消費税率(%)の数値配列 (例: [5, 8, 10])
+emscripten::val getFaresOfRouteScriptsByTax(const std::string& scripts, const emscripten::val& taxes) {
+    return int32ArrayOf(RouteUtility::fareBatchOfScripts(scripts, emscripten::convertJSArrayToNumberVector<int>(taxes)));
+}
+
+emscripten::val getFaresOfPackedRoutesByTax(const emscripten::val& packed, const emscripten::val& taxes) {
+    return int32ArrayOf(RouteUtility::fareBatchOfPacked(emscripten::convertJSArrayToNumberVector<int>(packed),
+                                                        emscripten::convertJSArrayToNumberVector<int>(taxes)));
+}
+
+// 名前の一括取得 {bytes: Uint8Array(UTF-8), offsets: Int32Array(ids.length + 1)}
+//  kind: 0:駅名, 1:駅名(同名駅区別付き), 2:路線名, 3:駅のよみ, 4:駅の都道府県名
+//  名前iは bytes の [offsets[i], offsets[i+1]). kind不正は空の bytes / offsets
+emscripten::val getNamesOfIds(int kind, const emscripten::val& ids) {
+    static std::string names;       // 呼び出しをまたいで確保済みの領域を使い回す
+    static std::vector<int> offsets;
+    emscripten::val result = emscripten::val::object();
+    
+    RouteUtility::namesOfIds(kind, emscripten::convertJSArrayToNumberVector<int>(ids), names, offsets);
+    emscripten::val bytes(emscripten::typed_memory_view(names.size(), reinterpret_cast<const uint8_t*>(names.data())));
+    result.set("bytes", emscripten::val::global("Uint8Array").new_(bytes));   // 複製を返す
+    result.set("offsets", int32ArrayOf(offsets));
+    return result;
+}
+
+// 名前からidの一括取得(getNamesOfIds()の逆. 見つからない名前は0)
+//  kind: 0, 1:駅名(同名駅区別付き), 2:路線名, bytes: UTF-8のUint8Array, offsets: 名前の数 + 1 個
+emscripten::val getIdsOfNames(int kind, const emscripten::val& bytes, const emscripten::val& offsets) {
+    std::string names(bytes["length"].as<size_t>(), '\0');
+    
+    emscripten::val(emscripten::typed_memory_view(names.size(), reinterpret_cast<uint8_t*>(&names[0]))).call<void>("set", bytes);
+    return int32ArrayOf(RouteUtility::idsOfNames(kind, names, emscripten::convertJSArrayToNumberVector<int>(offsets)));
 }
 
 // ===== 拡張API: 詳細情報取得関数 =====
@@ -349,61 +613,172 @@ std::string getCompanyOrPrefectName(int id) {
 // 会社・都道府県データ取得（JSON形式）
 std::string getCompanyAndPrefectsAsJson() {
     RouteUtility::CompanyPrefectData data = RouteUtility::getCompanyAndPrefects();
-    std::string json = "{";
-    json += "\"companies\":[";
+    JsonWriter& json = JsonWriter::Reuse();
+    json.beginObject();
+    json.key("companies").beginArray();
     for (size_t i = 0; i < data.companies.size(); i++) {
-        json += "{\"id\":" + std::to_string(data.companies[i].first) + 
-                ",\"name\":\"" + data.companies[i].second + "\"}";
-        if (i < data.companies.size() - 1) json += ",";
+        json.beginObject();
+        json.member("id", data.companies[i].first);
+        json.member("name", data.companies[i].second);
+        json.endObject();
     }
-    json += "],\"prefects\":[";
+    json.endArray();
+    json.key("prefects").beginArray();
     for (size_t i = 0; i < data.prefects.size(); i++) {
-        json += "{\"id\":" + std::to_string(data.prefects[i].first) + 
-                ",\"name\":\"" + data.prefects[i].second + "\"}";
-        if (i < data.prefects.size() - 1) json += ",";
+        json.beginObject();
+        json.member("id", data.prefects[i].first);
+        json.member("name", data.prefects[i].second);
+        json.endObject();
     }
-    json += "]}";
-    return json;
+    json.endArray();
+    json.endObject();
+    return json.str();
 }
 
 // ===== 拡張API: 高度な経路操作関数 =====
 
 // 経路をJSON形式で取得
 std::string getCurrentRouteAsJson() {
-    if (!g_route) return "[]";
+    RouteWrapper* route = currentRoute();
+    if (!route) return "[]";
     
-    std::string json = "[";
-    int count = g_route->getRouteCount();
+    JsonWriter& json = JsonWriter::Reuse();
+    int count = route->getRouteCount();
     
     // 実際の経路データを取得（この部分は RouteWrapper の実装に依存）
     // 簡易実装として、始点と終点の情報のみ返す
-    int startId = g_route->startStationId();
-    int lastId = g_route->lastStationId();
+    int startId = route->startStationId();
+    int lastId = route->lastStationId();
     
+    json.beginArray();
     if (startId > 0) {
-        json += std::to_string(startId);
+        json.value(startId);
         if (lastId > 0 && lastId != startId) {
-            json += "," + std::to_string(lastId);
+            json.value(lastId);
         }
     }
-    
-    json += "]";
-    return json;
+    json.endArray();
+    return json.str();
 }
 
 // 経路の詳細情報を取得
 std::string getRouteDetailsAsJson() {
-    if (!g_route) return "{}";
+    RouteWrapper* route = currentRoute();
+    if (!route) return "{}";
     
-    std::string json = "{";
-    json += "\"stationCount\":" + std::to_string(g_route->getRouteCount()) + ",";
-    json += "\"startStationId\":" + std::to_string(g_route->startStationId()) + ",";
-    json += "\"lastStationId\":" + std::to_string(g_route->lastStationId()) + ",";
-    json += "\"isEnd\":" + std::string(g_route->isEnd() ? "true" : "false");
-    json += "}";
+    JsonWriter& json = JsonWriter::Reuse();
+    json.beginObject();
+    json.member("stationCount", route->getRouteCount());
+    json.member("startStationId", route->startStationId());
+    json.member("lastStationId", route->lastStationId());
+    json.member("isEnd", route->isEnd());
+    json.endObject();
+    return json.str();
+}
+
+// 最短経路で着駅まで延長(useBulletTrain: 0:在来線のみ, 1:新幹線, 2:会社線, 3:両方, 100:地方交通線を除く)
+int farert_auto_route(int useBulletTrain, int arriveStationId) {
+    RouteWrapper* route = currentRoute();
+    if (!route) return -1;
+    return route->autoRoute(useBulletTrain, arriveStationId);
+}
+
+// キャッシュの統計 {hits, misses, size, capacity} のJSONを書き始める(項目を足して endObject() で閉じる)
+static JsonWriter& beginCacheStatsJson(const RouteUtility::RouteCacheStats& stats) {
+    JsonWriter& json = JsonWriter::Reuse();
+    json.beginObject();
+    json.member("hits", stats.hits);
+    json.member("misses", stats.misses);
+    json.member("size", stats.size);
+    json.member("capacity", stats.capacity);
     return json;
 }
 
+// 最短経路木キャッシュの統計
+std::string getRouteCacheStatsAsJson() {
+    return beginCacheStatsJson(RouteUtility::getRouteCacheStats()).endObject().str();
+}
+
+// 最短経路木キャッシュの件数上限(0でキャッシュしない)
+void setRouteCacheCapacity(int capacity) {
+    RouteUtility::setRouteCacheCapacity(capacity);
+}
+
+// 運賃計算結果キャッシュの統計 {hits, misses, size, capacity}
+std::string getFareCacheStatsAsJson() {
+    return beginCacheStatsJson(RouteUtility::getFareCacheStats()).endObject().str();
+}
+
+// 運賃計算結果キャッシュの件数上限(0でキャッシュしない)
+void setFareCacheCapacity(int capacity) {
+    RouteUtility::setFareCacheCapacity(capacity);
+}
+
+// 区間集計値の再利用の統計 {hits:再利用した区間数, misses:集計した区間数, size:保持経路数, capacity}
+std::string getFareAggregateStatsAsJson() {
+    return beginCacheStatsJson(RouteUtility::getFareAggregateStats()).endObject().str();
+}
+
+// 区間集計値を保持する経路数の上限(0で保持しない)
+void setFareAggregateCapacity(int capacity) {
+    RouteUtility::setFareAggregateCapacity(capacity);
+}
+
+// 近郊区間の代替経路の運賃計算結果キャッシュの統計 {hits, misses, size, capacity, pruned:下限で省いた数}
+std::string getOptimizeRouteCacheStatsAsJson() {
+    JsonWriter& json = beginCacheStatsJson(RouteUtility::getOptimizeRouteCacheStats());
+    json.member("pruned", RouteUtility::getOptimizeRoutePrunedCount());
+    return json.endObject().str();
+}
+
+// 近郊区間の代替経路の運賃計算結果キャッシュの件数上限(0でキャッシュしない)
+void setOptimizeRouteCacheCapacity(int capacity) {
+    RouteUtility::setOptimizeRouteCacheCapacity(capacity);
+}
+
+#ifdef FARERT_SELFTEST
+// 運賃カーネル(キロ程→運賃の表)と参照実装の全キロ程比較(不一致の数)
+int verifyFareKernel(int tax) {
+    return RouteUtility::verifyFareKernel(tax);
+}
+
+// かな判定・カナ→かな変換(駅名検索の前処理)と参照実装の比較(不一致の数)
+int verifyKanaUtf8() {
+    return RouteUtility::verifyKanaUtf8();
+}
+#endif
+
+// キロ程(0.1km単位)の配列→運賃の配列(Int32Array). kind: 0:幹線 1:地方交通線 2:東京電車特定区間 3:大阪電車特定区間
+//  4:山手線内 5:大阪環状線内 6:JR北海道幹線 7:JR北海道地方交通線 8:JR四国 9:JR九州
+emscripten::val getFaresOfKm(int kind, const emscripten::val& km) {
+    return int32ArrayOf(RouteUtility::fareOfKmArray(kind, emscripten::convertJSArrayToNumberVector<int>(km)));
+}
+
+// 条件付き経路探索(現在の経路の発駅から着駅まで. 経路は探索結果で置き換える)
+//  via: 経由の順序付きリスト "駅ID,L路線ID,..." (例: "1234,L56")
+//  avoidLines: 通らない路線IDの配列, avoidCompanies: 通らない会社IDの配列(1〜31. 範囲外は-1001)
+int searchRouteWithConstraints(int arriveStationId, const std::string& via, const emscripten::val& avoidLines,
+                               const emscripten::val& avoidCompanies, int useBulletTrain) {
+    RouteWrapper* route = currentRoute();
+    if (!route) return -1;
+    
+    std::vector<std::pair<int, int>> viaList;
+    size_t pos = 0;
+    while (pos < via.size()) {
+        size_t next = via.find(',', pos);
+        std::string token = via.substr(pos, (next == std::string::npos) ? std::string::npos : next - pos);
+        if (!token.empty() && (token[0] == 'L' || token[0] == 'l')) {
+            viaList.push_back(std::make_pair(0, atoi(token.c_str() + 1)));
+        } else if (!token.empty()) {
+            viaList.push_back(std::make_pair(atoi(token.c_str()), 0));
+        }
+        pos = (next == std::string::npos) ? via.size() : next + 1;
+    }
+    return route->searchRoute(arriveStationId, viaList,
+                              emscripten::convertJSArrayToNumberVector<int>(avoidLines),
+                              emscripten::convertJSArrayToNumberVector<int>(avoidCompanies), useBulletTrain);
+}
+
 // データベースバージョン取得
 int getDatabaseVersionNumber() {
     return RouteUtility::getDatabaseId();
@@ -445,7 +820,16 @@ EMSCRIPTEN_BINDINGS(farert_module) {
     emscripten::function("getStationIdsOfLine", &getStationIdsOfLineAsJson);
     emscripten::function("getJunctionIdsOfLine", &getJunctionIdsOfLineAsJson);
     emscripten::function("searchStationsByKeyword", &keyMatchStationsAsJson);
+    emscripten::function("searchStationsByKeywordWithLimit", &keyMatchStationsWithLimitAsJson);
+    emscripten::function("searchStationsFuzzy", &fuzzyMatchStationsAsJson);
     emscripten::function("getLinesFromCompanyOrPrefect", &linesFromCompanyOrPrefectAsJson);
+    emscripten::function("getFaresFromStation", &faresFromStationAsJson);
+    emscripten::function("getReachableStations", &reachableStationsAsJson);
+    emscripten::function("getShortestDistance", &getShortestDistance);
+    emscripten::function("getFaresOfRouteScripts", &getFaresOfRouteScripts);
+    emscripten::function("getFaresOfPackedRoutes", &getFaresOfPackedRoutes);
+    emscripten::function("getFaresOfRouteScriptsByTax", &getFaresOfRouteScriptsByTax);
+    emscripten::function("getFaresOfPackedRoutesByTax", &getFaresOfPackedRoutesByTax);
     
     // ===== 拡張API: 詳細情報取得 =====
     emscripten::function("getStationKana", &getStationKana);
@@ -454,12 +838,55 @@ EMSCRIPTEN_BINDINGS(farert_module) {
     emscripten::function("getTerminalStationName", &getTerminalStationName);
     emscripten::function("getCompanyOrPrefectName", &getCompanyOrPrefectName);
     emscripten::function("getCompanyAndPrefects", &getCompanyAndPrefectsAsJson);
+    emscripten::function("getNamesOfIds", &getNamesOfIds);
+    emscripten::function("getIdsOfNames", &getIdsOfNames);
     emscripten::function("getDatabaseVersion", &getDatabaseVersionNumber);
     
     // ===== 拡張API: 高度な経路操作 =====
     emscripten::function("getCurrentRoute", &getCurrentRouteAsJson);
     emscripten::function("getRouteDetails", &getRouteDetailsAsJson);
+    emscripten::function("autoRoute", &farert_auto_route);
+    emscripten::function("searchRoute", &searchRouteWithConstraints);
+    emscripten::function("getRouteCacheStats", &getRouteCacheStatsAsJson);
+    emscripten::function("setRouteCacheCapacity", &setRouteCacheCapacity);
+    emscripten::function("getFareCacheStats", &getFareCacheStatsAsJson);
+    emscripten::function("setFareCacheCapacity", &setFareCacheCapacity);
+    emscripten::function("getFareAggregateStats", &getFareAggregateStatsAsJson);
+    emscripten::function("setFareAggregateCapacity", &setFareAggregateCapacity);
+    emscripten::function("getOptimizeRouteCacheStats", &getOptimizeRouteCacheStatsAsJson);
+    emscripten::function("setOptimizeRouteCacheCapacity", &setOptimizeRouteCacheCapacity);
+#ifdef FARERT_SELFTEST
+    emscripten::function("verifyFareKernel", &verifyFareKernel);
+    emscripten::function("verifyKanaUtf8", &verifyKanaUtf8);
+#endif
+    emscripten::function("getFaresOfKm", &getFaresOfKm);
     
     // ===== 拡張API: 運賃詳細情報 =====
     emscripten::function("getFareInfoJson", &getFareInfoJson);
+    emscripten::function("getFareInfoJsonWithMask", &getFareInfoJsonWithMask);
+    emscripten::function("getFareResultPointer", &getFareResultPointer);
+    emscripten::function("getFareResultLayout", &getFareResultLayout);
+    
+    // ===== 経路セッション(ハンドル)API =====
+    emscripten::function("routeCreate", &route_create);
+    emscripten::function("routeDestroy", &route_destroy);
+    emscripten::function("routeAddStation", &route_add_station);
+    emscripten::function("routeAddRoute", &route_add_route);
+    emscripten::function("routeRemoveTail", &route_remove_tail);
+    emscripten::function("routeRemoveAll", &route_remove_all);
+    emscripten::function("routeReverse", &route_reverse);
+    emscripten::function("routeGetCount", &route_get_count);
+    emscripten::function("routeStartStationId", &route_start_station_id);
+    emscripten::function("routeLastStationId", &route_last_station_id);
+    emscripten::function("routeIsEnd", &route_is_end);
+    emscripten::function("routeAutoRoute", &route_auto_route);
+    emscripten::function("routeSetup", &route_setup);
+    emscripten::function("routeCalculateFare", &route_calculate_fare);
+    emscripten::function("routeGetFareString", &route_get_fare_string);
+    emscripten::function("routeGetFareInfoJson", &route_get_fare_info_json);
+    emscripten::function("routeGetFareResultPointer", &route_get_fare_result_pointer);
+    emscripten::function("routeSetLongRoute", &route_set_long_route);
+    emscripten::function("routeSetStartAsCity", &route_set_start_as_city);
+    emscripten::function("routeSetArriveAsCity", &route_set_arrive_as_city);
+    emscripten::function("getRouteSessionStats", &getRouteSessionStatsAsJson);
 }
\ No newline at end of file
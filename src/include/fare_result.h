@@ -0,0 +1,110 @@
+#ifndef FARE_RESULT_H
+#define FARE_RESULT_H
+
+/*!	@file fare_result 運賃計算結果のバイナリ表現(CalcRouteWrapper::calcFareBinary()).
+ *	FareInfoData(calcFare()のJSON)の整数・フラグと文字列を、int32_tの並び(wasmのリニアメモリ)に書く.
+ *	JSは HEAP32 / HEAPU8 を直接読む(直列化・JSON.parse()なし).
+ *	JSのアクセサ(src/js/fare_result.js)は getFareResultLayout() で得るこの表から作る.
+ *	項目名はcalcFare()のJSONのキーと同じ. 要求しなかった項目(FARE_OUT_xxx)は0.
+ *
+ *	[0]                   FARE_RESULT_VERSION
+ *	[1]                   全体のバイト数(4の倍数)
+ *	[2]                   outputMask
+ *	[3]                   フラグ(FARE_RESULT_FLAG_FIELDS の順にbit0から)
+ *	[4]...                整数(FARE_RESULT_INT_FIELDS の順)
+ *	[FARE_RESULT_W_STRINGS...] 文字列ごとに {先頭からのバイト位置, バイト数}(FARE_RESULT_STRING_FIELDS の順)
+ *	[FARE_RESULT_HEADER_WORDS...] 文字列(UTF-8, 各文字列の後に'\0')
+ *
+ *	項目を足す時は各リストの末尾に追加し、並びや意味を変える時は FARE_RESULT_VERSION を上げる.
+ */
+
+#define FARE_RESULT_VERSION	1
+
+/* 整数 (result: 0:正常, 1:経路未完(片道乗車券は購入不可), -1:計算不可(以降は全て0)) */
+#define FARE_RESULT_INT_FIELDS(X) \
+	X(result) \
+	X(beginStationId) \
+	X(endStationId) \
+	X(totalSalesKm) \
+	X(jrCalcKm) \
+	X(jrSalesKm) \
+	X(companySalesKm) \
+	X(salesKmForHokkaido) \
+	X(calcKmForHokkaido) \
+	X(salesKmForKyusyu) \
+	X(calcKmForKyusyu) \
+	X(salesKmForShikoku) \
+	X(calcKmForShikoku) \
+	X(brtSalesKm) \
+	X(fare) \
+	X(fareForCompanyline) \
+	X(fareForIC) \
+	X(fareForBRT) \
+	X(childFare) \
+	X(academicFare) \
+	X(ticketAvailDays) \
+	X(availCountForFareOfStockDiscount) \
+	X(fareStockDiscount1) \
+	X(fareStockDiscount2) \
+	X(rule114_salesKm) \
+	X(rule114_calcKm) \
+	X(fareStockDiscountR1141) \
+	X(fareStockDiscountR1142)
+
+/* フラグ(最大32) */
+#define FARE_RESULT_FLAG_FIELDS(X) \
+	X(isResultCompanyBeginEnd) \
+	X(isResultCompanyMultipassed) \
+	X(isBeginInCity) \
+	X(isEndInCity) \
+	X(isBRTdiscount) \
+	X(isRoundtrip) \
+	X(isRoundtripDiscount) \
+	X(isRule114Applied) \
+	X(isMeihanCityStartTerminalEnable) \
+	X(isMeihanCityStart) \
+	X(isMeihanCityTerminal) \
+	X(isEnableLongRoute) \
+	X(isLongRoute) \
+	X(isRule115specificTerm) \
+	X(isEnableRule115) \
+	X(isSpecificFare)
+
+/* 文字列 */
+#define FARE_RESULT_STRING_FIELDS(X) \
+	X(routeList) \
+	X(routeListForTOICA) \
+	X(fareStockDiscountTitle1) \
+	X(fareStockDiscountTitle2)
+
+// 語(int32_t)の位置
+enum FareResultWord {
+	FARE_RESULT_W_VERSION,
+	FARE_RESULT_W_SIZE,
+	FARE_RESULT_W_MASK,
+	FARE_RESULT_W_FLAGS,
+#define FARE_RESULT_X(name) FARE_RESULT_W_##name,
+	FARE_RESULT_INT_FIELDS(FARE_RESULT_X)
+#undef FARE_RESULT_X
+	FARE_RESULT_W_STRINGS,
+};
+
+// フラグのbit位置
+enum FareResultFlag {
+#define FARE_RESULT_X(name) FARE_RESULT_F_##name,
+	FARE_RESULT_FLAG_FIELDS(FARE_RESULT_X)
+#undef FARE_RESULT_X
+	FARE_RESULT_FLAG_COUNT
+};
+
+// 文字列の番号(位置は FARE_RESULT_W_STRINGS + 2 * 番号)
+enum FareResultString {
+#define FARE_RESULT_X(name) FARE_RESULT_S_##name,
+	FARE_RESULT_STRING_FIELDS(FARE_RESULT_X)
+#undef FARE_RESULT_X
+	FARE_RESULT_STRING_COUNT
+};
+
+#define FARE_RESULT_HEADER_WORDS	(FARE_RESULT_W_STRINGS + 2 * FARE_RESULT_STRING_COUNT)
+
+#endif // FARE_RESULT_H
@@ -184,6 +184,9 @@ public:
     int addRoute(int lineId, int stationId);
     void removeTail();
     int autoRoute(int useLine, int arriveStationId);
+    int searchRoute(int arriveStationId, const std::vector<std::pair<int, int>>& via,
+                    const std::vector<int>& avoidLines, const std::vector<int>& avoidCompanies,
+                    int useBulletTrain);
     int typeOfPassedLine(int offset);
     int reverseRoute();
     int setupRoute(const std::string& routeString);
@@ -229,6 +232,16 @@ class CalcRouteWrapper {
 private:
     CalcRoute* calcRoute;
     int lastFareResult;  // Store last fare calculation result code
+
+    // 運賃計算結果(経路・経路フラグを変更するまで使い回す)
+    mutable FARE_INFO* fareInfo;        // nullptr: 未計算
+    mutable int fareInfoMask;           // fareInfoを計算した出力項目(FARE_OUT_xxx)
+    mutable std::string fareText;       // showFare()の結果(空: 未生成)
+    std::vector<int32_t> fareBinary;    // calcFareBinary()の結果(fare_result.h)
+
+    FARE_INFO& computedFare(int outputMask) const;
+    void invalidateFare();
+    int fareInfoData(int outputMask, FareInfoData& result);
     
 public:
     CalcRouteWrapper(const RouteWrapper& route);
@@ -241,7 +254,10 @@ public:
     
     // Fare calculation
     std::string calcFare();  // Returns FareInfo as JSON string
+    std::string calcFare(int outputMask);  // Only requested items (FARE_OUT_xxx in alpdb.h)
+    const int32_t* calcFareBinary(int outputMask);  // Same items as calcFare(outputMask) in the fare_result.h layout
     std::string showFare() const;
+    int fareResult();  // 運賃計算のみ(0:正常, 1:経路未完, -1:計算不可). 結果はcalcFare()/showFare()で使い回す
     
     // Options and settings
     bool isEnableLongRoute() const;
@@ -274,6 +290,17 @@ public:
     static std::string getPrefectNameByStation(int stationId);
     static std::string getKanaFromStationId(int stationId);
     
+    // Bulk id <-> name (name i is names[offsets[i], offsets[i+1]), UTF-8)
+    enum NameKind {
+        NAME_STATION,       // 駅名
+        NAME_STATION_EX,    // 駅名(同名駅区別付き)
+        NAME_LINE,          // 路線名
+        NAME_KANA,          // 駅のよみ
+        NAME_PREFECT,       // 駅の都道府県名
+    };
+    static int namesOfIds(int kind, const std::vector<int>& ids, std::string& names, std::vector<int>& offsets);
+    static std::vector<int> idsOfNames(int kind, const std::string& names, const std::vector<int>& offsets);
+    
     // Company and prefecture operations
     struct CompanyPrefectData {
         std::vector<std::pair<int, std::string>> companies;
@@ -281,9 +308,66 @@ public:
     };
     static CompanyPrefectData getCompanyAndPrefects();
     static std::vector<int> keyMatchStations(const std::string& key);
+    static std::vector<int> keyMatchStations(const std::string& key, int limit);  // limit: 最大件数(0以下は全件)
+    static std::vector<int> fuzzyMatchStations(const std::string& key, int limit);      // ローマ字・半角カナ・打ち間違い可. 一致度順
     static std::vector<int> linesFromCompanyOrPrefect(int id);
     static std::vector<int> stationsWithinCompanyOrPrefectAndLine(int companyOrPrefectId, int lineId);
     
+    // One-to-many fare sweep
+    static std::vector<int> fareOfAllStations(int startStationId, int useBulletTrain, int companyOrPrefectId);
+    
+    // Reachability (isochrone) by sales km / fare budget
+    struct ReachableStationData {
+        int stationId;
+        int salesKm;
+        int fare;
+        std::string route;
+    };
+    static std::vector<ReachableStationData> reachableStations(int startStationId, int useBulletTrain, int maxSalesKm, int maxFare);
+    
+    // Shortest-path tree cache (changeNeerest)
+    struct RouteCacheStats {
+        int hits;
+        int misses;
+        int size;
+        int capacity;
+    };
+    static RouteCacheStats getRouteCacheStats();
+    static void setRouteCacheCapacity(int capacity);
+    
+    // Fare result cache (calcFare)
+    static RouteCacheStats getFareCacheStats();
+    static void setFareCacheCapacity(int capacity);
+    
+    // Incremental fare aggregation (per-segment partial sums, hits/misses count segments)
+    static RouteCacheStats getFareAggregateStats();
+    static void setFareAggregateCapacity(int capacity);
+    
+    // Urban-area alternative routes (shortest / no-local / city centre) and lower-bound pruning
+    static RouteCacheStats getOptimizeRouteCacheStats();
+    static int getOptimizeRoutePrunedCount();
+    static void setOptimizeRouteCacheCapacity(int capacity);
+    
+    // Fare kernel tables (km -> fare); reference comparison only in the SELFTEST build
+#ifdef FARERT_SELFTEST
+    static int verifyFareKernel(int tax);
+#endif
+    static std::vector<int> fareOfKmArray(int kind, const std::vector<int>& km, int tax = TAX);
+
+    // UTF-8 kana utilities (station search keys) vs reference implementation (SELFTEST build only)
+#ifdef FARERT_SELFTEST
+    static int verifyKanaUtf8();
+#endif
+    
+    // Station-to-station shortest distance (contraction hierarchy)
+    static int shortestDistance(int stationId1, int stationId2, bool salesKm, int useBulletTrain);
+    
+    // Batch fare calculation (FAREBATCH_RECORD_SIZE ints per route, per tax rate)
+    static std::vector<int> fareBatchOfScripts(const std::string& scripts);
+    static std::vector<int> fareBatchOfScripts(const std::string& scripts, const std::vector<int>& taxes);
+    static std::vector<int> fareBatchOfPacked(const std::vector<int>& packed);
+    static std::vector<int> fareBatchOfPacked(const std::vector<int>& packed, const std::vector<int>& taxes);
+    
     // Station properties
     static std::string getTerminalName(int stationId);
     static bool isJunction(int stationId);
@@ -0,0 +1,88 @@
+// 運賃計算結果のバイナリ(src/include/fare_result.h)のアクセサ
+// (--post-js でモジュールに組み込む. HEAP32 / HEAPU8 はモジュール内の変数)
+//
+//   const r = FarertModule.getFareResult(0x7f);   // getFareInfoJsonWithMask(0x7f) と同じ項目
+//   r.fare, r.childFare, r.isRule114Applied, r.routeList ...
+//   r.words()     // Int32Array (HEAP32 のビュー. 複製しない)
+//   r.toObject()  // JSON.parse(getFareInfoJsonWithMask()) と同じキーのオブジェクト(要求外の項目は0/false/"")
+//   FarertModule.getRouteFareResult(handle, 0x7f) // routeCreate() のハンドルの結果
+//
+// 値は読むたびに HEAP32 から読む. 次の getFareResult() か経路の変更・破棄まで有効
+
+var fareResultLayout = null;
+var FareResultView = null;
+
+// getFareResultLayout() の配置から getter を作る(初回のみ)
+function fareResultClass() {
+  if (FareResultView) {
+    return FareResultView;
+  }
+  var layout = JSON.parse(Module['getFareResultLayout']());
+  var decoder = new TextDecoder('utf-8');
+
+  FareResultView = function (ptr) {
+    this.ptr = ptr;
+  };
+  Object.keys(layout.ints).forEach(function (name) {
+    var word = layout.ints[name];
+    Object.defineProperty(FareResultView.prototype, name, {
+      get: function () { return HEAP32[(this.ptr >> 2) + word]; }
+    });
+  });
+  Object.keys(layout.flags).forEach(function (name) {
+    var bit = layout.flags[name];
+    Object.defineProperty(FareResultView.prototype, name, {
+      get: function () { return ((HEAP32[(this.ptr >> 2) + layout.flagsWord] >>> bit) & 1) !== 0; }
+    });
+  });
+  Object.keys(layout.strings).forEach(function (name) {
+    var word = layout.stringsWord + 2 * layout.strings[name];
+    Object.defineProperty(FareResultView.prototype, name, {
+      get: function () {
+        var base = this.ptr >> 2;
+        var begin = this.ptr + HEAP32[base + word];
+        return decoder.decode(HEAPU8.subarray(begin, begin + HEAP32[base + word + 1]));
+      }
+    });
+  });
+  FareResultView.prototype.version = function () {
+    return HEAP32[this.ptr >> 2];
+  };
+  FareResultView.prototype.words = function () {
+    var base = this.ptr >> 2;
+    return HEAP32.subarray(base, base + (HEAP32[base + layout.sizeWord] >> 2));
+  };
+  FareResultView.prototype.toObject = function () {
+    var obj = {};
+    var self = this;
+    [layout.ints, layout.flags, layout.strings].forEach(function (fields) {
+      Object.keys(fields).forEach(function (name) { obj[name] = self[name]; });
+    });
+    return obj;
+  };
+  fareResultLayout = layout;
+  return FareResultView;
+}
+
+// ポインタ(0: 結果なし)のビュー
+function fareResultAt(ptr) {
+  var View = fareResultClass();
+
+  if (ptr === 0) {
+    return null;
+  }
+  if (HEAP32[ptr >> 2] !== fareResultLayout.version) {
+    throw new Error('fare result version mismatch');
+  }
+  return new View(ptr);
+}
+
+// 運賃計算結果(outputMask: FARE_OUT_xxx の論理和. 省略時は全項目). 経路がなければ null
+Module['getFareResult'] = function (outputMask) {
+  return fareResultAt(Module['getFareResultPointer'](outputMask === undefined ? 0x7f : outputMask));
+};
+
+// 経路セッション(routeCreate()のハンドル)の運賃計算結果. 未計算か無効なハンドルは null
+Module['getRouteFareResult'] = function (handle, outputMask) {
+  return fareResultAt(Module['routeGetFareResultPointer'](handle, outputMask === undefined ? 0x7f : outputMask));
+};
@@ -0,0 +1,77 @@
+#!/usr/bin/env node
+
+/**
+ * Farert WebAssembly Benchmark - 駅間最短距離
+ * 縮約階層インデックス(getShortestDistance)と最短経路探索(autoRoute = changeNeerest)の比較
+ *
+ * Usage: node tests/bench_distance.js [pairs]
+ *        (Node.js用のCommonJSビルド dist/farert_node.js を使う: make node)
+ */
+
+const fs = require('fs');
+const path = require('path');
+
+global.TextEncoder = require('util').TextEncoder;
+global.TextDecoder = require('util').TextDecoder;
+
+async function runBenchmark() {
+    const jsPath = path.join(__dirname, '..', 'dist', 'farert_node.js');
+    if (!fs.existsSync(jsPath)) {
+        console.error('❌ JavaScriptバインディングファイルが見つかりません:', jsPath);
+        console.error('   先にNode.js用ビルドを作成してください: make node');
+        process.exit(1);
+    }
+    const moduleExports = require(jsPath);
+    const moduleFactory = moduleExports.default || moduleExports;
+    const module = await moduleFactory();
+    module.openDatabase();
+
+    const numPairs = parseInt(process.argv[2] || '200', 10);
+    // 全駅から無作為に選ぶ(駅IDは1から連番)
+    const maxId = 4000;
+    const pairs = [];
+    let seed = 1;
+    const random = () => { seed = (seed * 48271) % 2147483647; return seed; };
+    for (let i = 0; i < numPairs; i++) {
+        pairs.push([1 + random() % maxId, 1 + random() % maxId]);
+    }
+
+    console.log('🚀 Farert Distance Benchmark');
+    console.log('==========================================');
+    console.log(`Pairs: ${pairs.length}\n`);
+
+    // 初回はインデックス構築を含む
+    let t0 = process.hrtime.bigint();
+    module.getShortestDistance(pairs[0][0], pairs[0][1], 0, 0);
+    let t1 = process.hrtime.bigint();
+    console.log(`Index build (calc km, 在来線のみ): ${(Number(t1 - t0) / 1e6).toFixed(1)} ms`);
+
+    t0 = process.hrtime.bigint();
+    let reachable = 0;
+    for (const [a, b] of pairs) {
+        if (module.getShortestDistance(a, b, 0, 0) >= 0) reachable++;
+    }
+    t1 = process.hrtime.bigint();
+    const chUs = Number(t1 - t0) / 1e3 / pairs.length;
+    console.log(`getShortestDistance: ${chUs.toFixed(1)} us/query (reachable ${reachable})`);
+
+    module.setRouteCacheCapacity(0);    // 最短経路木キャッシュを使わない
+    t0 = process.hrtime.bigint();
+    for (const [a, b] of pairs) {
+        module.createRoute();
+        if (module.addStation(a) >= 0) {
+            module.autoRoute(0, b);
+        }
+    }
+    module.destroyRoute();
+    t1 = process.hrtime.bigint();
+    module.setRouteCacheCapacity(16);
+    const autoUs = Number(t1 - t0) / 1e3 / pairs.length;
+    console.log(`autoRoute (changeNeerest): ${autoUs.toFixed(1)} us/query`);
+    console.log(`\nSpeedup: x${(autoUs / chUs).toFixed(0)}`);
+}
+
+runBenchmark().catch((error) => {
+    console.error('❌ Benchmark failed:', error.message);
+    process.exit(1);
+});
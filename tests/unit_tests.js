@@ -222,6 +222,18 @@ class FarertTestRunner {
     }
 }
 
+// キャッシュの件数上限を一時的に変えて testFunc を実行する(失敗しても元の上限に戻す)
+// cacheName: 'FareCache' など get<cacheName>Stats() / set<cacheName>Capacity() の名前
+function withCacheCapacity(module, cacheName, capacity, testFunc) {
+    const saved = JSON.parse(module[`get${cacheName}Stats`]()).capacity;
+    module[`set${cacheName}Capacity`](capacity);
+    try {
+        return testFunc();
+    } finally {
+        module[`set${cacheName}Capacity`](saved);
+    }
+}
+
 // テストケースの定義
 function defineTests(testRunner) {
     // データベース管理テスト
@@ -385,6 +397,507 @@ function defineTests(testRunner) {
         module.destroyRoute();
     }, 'fare');
 
+    testRunner.addTest('RouteUtility.getFaresFromStation', (module, assert) => {
+        module.openDatabase();
+        const startId = module.getStationId('東京');
+        const tokyoPrefect = 14 * 65536;    // 東京都 (getCompanyAndPrefects()のID)
+        const fares = JSON.parse(module.getFaresFromStation(startId, 0, tokyoPrefect));
+        assert.isGreaterThan(fares.length, startId, 'Fare array should be indexed by station ID');
+        assert.equals(fares[startId], 0, 'Fare of the start station should be 0');
+        assert.equals(fares[module.getStationId('品川')], 180, '東京-品川 should be 180 yen');
+        assert.equals(fares[module.getStationId('大阪')], -1, 'Stations outside the filter should be -1');
+    }, 'fare');
+
+    testRunner.addTest('CalcRoute.getFareInfoJsonWithMask', (module, assert) => {
+        module.openDatabase();
+        module.createRoute();
+        module.addStation(module.getStationId('東京'));
+        module.autoRoute(0, module.getStationId('名古屋'));
+        module.calculateFare();
+        const full = JSON.parse(module.getFareInfoJson());
+        const adult = JSON.parse(module.getFareInfoJsonWithMask(0));
+        assert.equals(adult.fare, full.fare, 'Adult fare should not depend on the mask');
+        assert.equals(adult.totalSalesKm, full.totalSalesKm, 'Sales km should not depend on the mask');
+        assert.isFalse('childFare' in adult, 'childFare should be omitted');
+        assert.isFalse('routeList' in adult, 'routeList should be omitted');
+        assert.isFalse('fareStockDiscount1' in adult, 'Stock discounts should be omitted');
+        assert.isFalse('isRule114Applied' in adult, 'Rule 114 should be omitted');
+
+        const child = JSON.parse(module.getFareInfoJsonWithMask(0x01 | 0x40));   // 小児運賃・経路文字列
+        assert.equals(child.childFare, full.childFare, 'childFare should match the full result');
+        assert.equals(child.routeList, full.routeList, 'routeList should match the full result');
+        assert.isFalse('academicFare' in child, 'academicFare should be omitted');
+        assert.equals(module.getFareInfoJsonWithMask(0x7f), module.getFareInfoJson(), 'All items should equal getFareInfoJson()');
+        module.destroyRoute();
+    }, 'fare');
+
+    testRunner.addTest('CalcRoute.getFareInfoJsonWithMask shortest route', (module, assert) => {
+        module.openDatabase();
+        module.createRoute();
+        module.addStation(module.getStationId('東京'));
+        module.autoRoute(0, module.getStationId('高麗川'));
+        module.autoRoute(0, module.getStationId('八王子'));   // 近郊区間内の大回り -> 最短経路の運賃
+        module.calculateFare();
+        const full = JSON.parse(module.getFareInfoJson());
+        assert.isTrue(full.routeList.includes('中央東線'), 'The fare should be calculated over the shortest route');
+        const adult = JSON.parse(module.getFareInfoJsonWithMask(0));
+        assert.equals(adult.fare, full.fare, 'Adult fare should not depend on the mask');
+        assert.equals(adult.totalSalesKm, full.totalSalesKm, 'Sales km should be those of the shortest route');
+        assert.isFalse('routeList' in adult, 'routeList should be omitted');
+        const route = JSON.parse(module.getFareInfoJsonWithMask(0x40));   // 経路文字列
+        assert.equals(route.routeList, full.routeList, 'routeList should be the shortest route');
+        assert.isFalse('childFare' in route, 'childFare should be omitted');
+        module.destroyRoute();
+    }, 'fare');
+
+    testRunner.addTest('CalcRoute.getFareInfoJsonWithMask rule114', (module, assert) => {
+        module.openDatabase();
+        module.createRoute();
+        module.addStation(module.getStationId('中三田'));
+        module.autoRoute(0, module.getStationId('伊里'));     // 114条適用
+        module.calculateFare();
+        const masked = JSON.parse(module.getFareInfoJsonWithMask(0x01 | 0x02));   // 小児・学割運賃
+        const full = JSON.parse(module.getFareInfoJson());
+        assert.isTrue(full.isRule114Applied, 'Rule 114 should be applied');
+        assert.equals(masked.childFare, full.childFare, 'childFare should be the fare after rule 114');
+        assert.equals(masked.academicFare, full.academicFare, 'academicFare should be the fare after rule 114');
+        assert.isFalse('isRule114Applied' in masked, 'Rule 114 fields should be omitted');
+        module.destroyRoute();
+    }, 'fare');
+
+    testRunner.addTest('RouteUtility.getReachableStations', (module, assert) => {
+        module.openDatabase();
+        const startId = module.getStationId('東京');
+        const reach = JSON.parse(module.getReachableStations(startId, 0, 20, 0));   // 2.0km以内
+        const ids = reach.map(r => r.stationId);
+        assert.isTrue(ids.includes(module.getStationId('有楽町')), '有楽町 should be within 2.0km');
+        assert.isFalse(ids.includes(startId), 'Start station should not be included');
+        assert.isFalse(ids.includes(module.getStationId('品川')), '品川 should be out of range');
+        reach.forEach(r => {
+            assert.isTrue(r.salesKm <= 20, `${r.route} should be within the budget`);
+            assert.isTrue(r.fare > 0, `${r.route} should have a fare`);
+        });
+        const byFare = JSON.parse(module.getReachableStations(startId, 0, 0, 150));
+        assert.isTrue(byFare.every(r => r.fare <= 150), 'All fares should be within 150 yen');
+    }, 'fare');
+
+    testRunner.addTest('RouteWrapper.searchRoute', (module, assert) => {
+        module.openDatabase();
+        module.createRoute();
+        module.addStation(module.getStationId('東京'));
+        const nagoyaId = module.getStationId('名古屋');
+        const rc = module.searchRoute(nagoyaId, `${module.getStationId('甲府')}`, [], [], 0);
+        assert.isTrue(rc >= 0, 'searchRoute via 甲府 should succeed');
+        assert.equals(module.lastStationId(), nagoyaId, 'Route should arrive at 名古屋');
+        module.calculateFare();
+        assert.isTrue(module.getFareString().includes('中央東線'), 'Route via 甲府 should use 中央東線');
+
+        module.removeAll();
+        module.addStation(module.getStationId('東京'));
+        const ng = module.searchRoute(module.getStationId('大阪'), '', [], [3], 0);   // JR東海を通らない(在来線のみ)
+        assert.equals(ng, -1000, 'No route should be found without JR東海');
+        assert.equals(module.getRouteCount(), 1, 'A failed search should keep the original route');
+        assert.equals(module.searchRoute(module.getStationId('大阪'), '', [], [32], 0), -1001,
+            'Company ID outside the mask should be rejected');
+        assert.equals(module.searchRoute(module.getStationId('大阪'), '', [], [0], 0), -1001,
+            'Company ID 0 should be rejected');
+        module.destroyRoute();
+    }, 'route');
+
+    testRunner.addTest('RouteWrapper.searchRoute detour', (module, assert) => {
+        module.openDatabase();
+        module.createRoute();
+        module.addStation(module.getStationId('旭(土)'));
+        // 昭和町(高徳線)経由: 高松(讃)から予讃線へ折り返すと同じ駅を2度通るので、徳島線・高徳線を迂回する
+        const rc = module.searchRoute(module.getStationId('中萩'), `${module.getStationId('昭和町')}`, [], [], 0);
+        assert.isTrue(rc >= 0, 'searchRoute via 昭和町 should find the detour');
+        assert.equals(module.lastStationId(), module.getStationId('中萩'), 'Route should arrive at 中萩');
+        module.calculateFare();
+        const fare = module.getFareString();
+        assert.isTrue(fare.includes('徳島線') && fare.includes('高徳線'), 'Detour should use 徳島線 and 高徳線');
+        module.destroyRoute();
+    }, 'route');
+
+    testRunner.addTest('RouteWrapper.autoRoute tree cache', (module, assert) => {
+        module.openDatabase();
+        module.createRoute();
+        const tokyoId = module.getStationId('東京');
+        module.addStation(tokyoId);
+        assert.isTrue(module.autoRoute(0, module.getStationId('大阪')) >= 0, 'autoRoute 東京-大阪 should succeed');
+        const first = JSON.parse(module.getRouteCacheStats());
+
+        module.removeAll();
+        module.addStation(tokyoId);
+        assert.isTrue(module.autoRoute(0, module.getStationId('仙台')) >= 0, 'autoRoute 東京-仙台 should succeed');
+        const second = JSON.parse(module.getRouteCacheStats());
+        assert.equals(second.hits, first.hits + 1, 'Same origin should hit the tree cache');
+        assert.isTrue(second.size <= second.capacity, 'Cache size should be bounded');
+        module.destroyRoute();
+    }, 'route');
+
+    testRunner.addTest('RouteUtility.getShortestDistance', (module, assert) => {
+        module.openDatabase();
+        const tokyoId = module.getStationId('東京');
+        const shinagawaId = module.getStationId('品川');
+        assert.equals(module.getShortestDistance(tokyoId, shinagawaId, 1, 0), 68, '東京-品川 should be 6.8km');
+        assert.equals(module.getShortestDistance(shinagawaId, tokyoId, 1, 0), 68, 'Distance should be symmetric');
+        assert.equals(module.getShortestDistance(tokyoId, tokyoId, 0, 0), 0, 'Same station should be 0');
+        assert.equals(module.getShortestDistance(tokyoId, -1, 0, 0), -1, 'Invalid station should be -1');
+    }, 'route');
+
+    testRunner.addTest('RouteUtility.getFaresOfRouteScripts', (module, assert) => {
+        module.openDatabase();
+        // 1経路6要素: [状態, 運賃, 小児運賃, IC運賃, 営業キロ, 有効日数]
+        const r = module.getFaresOfRouteScripts('東京,東海道線,品川\n東京,東海道線,名古屋\n東京,存在しない線,品川');
+        assert.equals(r.length, 18, 'Should return 6 values per route');
+        assert.equals(r[0], 0, 'First route should succeed');
+        assert.equals(r[1], 180, '東京-品川 should be 180 yen');
+        assert.equals(r[4], 68, '東京-品川 should be 6.8km');
+        assert.equals(r[6], 0, 'Second route should succeed');
+        assert.equals(r[7], 6380, '東京-名古屋 should be 6380 yen');
+        assert.isTrue(r[12] < 0, 'Unknown line should return route error');
+
+        const tokyoId = module.getStationId('東京');
+        const shinagawaId = module.getStationId('品川');
+        const lineId = JSON.parse(module.getLineIdsFromStation(tokyoId))
+            .find((id) => module.getLineName(id) === '東海道線');
+        const p = module.getFaresOfPackedRoutes(new Int32Array([0, tokyoId, lineId, shinagawaId, 0, shinagawaId, lineId, tokyoId]));
+        assert.equals(p.length, 12, 'Packed input should return 2 routes');
+        assert.equals(p[1], 180, 'Packed 東京-品川 should be 180 yen');
+        assert.equals(p[7], 180, 'Packed 品川-東京 should be 180 yen');
+
+        // 終端(東京に戻って一周)より後の区間は追加せず経路エラー
+        const tabataId = module.getStationId('田端');
+        const yamanoteId = JSON.parse(module.getLineIdsFromStation(tabataId))
+            .find((id) => module.getLineName(id) === '山手線');
+        const tohokuId = JSON.parse(module.getLineIdsFromStation(tabataId))
+            .find((id) => module.getLineName(id) === '東北線');
+        const loop = [0, tokyoId, lineId, shinagawaId, yamanoteId, tabataId, tohokuId, tokyoId];
+        const q = module.getFaresOfPackedRoutes(new Int32Array([...loop, 0, tokyoId, lineId, shinagawaId, ...loop.slice(2)]));
+        assert.equals(q.length, 12, 'Packed loop input should return 2 routes');
+        assert.equals(q[0], 0, 'Loop ending at the start station should succeed');
+        assert.equals(q[6], -400, 'Segments after the terminal station should be a route error');
+    }, 'route');
+
+    testRunner.addTest('RouteUtility.getFaresOfRouteScriptsByTax', (module, assert) => {
+        module.openDatabase();
+        const scripts = '東京,東海道線,品川\n東京,東海道線,名古屋';
+        const r = module.getFaresOfRouteScriptsByTax(scripts, [10, 8, 5]);
+        assert.equals(r.length, 36, 'Should return 6 values per route per tax');
+        const single = module.getFaresOfRouteScripts(scripts);
+        assert.equals(r[1], single[1], 'Tax 10% should match the default fare');
+        assert.equals(r[19], single[7], 'Tax 10% should match the default fare (2nd route)');
+        assert.isTrue(r[7] < r[1], 'Tax 8% fare should be lower than 10%');
+        assert.isTrue(r[13] <= r[7], 'Tax 5% fare should not exceed 8%');
+        const again = module.getFaresOfRouteScripts(scripts);
+        assert.equals(again[7], single[7], 'Other tax rates should not affect the default fare');
+    }, 'route');
+
+    testRunner.addTest('RouteUtility.getFareCacheStats', (module, assert) => {
+        module.openDatabase();
+        const script = '東京,東海道線,名古屋';
+        const first = module.getFaresOfRouteScripts(script);
+        const before = JSON.parse(module.getFareCacheStats());
+        const second = module.getFaresOfRouteScripts(script);
+        const after = JSON.parse(module.getFareCacheStats());
+        assert.equals(after.hits, before.hits + 1, 'Same route should hit the fare cache');
+        assert.equals(second[1], first[1], 'Cached fare should be the same');
+
+        withCacheCapacity(module, 'FareCache', 0, () => {
+            const uncached = module.getFaresOfRouteScripts(script);
+            assert.equals(uncached[1], first[1], 'Fare without cache should be the same');
+            assert.equals(JSON.parse(module.getFareCacheStats()).size, 0, 'Capacity 0 should empty the cache');
+        });
+    }, 'route');
+
+    testRunner.addTest('RouteUtility.getFareAggregateStats', (module, assert) => {
+        module.openDatabase();
+        withCacheCapacity(module, 'FareCache', 0, () => {
+            // 1区間ずつ延ばした経路と、末尾を削除した経路
+            const scripts = [
+                '東京,東海道線,横浜',
+                '東京,東海道線,横浜,横浜線,八王子',
+                '東京,東海道線,横浜,横浜線,八王子,中央東線,甲府',
+                '東京,東海道線,横浜,横浜線,八王子',
+            ];
+            const before = JSON.parse(module.getFareAggregateStats());
+            const fares = scripts.map((s) => module.getFaresOfRouteScripts(s)[1]);
+            const after = JSON.parse(module.getFareAggregateStats());
+            assert.isTrue(after.hits > before.hits, 'Extended route should reuse aggregated segments');
+
+            withCacheCapacity(module, 'FareAggregate', 0, () => {
+                scripts.forEach((s, i) => {
+                    assert.equals(module.getFaresOfRouteScripts(s)[1], fares[i], `Fare without reuse should be the same: ${s}`);
+                });
+                assert.equals(JSON.parse(module.getFareAggregateStats()).size, 0, 'Capacity 0 should empty the aggregate cache');
+            });
+        });
+    }, 'fare');
+
+    testRunner.addTest('RouteUtility.getOptimizeRouteCacheStats', (module, assert) => {
+        module.openDatabase();
+        withCacheCapacity(module, 'FareCache', 0, () => {
+            // 近郊区間内: 最短経路の運賃を再計算する
+            const script = '東京,中央東線,八王子';
+            const first = module.getFaresOfRouteScripts(script)[1];
+            const before = JSON.parse(module.getOptimizeRouteCacheStats());
+            const second = module.getFaresOfRouteScripts(script)[1];
+            const after = JSON.parse(module.getOptimizeRouteCacheStats());
+            assert.equals(second, first, 'Cached alternative route should give the same fare');
+            assert.isTrue(after.hits > before.hits, 'Same terminals should reuse the alternative route');
+
+            withCacheCapacity(module, 'OptimizeRouteCache', 0, () => {
+                assert.equals(module.getFaresOfRouteScripts(script)[1], first, 'Fare without the cache should be the same');
+                assert.equals(JSON.parse(module.getOptimizeRouteCacheStats()).size, 0, 'Capacity 0 should empty the cache');
+            });
+        });
+    }, 'fare');
+
+    testRunner.addTest('RouteUtility.verifyFareKernel', (module, assert) => {
+        if (typeof module.verifyFareKernel !== 'function') {
+            return;     // make SELFTEST=1 のビルドのみ
+        }
+        module.openDatabase();
+        for (const tax of [10, 8, 5]) {
+            assert.equals(module.verifyFareKernel(tax), 0, `Fare kernel should match reference at tax ${tax}%`);
+        }
+    }, 'fare');
+
+    testRunner.addTest('RouteUtility.getFaresOfKm', (module, assert) => {
+        module.openDatabase();
+        const km = new Int32Array([68, 3660, 0, 50000, 101, 110, 111, 6001]);
+        const fares = module.getFaresOfKm(0, km);
+        assert.equals(fares.length, km.length, 'Should return one fare per km');
+        assert.equals(fares[0], 199, '6.8km basic fare should be 199');
+        assert.equals(fares[1], 6380, '366.0km basic fare should be 6380');
+        for (let i = 0; i < km.length; i++) {
+            assert.equals(fares[i], module.getFaresOfKm(0, [km[i]])[0], `Batch and single fare should match at ${km[i]}`);
+        }
+        assert.equals(module.getFaresOfKm(99, km).length, 0, 'Invalid kind should return empty array');
+    }, 'fare');
+
+    testRunner.addTest('CalcRoute.rule114', (module, assert) => {
+        module.openDatabase();
+        module.createRoute();
+        // 広島市内発 200km超: 広島から200km到達駅(日生)までの運賃を適用
+        module.addStation(module.getStationId('中三田'));
+        module.autoRoute(0, module.getStationId('伊里'));
+        module.calculateFare();
+        const info = JSON.parse(module.getFareInfoJson());
+        assert.isTrue(info.isRule114Applied, 'Rule 114 should be applied');
+        assert.equals(info.fare, 4070, 'fare should be the fare before rule 114');
+        assert.equals(info.rule114_salesKm, 2039, 'Rule 114 sales km should be 203.9km');
+        assert.equals(info.childFare, 1870, 'childFare should be half the fare up to the 200km point');
+        assert.isTrue(module.getFareString().includes('運賃： ¥3,740'), 'Fare should be the fare up to the 200km point');
+        module.destroyRoute();
+    }, 'fare');
+
+    testRunner.addTest('CalcRoute.specificCoreArea', (module, assert) => {
+        module.openDatabase();
+        // 東京都区内発・名古屋市内着(86条): 中心駅間の営業キロ・運賃になる
+        const r = module.getFaresOfRouteScripts('東京,東海道線,名古屋\n品川,東海道線,熱田\n有楽町,東海道線,名古屋');
+        for (let i = 0; i < r.length; i += 6) {
+            assert.equals(r[i], 0, 'Route should be valid');
+            assert.equals(r[i + 1], 6380, 'Fare should be 東京-名古屋');
+            assert.equals(r[i + 4], 3660, 'Sales km should be 東京-名古屋');
+        }
+    }, 'fare');
+
+    testRunner.addTest('CalcRoute.fareResultReuse', (module, assert) => {
+        module.openDatabase();
+        module.createRoute();
+        module.addStation(module.getStationId('東京'));
+        module.autoRoute(0, module.getStationId('名古屋'));
+        assert.equals(module.calculateFare(), 1, 'calculateFare should succeed');
+        const json = module.getFareInfoJson();
+        const text = module.getFareString();
+        assert.equals(module.getFareInfoJson(), json, 'Repeated JSON should be the same');
+        assert.equals(module.getFareString(), text, 'Repeated text should be the same');
+        assert.equals(module.getFareInfoJsonWithMask(0x7f), json, 'Full mask should reuse the result');
+        const adult = JSON.parse(module.getFareInfoJsonWithMask(0));
+        assert.equals(adult.fare, JSON.parse(json).fare, 'Masked fare should match');
+        assert.equals(module.getFareInfoJson(), json, 'JSON after a masked request should be the same');
+        module.destroyRoute();
+    }, 'fare');
+
+    testRunner.addTest('RouteUtility.searchStationsByKeywordWithLimit', (module, assert) => {
+        module.openDatabase();
+        const all = JSON.parse(module.searchStationsByKeyword('しん'));
+        const limited = JSON.parse(module.searchStationsByKeywordWithLimit('しん', 3));
+        assert.isGreaterThan(all.length, 3, 'Should find many stations');
+        assert.equals(limited.length, 3, 'Should return only the limited count');
+        assert.equals(limited.join(','), all.slice(0, 3).join(','), 'Should keep the kana order');
+        assert.equals(module.searchStationsByKeywordWithLimit('シン', 0), module.searchStationsByKeyword('しん'),
+                      'Katakana should match the same as hiragana');
+        assert.isGreaterThan(JSON.parse(module.searchStationsByKeyword('山崎')).length, 1, 'Same name stations');
+        assert.equals(JSON.parse(module.searchStationsByKeyword('山崎(函)')).length, 1, 'Samename should narrow down');
+    }, 'search');
+
+    testRunner.addTest('RouteUtility.searchStationsFuzzy', (module, assert) => {
+        module.openDatabase();
+        const shinjuku = module.getStationId('新宿');
+        const tokyo = module.getStationId('東京');
+        const top = (keyword) => JSON.parse(module.searchStationsFuzzy(keyword, 5))[0];
+        assert.equals(top('shinjuku'), shinjuku, 'Hepburn romaji');
+        assert.equals(top('sinjuku'), shinjuku, 'Kunrei romaji');
+        assert.equals(top('ｼﾝｼﾞｭｸ'), shinjuku, 'Half-width katakana');
+        assert.equals(top('tokyo'), tokyo, 'Romaji without long vowels');
+        assert.equals(top('とうきょう'), tokyo, 'Hiragana');
+        assert.equals(top('新宿'), shinjuku, 'Kanji');
+        const typo = JSON.parse(module.searchStationsFuzzy('ikebukro', 5));
+        assert.equals(typo[0], module.getStationId('池袋'), 'Typo should still match');
+        assert.equals(JSON.parse(module.searchStationsFuzzy('shin', 3)).length, 3, 'Should honour the limit');
+    }, 'search');
+
+    testRunner.addTest('RouteUtility.verifyKanaUtf8', (module, assert) => {
+        module.openDatabase();
+        if (typeof module.verifyKanaUtf8 === 'function') {     // make SELFTEST=1 のビルドのみ
+            assert.equals(module.verifyKanaUtf8(), 0, 'Kana utilities should match the reference implementation');
+        }
+        assert.equals(module.searchStationsByKeyword('シンジュク'), module.searchStationsByKeyword('しんじゅく'),
+                      'Katakana key should be converted to hiragana');
+        assert.equals(module.searchStationsByKeyword('ｼﾝｼﾞｭｸ'), '[]', 'Half-width katakana is not kana');
+    }, 'search');
+
+    testRunner.addTest('RouteUtility.nameTable', (module, assert) => {
+        module.openDatabase();
+        const tokyo = module.getStationId('東京');
+        assert.equals(module.getStationName(tokyo), '東京', 'Station name should round-trip');
+        assert.equals(module.getStationNameExtended(tokyo), '東京', 'Station without samename has the plain name');
+        assert.equals(module.getStationName(-1), '', 'Invalid station ID should return an empty name');
+        assert.equals(module.getLineName(100000), '', 'Invalid line ID should return an empty name');
+        module.createRoute();
+        module.addStation(tokyo);
+        module.autoRoute(0, module.getStationId('名古屋'));
+        assert.equals(module.calculateFare(), 1, 'calculateFare should succeed');
+        assert.isTrue(module.getFareString().startsWith('東京都区内[区] -> 名古屋市内[名]\r\n経由：'),
+                      'Fare text should begin with the city terminal names');
+        module.destroyRoute();
+    }, 'route');
+
+    testRunner.addTest('RouteUtility.getStationIdFromNameTable', (module, assert) => {
+        module.openDatabase();
+        const hakodate = module.getStationId('山崎(函)');
+        const tokaido = module.getStationId('山崎(東)');
+        assert.isGreaterThan(hakodate, 0, 'Station with samename should be found');
+        assert.notEquals(hakodate, tokaido, 'Same-name stations should have different IDs');
+        assert.equals(module.getStationNameExtended(tokaido), '山崎(東)', 'Extended name should round-trip');
+        assert.equals(module.getStationId('山崎'), 0, 'Name without samename should not match');
+        assert.equals(module.getStationId('山崎('), 0, 'Partial samename should not match');
+        assert.equals(module.getStationId('東海道線'), 0, 'Line name should not resolve as a station');
+    }, 'route');
+
+    testRunner.addTest('JsonWriter.exportsAreValidJson', (module, assert) => {
+        module.openDatabase();
+        module.createRoute();
+        module.addStation(module.getStationId('東京'));
+        module.autoRoute(0, module.getStationId('名古屋'));
+        const ids = module.getLineIdsFromStation(module.getStationId('東京'));
+        const fareJson = module.getFareInfoJson();
+        const fare = JSON.parse(fareJson);
+        assert.isString(fare.routeList, 'routeList should be a string');
+        assert.isGreaterThan(fare.routeList.length, 0, 'routeList should not be empty');
+        assert.equals(module.getLineIdsFromStation(module.getStationId('東京')), ids,
+                      'Earlier results should not change when the buffer is reused');
+        assert.equals(module.getFareInfoJson(), fareJson, 'Repeated JSON should be the same');
+        const data = JSON.parse(module.getCompanyAndPrefects());
+        assert.isGreaterThan(data.prefects.length, 0, 'Prefects should be listed');
+        assert.isString(data.prefects[0].name, 'Prefect name should be a string');
+        assert.isNumber(JSON.parse(module.getRouteDetails()).stationCount, 'stationCount should be a number');
+        assert.isNumber(JSON.parse(module.getFareCacheStats()).hits, 'hits should be a number');
+        assert.equals(module.getLineIdsFromStation(-1), '[]', 'Empty array should be []');
+        module.destroyRoute();
+    }, 'fare');
+
+    testRunner.addTest('CalcRoute.getFareResultBinary', (module, assert) => {
+        module.openDatabase();
+        module.createRoute();
+        module.addStation(module.getStationId('東京'));
+        module.autoRoute(0, module.getStationId('名古屋'));
+        assert.equals(module.calculateFare(), 1, 'calculateFare should succeed');
+        const json = JSON.parse(module.getFareInfoJsonWithMask(0x7f));
+        const layout = JSON.parse(module.getFareResultLayout());
+        const view = module.getFareResult(0x7f);
+        assert.equals(view.version(), layout.version, 'Version should match the layout');
+        const obj = view.toObject();
+        Object.keys(json).forEach((key) => {
+            assert.equals(obj[key], json[key], `${key} should match the JSON result`);
+        });
+        assert.equals(view.words()[layout.ints.fare], view.fare, 'words() should be a view of the same record');
+        const adult = module.getFareResult(0);
+        assert.equals(adult.fare, json.fare, 'Adult fare should not depend on the mask');
+        assert.equals(adult.routeList, '', 'Unrequested strings should be empty');
+        assert.equals(adult.childFare, 0, 'Unrequested fares should be 0');
+        module.destroyRoute();
+    }, 'fare');
+
+    testRunner.addTest('RouteSession.handles', (module, assert) => {
+        module.openDatabase();
+        const a = module.routeCreate();
+        const b = module.routeCreate();
+        assert.isGreaterThan(a, 0, 'routeCreate should return a handle');
+        assert.notEquals(a, b, 'Handles should differ');
+        assert.isGreaterThanOrEqual(module.routeSetup(a, '東京,東海道線,名古屋'), 0, 'routeSetup should succeed');
+        assert.isGreaterThanOrEqual(module.routeSetup(b, '東京,東北線,仙台'), 0, 'routeSetup should succeed');
+        assert.equals(module.routeCalculateFare(a), 1, 'routeCalculateFare should succeed');
+        assert.equals(module.routeCalculateFare(b), 1, 'routeCalculateFare should succeed');
+        const fareA = JSON.parse(module.routeGetFareInfoJson(a, 0x7f)).fare;
+        const fareB = JSON.parse(module.routeGetFareInfoJson(b, 0x7f)).fare;
+        assert.notEquals(fareA, fareB, 'Each session should keep its own route');
+        assert.equals(module.getRouteFareResult(b).fare, fareB, 'Binary result should match the session');
+
+        // createRoute()系の経路とは独立
+        module.createRoute();
+        module.addStation(module.getStationId('東京'));
+        module.autoRoute(0, module.getStationId('名古屋'));
+        assert.equals(module.calculateFare(), 1, 'calculateFare should succeed');
+        assert.equals(JSON.parse(module.getFareInfoJsonWithMask(0x7f)).fare, fareA, 'Same route should give the same fare');
+        module.destroyRoute();
+        assert.equals(JSON.parse(module.routeGetFareInfoJson(b, 0x7f)).fare, fareB, 'destroyRoute should not affect sessions');
+
+        assert.equals(module.routeDestroy(a), 1, 'routeDestroy should succeed');
+        assert.equals(module.routeDestroy(a), 0, 'Destroyed handle should be invalid');
+        assert.equals(module.routeAddStation(a, module.getStationId('東京')), -1, 'Destroyed handle should not add stations');
+        assert.equals(module.routeGetFareInfoJson(a, 0x7f), '{}', 'Destroyed handle should have no fare');
+        const c = module.routeCreate();
+        assert.notEquals(c, a, 'Recycled session should get a new handle');
+        assert.equals(module.routeGetCount(c), 0, 'Recycled session should be empty');
+        assert.equals(module.routeGetFareInfoJson(c, 0x7f), '{}', 'Recycled session should not keep the old fare');
+        module.routeDestroy(b);
+        module.routeDestroy(c);
+    }, 'route');
+
+    testRunner.addTest('RouteUtility.bulkNamesAndIds', (module, assert) => {
+        module.openDatabase();
+        const stationIds = ['東京', '品川', '名古屋', '山崎(函)'].map((name) => module.getStationId(name));
+        const ids = Int32Array.from([...stationIds, -1]);
+        const decoder = new TextDecoder();
+        const namesOf = (packed, count) => Array.from({ length: count },
+            (_, i) => decoder.decode(packed.bytes.subarray(packed.offsets[i], packed.offsets[i + 1])));
+
+        const names = module.getNamesOfIds(0, ids);
+        assert.equals(names.offsets.length, ids.length + 1, 'offsets should have ids.length + 1 entries');
+        namesOf(names, ids.length).forEach((name, i) => {
+            assert.equals(name, module.getStationName(ids[i]), `Station name ${i} should match getStationName`);
+        });
+        namesOf(module.getNamesOfIds(3, ids), ids.length).forEach((name, i) => {
+            assert.equals(name, module.getStationKana(ids[i]), `Kana ${i} should match getStationKana`);
+        });
+        namesOf(module.getNamesOfIds(4, ids), ids.length).forEach((name, i) => {
+            assert.equals(name, module.getStationPrefecture(ids[i]), `Prefecture ${i} should match getStationPrefecture`);
+        });
+
+        const exNames = module.getNamesOfIds(1, ids);
+        const back = module.getIdsOfNames(1, exNames.bytes, exNames.offsets);
+        assert.equals(Array.from(back).join(','), [...stationIds, 0].join(','), 'Names should map back to the same ids');
+
+        const lineIds = Int32Array.from({ length: 30 }, (_, i) => i + 1).filter((id) => module.getLineName(id) !== '');
+        const lines = module.getNamesOfIds(2, lineIds);
+        assert.equals(Array.from(module.getIdsOfNames(2, lines.bytes, lines.offsets)).join(','),
+                      Array.from(lineIds).join(','), 'Line names should map back to the same ids');
+        assert.equals(module.getNamesOfIds(9, ids).offsets.length, 0, 'Invalid kind should return empty offsets');
+    }, 'utility');
+
     // デバッグ・ユーティリティテスト
     testRunner.addTest('Debug.debugStations', (module, assert) => {
         const result = module.debugStations();